@@ -68,6 +68,16 @@ void kore_error_free(kore_error *);
  *
  * The returned binary data in *data_out has length *size_out, and should be
  * freed with free(*data_out) when it is no longer required.
+ *
+ * Batched functions instead take a pair of caller-allocated arrays with one
+ * entry per input:
+ *
+ *   char   ** data_out
+ *   size_t  * sizes_out
+ *
+ * and write the i-th result to data_out[i] and sizes_out[i]; each of the
+ * buffers should be freed in the same way. If an error occurs, no buffers are
+ * returned and every entry of data_out is set to NULL.
  */
 
 /* Opaque types */
@@ -129,6 +139,36 @@ void kore_simplify(
 void kore_simplify_binary(
     kore_error *, char *, size_t, kore_sort const *, char **, size_t *);
 
+/*
+ * Batched versions of kore_simplify and kore_simplify_binary for simplifying
+ * many terms of the same sort at once.
+ */
+void kore_simplify_batch(
+    kore_error *err, kore_pattern const *const *patterns, size_t count,
+    kore_sort const *sort, char **data_out, size_t *sizes_out);
+
+void kore_simplify_binary_batch(
+    kore_error *err, char *const *data_in, size_t const *sizes_in,
+    size_t count, kore_sort const *sort, char **data_out, size_t *sizes_out);
+
+/*
+ * Evaluate a batch of function calls, each of which is a composite pattern
+ * whose constructor is a function symbol. Each result is returned in the same
+ * form as kore_simplify, at the return sort of the function.
+ */
+void kore_evaluate_function_batch(
+    kore_error *err, kore_pattern const *const *calls, size_t count,
+    char **data_out, size_t *sizes_out);
+
+/*
+ * Evaluate count calls to the function symbol with this label (e.g.
+ * Lblfoo{}), with binary KORE arguments laid out call by call: the j-th
+ * argument of the i-th call is data_in[i * arity + j].
+ */
+void kore_evaluate_function_binary_batch(
+    kore_error *err, char const *label, char *const *data_in,
+    size_t const *sizes_in, size_t count, char **data_out, size_t *sizes_out);
+
 block *take_steps(int64_t depth, block *term);
 
 /* kore_sort */
@@ -165,10 +205,15 @@ bool kllvm_mutable_bytes_enabled(void);
 /* Definitions */
 
 /**
- * Parse the given KORE definition, then if any of its axioms have a `label`
- * attribute that matches the supplied label, return the name of the function
- * symbol that attempts matching a pattern against that axiom (and will
- * therefore populate the backend's global matching log).
+ * If any of the axioms in the given KORE definition have a `label` attribute
+ * that matches the supplied label, return the name of the function symbol
+ * that attempts matching a pattern against that axiom (and will therefore
+ * populate the backend's global matching log).
+ *
+ * The definition's labels are read from a `definition.index` file next to it
+ * if one was generated at kompile time, or by parsing the definition
+ * otherwise. Either way, they are cached after the first call for each
+ * definition path, so subsequent lookups are cheap.
  *
  * If no such axiom exists, return `nullptr`.
  */
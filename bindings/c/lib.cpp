@@ -8,12 +8,15 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <optional>
+#include <stdexcept>
 #include <unistd.h>
+#include <vector>
 
 // These headers need to be included last because they pollute a number of macro
 // definitions into the global namespace.
@@ -39,6 +42,8 @@ struct pretty_print_definition {
 
 std::optional<pretty_print_definition> get_print_data();
 
+void free_batch_outputs(char **data_out, size_t count);
+
 /*
  * Any intermediate objects that are created in bindings functions and not
  * returned to the caller should be allocated using `managed`; there should be
@@ -332,6 +337,101 @@ void kore_simplify_binary(
   }
 }
 
+void kore_simplify_batch(
+    kore_error *err, kore_pattern const *const *patterns, size_t count,
+    kore_sort const *sort, char **data_out, size_t *sizes_out) {
+  try {
+    std::fill_n(data_out, count, nullptr);
+
+    auto pats = std::vector<std::shared_ptr<kllvm::kore_pattern>>{};
+    pats.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      pats.push_back(patterns[i]->ptr);
+    }
+
+    kllvm::bindings::simplify_batch(pats, sort->ptr, data_out, sizes_out);
+  } catch (std::exception &e) {
+    free_batch_outputs(data_out, count);
+
+    if (err == nullptr) {
+      throw;
+    }
+
+    err->set_error(e.what());
+  }
+}
+
+void kore_simplify_binary_batch(
+    kore_error *err, char *const *data_in, size_t const *sizes_in,
+    size_t count, kore_sort const *sort, char **data_out, size_t *sizes_out) {
+  try {
+    std::fill_n(data_out, count, nullptr);
+
+    auto sort_str = std::unique_ptr<char, decltype(std::free) *>(
+        kore_sort_dump(sort), std::free);
+
+    kllvm::bindings::simplify_binary_batch(
+        data_in, sizes_in, count, sort_str.get(), data_out, sizes_out);
+  } catch (std::exception &e) {
+    free_batch_outputs(data_out, count);
+
+    if (err == nullptr) {
+      throw;
+    }
+
+    err->set_error(e.what());
+  }
+}
+
+void kore_evaluate_function_batch(
+    kore_error *err, kore_pattern const *const *calls, size_t count,
+    char **data_out, size_t *sizes_out) {
+  try {
+    std::fill_n(data_out, count, nullptr);
+
+    auto terms = std::vector<std::shared_ptr<kllvm::kore_composite_pattern>>{};
+    terms.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      auto call = std::dynamic_pointer_cast<kllvm::kore_composite_pattern>(
+          calls[i]->ptr);
+      if (!call) {
+        throw std::invalid_argument(
+            "function call in batch is not a composite pattern");
+      }
+      terms.push_back(std::move(call));
+    }
+
+    kllvm::bindings::evaluate_function_batch(terms, data_out, sizes_out);
+  } catch (std::exception &e) {
+    free_batch_outputs(data_out, count);
+
+    if (err == nullptr) {
+      throw;
+    }
+
+    err->set_error(e.what());
+  }
+}
+
+void kore_evaluate_function_binary_batch(
+    kore_error *err, char const *label, char *const *data_in,
+    size_t const *sizes_in, size_t count, char **data_out, size_t *sizes_out) {
+  try {
+    std::fill_n(data_out, count, nullptr);
+
+    kllvm::bindings::evaluate_function_binary_batch(
+        label, data_in, sizes_in, count, data_out, sizes_out);
+  } catch (std::exception &e) {
+    free_batch_outputs(data_out, count);
+
+    if (err == nullptr) {
+      throw;
+    }
+
+    err->set_error(e.what());
+  }
+}
+
 /* kore_composite_pattern */
 
 kore_pattern *kore_composite_pattern_new(char const *name) {
@@ -474,6 +574,13 @@ kore_pattern *kore_pattern_new_token_internal(
   return pat;
 }
 
+void free_batch_outputs(char **data_out, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    free(data_out[i]);
+    data_out[i] = nullptr;
+  }
+}
+
 std::optional<pretty_print_definition> get_print_data() {
   if (kore_definition_macros_len == -1 || kore_definition_macros == 0
       || kore_definition_syntax_len == -1 || kore_definition_syntax == 0) {
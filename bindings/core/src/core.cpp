@@ -1,8 +1,16 @@
+#include <kllvm/ast/definition_index.h>
 #include <kllvm/bindings/core/core.h>
 #include <kllvm/parser/KOREParser.h>
 
+#include <filesystem>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
 using namespace kllvm;
 
+namespace fs = std::filesystem;
+
 /*
  * These declarations are internal to the backend and aren't exposed explicitly
  * through any header files, so we pull them in manually here.
@@ -101,6 +109,123 @@ evaluate_function(std::shared_ptr<kore_composite_pattern> const &term) {
   return sorted_term_to_kore_pattern(static_cast<block *>(result), return_sort);
 }
 
+namespace {
+
+/*
+ * Serialize a term of the given sort to binary KORE in the same shape that
+ * sorted_term_to_kore_pattern would produce, but without deserializing the
+ * result back into an AST.
+ */
+void serialize_sorted_term(
+    block *term, char const *sort, bool is_kitem, char **data_out,
+    size_t *size_out) {
+  auto *kitem = is_kitem ? term : construct_raw_term(term, sort, false);
+  serialize_configuration(
+      kitem, "SortKItem{}", data_out, size_out, true, true);
+}
+
+} // namespace
+
+void simplify_batch(
+    std::vector<std::shared_ptr<kore_pattern>> const &patterns,
+    std::shared_ptr<kore_sort> const &sort, char **data_out,
+    size_t *sizes_out) {
+  auto kitem_sort = kore_composite_sort::create("SortKItem");
+  auto needs_raw_term = !is_sort_kitem(sort) && !is_sort_k(sort);
+
+  for (size_t i = 0; i < patterns.size(); ++i) {
+    auto *term = construct_term(
+        needs_raw_term ? make_raw_term(patterns[i], sort, kitem_sort)
+                       : patterns[i]);
+
+    serialize_configuration(
+        term, "SortKItem{}", &data_out[i], &sizes_out[i], true, true);
+  }
+}
+
+void simplify_binary_batch(
+    char *const *data_in, size_t const *sizes_in, size_t count,
+    char const *sort, char **data_out, size_t *sizes_out) {
+  for (size_t i = 0; i < count; ++i) {
+    auto *term = deserialize_configuration(data_in[i], sizes_in[i]);
+    serialize_configuration(
+        term, sort, &data_out[i], &sizes_out[i], true, true);
+  }
+}
+
+void evaluate_function_batch(
+    std::vector<std::shared_ptr<kore_composite_pattern>> const &terms,
+    char **data_out, size_t *sizes_out) {
+  struct symbol_info {
+    uint32_t tag;
+    char const *return_sort;
+    bool returns_kitem;
+  };
+
+  // Calls in a batch are usually to a small number of distinct functions, so
+  // only print and look up each one in the runtime's symbol table once. A
+  // symbol without sort parameters is identified by its name alone, which
+  // can be looked up without printing it; the printed form of a parametric
+  // symbol contains braces, so the two kinds of key cannot collide.
+  auto symbols = std::unordered_map<std::string, symbol_info>{};
+  auto term_args = std::vector<void *>{};
+
+  for (size_t i = 0; i < terms.size(); ++i) {
+    auto const &symbol = *terms[i]->get_constructor();
+    auto is_parametric = !symbol.get_formal_arguments().empty();
+    auto key = is_parametric ? ast_to_string(symbol) : std::string{};
+    auto const &name = is_parametric ? key : symbol.get_name();
+
+    auto it = symbols.find(name);
+    if (it == symbols.end()) {
+      auto label = is_parametric ? key : ast_to_string(symbol);
+      auto tag = get_tag_for_symbol_name(label.c_str());
+      auto const *return_sort = get_return_sort_for_tag(tag);
+      it = symbols
+               .emplace(
+                   name, symbol_info{
+                             tag, return_sort,
+                             std::string_view(return_sort) == "SortKItem{}"})
+               .first;
+    }
+
+    auto const &info = it->second;
+
+    term_args.clear();
+    for (auto const &arg : terms[i]->get_arguments()) {
+      term_args.push_back(static_cast<void *>(construct_term(arg)));
+    }
+
+    auto *result = evaluate_function_symbol(info.tag, term_args.data());
+    serialize_sorted_term(
+        static_cast<block *>(result), info.return_sort, info.returns_kitem,
+        &data_out[i], &sizes_out[i]);
+  }
+}
+
+void evaluate_function_binary_batch(
+    std::string const &label, char *const *data_in, size_t const *sizes_in,
+    size_t count, char **data_out, size_t *sizes_out) {
+  auto tag = get_tag_for_symbol_name(label.c_str());
+  auto arity = get_symbol_arity(tag);
+  auto const *return_sort = get_return_sort_for_tag(tag);
+  auto returns_kitem = std::string_view(return_sort) == "SortKItem{}";
+
+  auto term_args = std::vector<void *>(arity);
+
+  for (size_t i = 0; i < count; ++i) {
+    for (size_t j = 0; j < arity; ++j) {
+      auto idx = (i * arity) + j;
+      term_args[j] = deserialize_configuration(data_in[idx], sizes_in[idx]);
+    }
+
+    auto *result = evaluate_function_symbol(tag, term_args.data());
+    serialize_sorted_term(
+        static_cast<block *>(result), return_sort, returns_kitem, &data_out[i],
+        &sizes_out[i]);
+  }
+}
+
 bool is_sort_kitem(std::shared_ptr<kore_sort> const &sort) {
   if (auto composite = std::dynamic_pointer_cast<kore_composite_sort>(sort)) {
     return composite->get_name() == "SortKItem";
@@ -117,22 +242,53 @@ bool is_sort_k(std::shared_ptr<kore_sort> const &sort) {
   return false;
 }
 
+definition_index const &
+get_definition_index(std::string const &definition_path) {
+  static auto mutex = std::mutex{};
+  static auto cache
+      = std::unordered_map<std::string, std::unique_ptr<definition_index>>{};
+
+  auto lock = std::lock_guard(mutex);
+
+  if (auto it = cache.find(definition_path); it != cache.end()) {
+    return *it->second;
+  }
+
+  // Prefer an index generated at kompile time, but only if it is at least as
+  // new as the definition it describes. Otherwise, fall back to parsing the
+  // definition once and indexing it in memory.
+  auto index_path
+      = fs::path(definition_path).parent_path() / "definition.index";
+
+  auto ec = std::error_code{};
+  auto index_time = fs::last_write_time(index_path, ec);
+  auto use_index = !ec;
+  if (use_index) {
+    auto definition_time = fs::last_write_time(definition_path, ec);
+    use_index = !ec && index_time >= definition_time;
+  }
+
+  auto index = std::unique_ptr<definition_index>{};
+  if (use_index) {
+    index = std::make_unique<definition_index>(
+        definition_index::load(index_path.string()));
+  } else {
+    parser::kore_parser parser(definition_path);
+    auto kore_ast = parser.definition(true);
+    kore_ast->preprocess();
+    index = std::make_unique<definition_index>(
+        definition_index::build(*kore_ast));
+  }
+
+  return *cache.emplace(definition_path, std::move(index)).first->second;
+}
+
 std::optional<std::string> get_match_function_name(
     std::string const &definition_path, std::string const &label) {
-  // Parse the definition.kore to get the AST.
-  parser::kore_parser parser(definition_path);
-  auto kore_ast = parser.definition();
-  kore_ast->preprocess();
-
-  // Iterate through axioms and return the one with the give rulen label if exits.
-  for (auto *axiom : kore_ast.get()->get_axioms()) {
-    // Check if the current axiom has the attribute label.
-    if (axiom->attributes().contains(attribute_set::key::Label)) {
-      // Compare the axiom's label with the given rule label.
-      if (label == axiom->attributes().get_string(attribute_set::key::Label)) {
-        return "intern_match_" + std::to_string(axiom->get_ordinal());
-      }
-    }
+  auto const &index = get_definition_index(definition_path);
+
+  if (auto ordinal = index.get_ordinal_for_label(label)) {
+    return "intern_match_" + std::to_string(*ordinal);
   }
 
   return std::nullopt;
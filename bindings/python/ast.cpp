@@ -210,7 +210,7 @@ void bind_ast(py::module_ &m) {
 
   py::class_<kore_definition, std::shared_ptr<kore_definition>>(
       ast, "Definition")
-      .def(py::init(&kore_definition::create))
+      .def(py::init([]() { return kore_definition::create(); }))
       .def("__repr__", print_repr_adapter<kore_definition>())
       .def("add_module", &kore_definition::add_module)
       .def_property_readonly("modules", &kore_definition::get_modules)
@@ -356,12 +356,15 @@ void bind_ast(py::module_ &m) {
 
   py::class_<kore_variable_pattern, std::shared_ptr<kore_variable_pattern>>(
       ast, "VariablePattern", pattern_base)
-      .def(py::init(&kore_variable_pattern::create))
+      .def(py::init(
+          py::overload_cast<std::string const &, std::shared_ptr<kore_sort>>(
+              &kore_variable_pattern::create)))
       .def_property_readonly("name", &kore_variable_pattern::get_name);
 
   py::class_<kore_string_pattern, std::shared_ptr<kore_string_pattern>>(
       ast, "StringPattern", pattern_base)
-      .def(py::init(&kore_string_pattern::create))
+      .def(py::init(py::overload_cast<std::string const &>(
+          &kore_string_pattern::create)))
       .def_property_readonly("contents", [](kore_string_pattern &pattern) {
         return py::bytes(pattern.get_contents());
       });
@@ -4,6 +4,9 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <cstdlib>
+#include <vector>
+
 // This header needs to be included last because it pollutes a number of macro
 // definitions into the global namespace.
 #include <runtime/header.h>
@@ -46,6 +49,37 @@ block *take_steps(int64_t, block *);
 void *construct_initial_configuration(kore_pattern const *initial);
 }
 
+/*
+ * Run a batched function that writes count malloc-allocated binary KORE
+ * buffers, and copy them into Python bytes objects, releasing the original
+ * buffers. If the function throws, the buffers it already wrote are released
+ * before the exception propagates.
+ */
+template <typename F>
+static std::vector<py::bytes> run_binary_batch(size_t count, F &&batch) {
+  auto data = std::vector<char *>(count, nullptr);
+  auto sizes = std::vector<size_t>(count);
+
+  try {
+    batch(data.data(), sizes.data());
+  } catch (...) {
+    for (auto *buffer : data) {
+      free(buffer);
+    }
+    throw;
+  }
+
+  auto results = std::vector<py::bytes>{};
+  results.reserve(count);
+
+  for (size_t i = 0; i < count; ++i) {
+    results.emplace_back(data[i], sizes[i]);
+    free(data[i]);
+  }
+
+  return results;
+}
+
 void bind_runtime(py::module_ &m) {
   auto runtime = m.def_submodule("runtime", "K LLVM backend runtime");
 
@@ -59,6 +93,28 @@ void bind_runtime(py::module_ &m) {
 
   m.def("evaluate_function", bindings::evaluate_function);
 
+  // The batched entry points return each result as size-prefixed binary KORE
+  // rather than as a Pattern; use Pattern.deserialize to read them back if
+  // needed.
+  m.def(
+      "simplify_pattern_batch",
+      [](std::vector<std::shared_ptr<kore_pattern>> const &patterns,
+         std::shared_ptr<kore_sort> const &sort) {
+        return run_binary_batch(
+            patterns.size(), [&](char **data, size_t *sizes) {
+              bindings::simplify_batch(patterns, sort, data, sizes);
+            });
+      });
+
+  m.def(
+      "evaluate_function_batch",
+      [](std::vector<std::shared_ptr<kore_composite_pattern>> const &calls) {
+        return run_binary_batch(
+            calls.size(), [&](char **data, size_t *sizes) {
+              bindings::evaluate_function_batch(calls, data, sizes);
+            });
+      });
+
   m.def("init_static_objects", init_static_objects);
   m.def("free_all_gc_memory", free_all_kore_mem);
 
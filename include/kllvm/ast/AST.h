@@ -1,6 +1,7 @@
 #ifndef AST_H
 #define AST_H
 
+#include <kllvm/ast/arena.h>
 #include <kllvm/ast/attribute_set.h>
 
 #include <boost/container_hash/extensions.hpp>
@@ -25,6 +26,7 @@
 namespace kllvm {
 
 class serializer;
+class stream_dictionary;
 
 class kore_sort_variable;
 
@@ -117,6 +119,8 @@ public:
   std::string const &get_name() const { return name_; }
 
 private:
+  friend class ast_arena;
+
   kore_sort_variable(std::string name)
       : name_(std::move(name)) { }
 };
@@ -188,6 +192,8 @@ public:
   }
 
 private:
+  friend class ast_arena;
+
   kore_composite_sort(std::string name, value_type category)
       : name_(std::move(name))
       , category_(category) { }
@@ -471,6 +477,14 @@ public:
     return ptr<kore_variable_pattern>(
         new kore_variable_pattern(std::move(var), std::move(sort)));
   }
+  static sptr<kore_variable_pattern>
+  create(std::string const &name, sptr<kore_sort> sort, ast_arena *arena) {
+    if (!arena) {
+      return create(name, std::move(sort));
+    }
+    return arena->make<kore_variable_pattern>(
+        kore_variable::create(name), std::move(sort));
+  }
 
   std::string get_name() const;
   sptr<kore_sort> get_sort() const override { return sort_; }
@@ -529,6 +543,8 @@ private:
     return shared_from_this();
   }
 
+  friend class ast_arena;
+
   kore_variable_pattern(ptr<kore_variable> name, sptr<kore_sort> sort)
       : name_(std::move(name))
       , sort_(std::move(std::move(sort))) { }
@@ -557,6 +573,23 @@ public:
     return ptr<kore_composite_pattern>(
         new kore_composite_pattern(std::move(new_sym)));
   }
+  static sptr<kore_composite_pattern>
+  create(ptr<kore_symbol> sym, ast_arena *arena) {
+    if (!arena) {
+      return create(std::move(sym));
+    }
+    return arena->make<kore_composite_pattern>(std::move(sym));
+  }
+  static sptr<kore_composite_pattern>
+  create(std::string const &name, ast_arena *arena) {
+    return create(kore_symbol::create(name), arena);
+  }
+  static sptr<kore_composite_pattern>
+  create(kore_symbol *sym, ast_arena *arena) {
+    ptr<kore_symbol> new_sym = kore_symbol::create(sym->get_name());
+    *new_sym = *sym;
+    return create(std::move(new_sym), arena);
+  }
 
   sptr<kore_sort> get_sort() const override {
     if (constructor_->get_name() == "\\dv"
@@ -610,6 +643,8 @@ private:
   friend void ::kllvm::deallocate_s_ptr_kore_pattern(
       sptr<kore_pattern> pattern);
 
+  friend class ast_arena;
+
   kore_composite_pattern(ptr<kore_symbol> constructor)
       : constructor_(std::move(constructor)) { }
 };
@@ -622,6 +657,13 @@ public:
   static ptr<kore_string_pattern> create(std::string const &contents) {
     return ptr<kore_string_pattern>(new kore_string_pattern(contents));
   }
+  static sptr<kore_string_pattern>
+  create(std::string const &contents, ast_arena *arena) {
+    if (!arena) {
+      return create(contents);
+    }
+    return arena->make<kore_string_pattern>(contents);
+  }
 
   std::string get_contents() { return contents_; }
 
@@ -676,6 +718,8 @@ private:
     return shared_from_this();
   }
 
+  friend class ast_arena;
+
   kore_string_pattern(std::string contents)
       : contents_(std::move(contents)) { }
 };
@@ -901,6 +945,11 @@ public:
   using KOREAxiomMapType = std::map<size_t, kore_axiom_declaration *>;
 
 private:
+  /* When the definition is built in arena mode, this arena owns its patterns
+     and sorts. It is declared first so that it is destroyed only after every
+     other member has released its references to arena nodes. */
+  std::unique_ptr<ast_arena> arena_;
+
   // Symbol tables
   kore_sortConstructorMapType object_sort_constructors_;
   kore_symbolMapType object_symbols_;
@@ -935,10 +984,18 @@ private:
   void insert_reserved_symbols();
 
 public:
-  static ptr<kore_definition> create() {
-    return std::make_unique<kore_definition>();
+  static ptr<kore_definition> create(bool use_arena = false) {
+    auto result = std::make_unique<kore_definition>();
+    if (use_arena) {
+      result->arena_ = std::make_unique<ast_arena>();
+    }
+    return result;
   }
 
+  /* Returns the arena that owns the nodes of this definition, or nullptr if it
+     was not created in arena mode. */
+  [[nodiscard]] ast_arena *get_arena() const { return arena_.get(); }
+
   /* Preprocesses the definition and prepares it for translation to llvm.
      This performs the following tasks:
      * removes axioms for which isRequired() returns false
@@ -0,0 +1,176 @@
+#ifndef AST_ARENA_H
+#define AST_ARENA_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace kllvm {
+
+class kore_sort;
+class kore_composite_sort;
+class kore_sort_variable;
+
+/*
+ * A bump allocator that owns the nodes of a KORE AST built in arena mode by the
+ * parser or the binary deserializer.
+ *
+ * Nodes allocated through make() are still handed out as shared pointers so
+ * that they can be used everywhere a heap-allocated node can, but both the
+ * node and its control block live in the arena. Destroying a node only runs
+ * its destructor; the memory itself is released wholesale when the arena is
+ * destroyed. Consequently, no node allocated here may outlive its arena.
+ *
+ * The arena also hash-conses sorts, so that every structurally distinct sort
+ * is represented by exactly one node. Names are not shared between nodes:
+ * each node still owns a copy of its name, and the symbols and variables held
+ * by patterns are allocated on the heap as usual. Only the pattern and sort
+ * nodes themselves live in the arena.
+ *
+ * An arena is not thread-safe.
+ */
+class ast_arena {
+public:
+  ast_arena() = default;
+  ~ast_arena() = default;
+
+  ast_arena(ast_arena const &) = delete;
+  ast_arena(ast_arena &&) = delete;
+  ast_arena &operator=(ast_arena const &) = delete;
+  ast_arena &operator=(ast_arena &&) = delete;
+
+  /*
+   * Allocate uninitialized storage with the given size and alignment. The
+   * storage is valid until the arena is destroyed.
+   */
+  void *allocate(size_t size, size_t align);
+
+  /*
+   * A standard allocator that draws from an arena and never frees; used to
+   * place shared_ptr control blocks next to the nodes they manage.
+   */
+  template <typename T>
+  class allocator {
+  public:
+    using value_type = T;
+
+    explicit allocator(ast_arena *arena) noexcept
+        : arena_(arena) { }
+
+    template <typename U>
+    allocator(allocator<U> const &other) noexcept
+        : arena_(other.arena_) { }
+
+    T *allocate(size_t n) {
+      return static_cast<T *>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *, size_t) noexcept { }
+
+    template <typename U>
+    bool operator==(allocator<U> const &other) const noexcept {
+      return arena_ == other.arena_;
+    }
+
+    template <typename U>
+    bool operator!=(allocator<U> const &other) const noexcept {
+      return arena_ != other.arena_;
+    }
+
+  private:
+    template <typename U>
+    friend class allocator;
+
+    ast_arena *arena_;
+  };
+
+  /*
+   * Construct a node of type T in the arena. AST node classes with private
+   * constructors befriend ast_arena so that this can be used in place of their
+   * public create() functions.
+   */
+  template <typename T, typename... Args>
+  std::shared_ptr<T> make(Args &&...args);
+
+  /*
+   * Return a view of a copy of str owned by this arena; equal strings always
+   * produce views of the same storage. This is used to key the sort tables
+   * below by identity; the nodes themselves do not refer to this storage.
+   */
+  std::string_view intern(std::string_view str);
+
+  /*
+   * Return the unique composite sort with this name and these arguments,
+   * creating it if it does not exist yet. Arguments are compared by identity,
+   * so they should themselves have been produced by this arena for sharing to
+   * be maximal.
+   */
+  std::shared_ptr<kore_composite_sort> composite_sort(
+      std::string_view name,
+      std::vector<std::shared_ptr<kore_sort>> const &arguments);
+
+  /*
+   * Return the unique sort variable with this name.
+   */
+  std::shared_ptr<kore_sort_variable> sort_variable(std::string_view name);
+
+  [[nodiscard]] size_t bytes_allocated() const { return bytes_allocated_; }
+  [[nodiscard]] size_t num_sorts() const {
+    return composite_sorts_.size() + sort_variables_.size();
+  }
+
+private:
+  static constexpr size_t block_size = size_t{1} << 16;
+
+  struct sort_key {
+    std::string_view name;
+    std::vector<kore_sort *> arguments;
+
+    bool operator==(sort_key const &other) const {
+      return name.data() == other.name.data() && arguments == other.arguments;
+    }
+  };
+
+  struct hash_sort_key {
+    size_t operator()(sort_key const &key) const noexcept {
+      auto hash = std::hash<void const *>{}(key.name.data());
+      for (auto *arg : key.arguments) {
+        hash = hash * 31 + std::hash<void const *>{}(arg);
+      }
+      return hash;
+    }
+  };
+
+  // The blocks must be declared first so that they are released only after
+  // the tables below have dropped their references to arena nodes.
+  std::vector<std::unique_ptr<std::byte[]>> blocks_;
+  std::byte *next_ = nullptr;
+  std::byte *end_ = nullptr;
+  size_t bytes_allocated_ = 0;
+
+  std::unordered_set<std::string_view> strings_;
+  std::unordered_map<
+      sort_key, std::shared_ptr<kore_composite_sort>, hash_sort_key>
+      composite_sorts_;
+  std::unordered_map<std::string_view, std::shared_ptr<kore_sort_variable>>
+      sort_variables_;
+};
+
+template <typename T, typename... Args>
+std::shared_ptr<T> ast_arena::make(Args &&...args) {
+  auto *node
+      = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+  return std::shared_ptr<T>(
+      node, [](T *node) { node->~T(); }, allocator<T>(this));
+}
+
+} // namespace kllvm
+
+#endif
@@ -60,6 +60,7 @@ public:
     Nat,
     NonExecutable,
     Ordinal,
+    Parallel,
     Priorities,
     Priority,
     Right,
@@ -0,0 +1,73 @@
+#ifndef DEFINITION_INDEX_H
+#define DEFINITION_INDEX_H
+
+#include <kllvm/ast/AST.h>
+
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace kllvm {
+
+/*
+ * A compact summary of the metadata that tools and language bindings most
+ * often need from a compiled definition, so that they do not have to parse and
+ * preprocess the whole of definition.kore to get at it:
+ *
+ *   - the ordinal of each axiom with a `label` attribute, and
+ *   - the tag of each concrete symbol, keyed by its printed KORE form.
+ *
+ * The index is written at kompile time by llvm-kompile-codegen when passed
+ * --definition-index, conventionally to `definition.index` in the kompiled
+ * directory. The on-disk format is:
+ *
+ *   "\x7fKDI" | u32 version | u32 num_labels | u32 num_symbols
+ *   num_labels  x (u32 length | label bytes  | u64 ordinal)
+ *   num_symbols x (u32 length | symbol bytes | u32 tag)
+ *
+ * with all integers in host byte order, as for the rich binary KORE header.
+ */
+class definition_index {
+public:
+  static constexpr uint32_t version = 1;
+
+  /*
+   * Build an index from a definition that has already been preprocessed. If
+   * several axioms share a label, the first one in definition order wins.
+   */
+  static definition_index build(kore_definition const &definition);
+
+  /*
+   * Read an index previously produced by write(); throws std::runtime_error if
+   * the file is malformed or has an incompatible version.
+   */
+  static definition_index load(std::string const &path);
+
+  void write(std::ostream &os) const;
+  void write(std::string const &path) const;
+
+  [[nodiscard]] std::optional<uint64_t>
+  get_ordinal_for_label(std::string const &label) const;
+
+  [[nodiscard]] std::optional<uint32_t>
+  get_tag_for_symbol(std::string const &symbol) const;
+
+  [[nodiscard]] std::unordered_map<std::string, uint64_t> const &
+  get_label_ordinals() const {
+    return label_ordinals_;
+  }
+  [[nodiscard]] std::unordered_map<std::string, uint32_t> const &
+  get_symbol_tags() const {
+    return symbol_tags_;
+  }
+
+private:
+  std::unordered_map<std::string, uint64_t> label_ordinals_;
+  std::unordered_map<std::string, uint32_t> symbol_tags_;
+};
+
+} // namespace kllvm
+
+#endif
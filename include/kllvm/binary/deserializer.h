@@ -291,8 +291,15 @@ uint64_t read_length(It &ptr, It end, binary_version version, int v1_bytes) {
   return ret;
 }
 
+/*
+ * Strings encoded with reference to a stream dictionary (version 1.3.0 and
+ * newer) can only be read if that dictionary is passed in; see
+ * stream_dictionary in serializer.h.
+ */
 template <typename It>
-std::string read_string(It &ptr, It end, binary_version version) {
+std::string read_string(
+    It &ptr, It end, binary_version version,
+    stream_dictionary *dictionary = nullptr) {
   switch (uint8_t(peek(ptr))) {
 
   case 0x01: {
@@ -313,15 +320,42 @@ std::string read_string(It &ptr, It end, binary_version version) {
     return {(char *)&*begin, (char *)(&*begin + len)};
   }
 
+  case 0x03: {
+    ++ptr;
+    auto len = read_length(ptr, end, version, 4);
+    auto ret = std::string((char *)&*ptr, (char *)(&*ptr + len));
+
+    if (dictionary) {
+      dictionary->add(ret);
+    }
+
+    ptr += len;
+    return ret;
+  }
+
+  case 0x04: {
+    ++ptr;
+    auto index = read_length(ptr, end, version, 4);
+
+    if (!dictionary) {
+      throw std::runtime_error(
+          "Binary KORE stream dictionary reference outside of a stream");
+    }
+
+    return dictionary->at(index);
+  }
+
   default: throw std::runtime_error("Internal parsing exception");
   }
 }
 
 template <typename It>
-sptr<kore_variable> read_variable(It &ptr, It end, binary_version version) {
+sptr<kore_variable> read_variable(
+    It &ptr, It end, binary_version version,
+    stream_dictionary *dictionary = nullptr) {
   if (peek(ptr) == header_byte<kore_variable>) {
     ++ptr;
-    return kore_variable::create(read_string(ptr, end, version));
+    return kore_variable::create(read_string(ptr, end, version, dictionary));
   }
 
   return nullptr;
@@ -330,10 +364,10 @@ sptr<kore_variable> read_variable(It &ptr, It end, binary_version version) {
 template <typename It>
 ptr<kore_symbol> read_symbol(
     It &ptr, It end, std::vector<sptr<kore_sort>> &sort_stack,
-    binary_version version) {
+    binary_version version, stream_dictionary *dictionary = nullptr) {
   auto arity = read_length(ptr, end, version, 2);
 
-  auto name = read_string(ptr, end, version);
+  auto name = read_string(ptr, end, version, dictionary);
   auto symbol = kore_symbol::create(name);
 
   auto start_idx = sort_stack.size() - arity;
@@ -351,12 +385,23 @@ ptr<kore_symbol> read_symbol(
 template <typename It>
 sptr<kore_sort> read_composite_sort(
     It &ptr, It end, std::vector<sptr<kore_sort>> &sort_stack,
-    binary_version version) {
+    binary_version version, ast_arena *arena = nullptr,
+    stream_dictionary *dictionary = nullptr) {
   auto arity = read_length(ptr, end, version, 2);
-  auto new_sort = kore_composite_sort::create(read_string(ptr, end, version));
+  auto name = read_string(ptr, end, version, dictionary);
+
+  auto start_idx = sort_stack.size() - arity;
+  auto new_sort = sptr<kore_composite_sort>{};
 
-  for (auto i = sort_stack.size() - arity; i < sort_stack.size(); ++i) {
-    new_sort->add_argument(sort_stack[i]);
+  if (arena) {
+    auto args = std::vector<sptr<kore_sort>>(
+        sort_stack.begin() + start_idx, sort_stack.end());
+    new_sort = arena->composite_sort(name, args);
+  } else {
+    new_sort = kore_composite_sort::create(name);
+    for (auto i = start_idx; i < sort_stack.size(); ++i) {
+      new_sort->add_argument(sort_stack[i]);
+    }
   }
 
   for (auto i = 0; i < arity; ++i) {
@@ -366,8 +411,15 @@ sptr<kore_sort> read_composite_sort(
   return new_sort;
 }
 
+/*
+ * If arena is non-null, the patterns and sorts of the result are allocated in
+ * it (see kllvm/ast/arena.h); otherwise they are individually heap-allocated.
+ * If the pattern is part of a stream, its dictionary must be passed in.
+ */
 template <typename It>
-sptr<kore_pattern> read(It &ptr, It end, binary_version version) {
+sptr<kore_pattern> read(
+    It &ptr, It end, binary_version version, ast_arena *arena = nullptr,
+    stream_dictionary *dictionary = nullptr) {
   auto term_stack = std::vector<sptr<kore_pattern>>{};
   auto sort_stack = std::vector<sptr<kore_sort>>{};
   auto symbol = kllvm::ptr<kore_symbol>{};
@@ -378,12 +430,14 @@ sptr<kore_pattern> read(It &ptr, It end, binary_version version) {
     case header_byte<kore_string_pattern>:
       ++ptr;
       term_stack.push_back(
-          kore_string_pattern::create(read_string(ptr, end, version)));
+          kore_string_pattern::create(
+              read_string(ptr, end, version, dictionary), arena));
       break;
 
     case header_byte<kore_composite_pattern>: {
       ++ptr;
-      auto new_pattern = kore_composite_pattern::create(std::move(symbol));
+      auto new_pattern
+          = kore_composite_pattern::create(std::move(symbol), arena);
       symbol = nullptr;
 
       auto arity = read_length(ptr, end, version, 2);
@@ -394,38 +448,41 @@ sptr<kore_pattern> read(It &ptr, It end, binary_version version) {
       for (auto i = 0; i < arity; ++i) {
         term_stack.pop_back();
       }
-      term_stack.emplace_back(new_pattern.release());
+      term_stack.push_back(std::move(new_pattern));
       break;
     }
 
     case header_byte<kore_variable_pattern>: {
       ++ptr;
-      auto name = read_variable(ptr, end, version);
+      auto name = read_variable(ptr, end, version, dictionary);
       auto sort = sort_stack.back();
       sort_stack.pop_back();
 
       term_stack.push_back(
-          kore_variable_pattern::create(name->get_name(), sort));
+          kore_variable_pattern::create(name->get_name(), sort, arena));
       break;
     }
 
     case header_byte<kore_symbol>: {
       ++ptr;
-      symbol = read_symbol(ptr, end, sort_stack, version);
+      symbol = read_symbol(ptr, end, sort_stack, version, dictionary);
       break;
     }
 
     case header_byte<kore_sort_variable>: {
       ++ptr;
 
-      auto name = read_string(ptr, end, version);
-      sort_stack.push_back(kore_sort_variable::create(name));
+      auto name = read_string(ptr, end, version, dictionary);
+      sort_stack.push_back(
+          arena ? arena->sort_variable(name)
+                : kore_sort_variable::create(name));
       break;
     }
 
     case header_byte<kore_composite_sort>: {
       ++ptr;
-      sort_stack.push_back(read_composite_sort(ptr, end, sort_stack, version));
+      sort_stack.push_back(read_composite_sort(
+          ptr, end, sort_stack, version, arena, dictionary));
       break;
     }
 
@@ -449,8 +506,9 @@ sptr<kore_pattern> read_v2(
 std::string file_contents(std::string const &fn, int max_bytes = -1);
 
 template <typename It>
-sptr<kore_pattern>
-deserialize_pattern(It begin, It end, bool should_strip_raw_term = true) {
+sptr<kore_pattern> deserialize_pattern(
+    It begin, It end, bool should_strip_raw_term = true,
+    ast_arena *arena = nullptr, stream_dictionary *dictionary = nullptr) {
   // Try to parse the file even if the magic header isn't correct; by the time
   // we're here we already know that we're trying to parse a binary KORE file.
   // The header itself gets used by the application when detecting binary vs.
@@ -466,7 +524,7 @@ deserialize_pattern(It begin, It end, bool should_strip_raw_term = true) {
     end = std::next(begin, total_size);
   }
 
-  auto result = detail::read(begin, end, version);
+  auto result = detail::read(begin, end, version, arena, dictionary);
 
   if (should_strip_raw_term) {
     return strip_raw_term(result);
@@ -475,8 +533,39 @@ deserialize_pattern(It begin, It end, bool should_strip_raw_term = true) {
   return result;
 }
 
+/*
+ * Read every pattern from a binary KORE stream: a sequence of size-prefixed
+ * patterns, each with its own header, that share one stream dictionary.
+ */
+template <typename It>
+std::vector<sptr<kore_pattern>> deserialize_pattern_stream(
+    It begin, It end, bool should_strip_raw_term = true,
+    ast_arena *arena = nullptr) {
+  auto dictionary = stream_dictionary{};
+  auto results = std::vector<sptr<kore_pattern>>{};
+
+  auto header_size = serializer::magic_header.size() + (3 * sizeof(int16_t));
+
+  while (std::distance(begin, end) > header_size) {
+    auto size_begin = std::next(begin, header_size);
+    auto total_size = detail::read_pattern_size_unchecked(size_begin, end);
+    if (total_size == 0) {
+      throw std::runtime_error(
+          "Binary KORE stream contains a pattern without a size");
+    }
+
+    auto pattern_end = std::next(size_begin, total_size);
+    results.push_back(deserialize_pattern(
+        begin, pattern_end, should_strip_raw_term, arena, &dictionary));
+    begin = pattern_end;
+  }
+
+  return results;
+}
+
 bool has_binary_kore_header(std::string const &filename);
-sptr<kore_pattern> deserialize_pattern(std::string const &filename);
+sptr<kore_pattern>
+deserialize_pattern(std::string const &filename, ast_arena *arena = nullptr);
 
 } // namespace kllvm
 
@@ -8,7 +8,10 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <functional>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <unordered_map>
 #include <vector>
@@ -19,8 +22,59 @@ namespace detail {
 
 bool is_big_endian();
 
+/**
+ * Hash strings by their contents so that tables keyed by std::string can be
+ * queried with a std::string_view without building a temporary string.
+ */
+struct string_hash {
+  using is_transparent = void;
+  size_t operator()(std::string_view str) const {
+    return std::hash<std::string_view>{}(str);
+  }
+};
+
 } // namespace detail
 
+/**
+ * The dictionary of strings shared by every pattern in a binary KORE stream
+ * (format version 1.3.0 and newer). The first time a string is emitted to a
+ * stream, it is written out in full and appended to the dictionary; subsequent
+ * uses in any pattern of the same stream refer to it by index. Patterns in a
+ * stream must therefore be read back in order, using a single dictionary.
+ *
+ * Writers can additionally associate entries with integer keys (for example,
+ * the runtime tag of a symbol) so that repeated lookups do not need to hash the
+ * string itself.
+ */
+class stream_dictionary {
+public:
+  [[nodiscard]] std::optional<uint64_t> find(std::string_view str) const;
+  [[nodiscard]] std::optional<uint64_t> find_key(uint64_t key) const;
+
+  /**
+   * Append a string to the dictionary, returning its index.
+   */
+  uint64_t add(std::string_view str);
+
+  /**
+   * Associate a key with an existing entry.
+   */
+  void add_key(uint64_t key, uint64_t index);
+
+  [[nodiscard]] std::string const &at(uint64_t index) const;
+  [[nodiscard]] size_t size() const { return entries_.size(); }
+
+private:
+  std::vector<std::string> entries_;
+  std::unordered_map<
+      std::string, uint64_t, detail::string_hash, std::equal_to<>>
+      indices_;
+
+  // Keys are expected to be small and dense, so index directly into a vector
+  // storing one past the index of each entry (with zero meaning absent).
+  std::vector<uint64_t> keys_;
+};
+
 /**
  * A serializer provides a thin abstraction over a byte buffer and string
  * interning table.
@@ -37,10 +91,18 @@ public:
 
   static constexpr auto magic_header = std::array{'\x7f', 'K', 'O', 'R', 'E'};
   static constexpr auto version = binary_version(1, 2, 0);
+  static constexpr auto stream_version = binary_version(1, 3, 0);
 
   serializer();
   serializer(flags f);
 
+  /**
+   * Construct a serializer that writes one pattern of a binary KORE stream,
+   * taking strings from and adding strings to the stream's dictionary. The
+   * dictionary must outlive the serializer.
+   */
+  serializer(flags f, stream_dictionary *dictionary);
+
   /**
    * Emit a single byte or sequence of bytes to the output buffer.
    *
@@ -60,7 +122,50 @@ public:
    * emit the contents directly, or to emit a backreference to a previous copy
    * of the same string in the buffer.
    */
-  void emit_string(std::string const &s);
+  void emit_string(std::string_view s);
+
+  /**
+   * Emit the name of a sort or symbol. When writing to a stream, names are
+   * taken from the stream dictionary; otherwise, this is equivalent to
+   * emit_string. String patterns and variable names are never added to the
+   * dictionary, as they are unlikely to recur across a stream.
+   */
+  void emit_name(std::string_view name);
+
+  /**
+   * As emit_name, but the name is also identified by an integer key (for
+   * example, the runtime tag of a symbol) that is used to look it up in the
+   * stream dictionary without hashing the name itself.
+   */
+  void emit_keyed_name(uint64_t key, std::string_view name);
+
+  /**
+   * Copy pre-encoded binary KORE to the output buffer without interpreting it.
+   * The bytes must not contain any interned string backreferences.
+   */
+  void emit_bytes(std::string_view bytes);
+
+  /**
+   * Emit a sequence of pre-encoded sorts (for example, the formal arguments of
+   * a symbol fragment). The structure of each sort is copied to the buffer,
+   * but every name in it is re-emitted with emit_name so that it can be
+   * interned or taken from the stream dictionary. The names in the input must
+   * be directly encoded.
+   */
+  void emit_sorts(std::string_view sorts);
+
+  /**
+   * Emit a fragment of pre-encoded binary KORE (for example, a symbol and its
+   * formal sort arguments, as generated at kompile time). The fragment must
+   * contain a directly-encoded symbol name in the range [name_begin, name_end);
+   * every other byte is copied to the buffer unchanged.
+   *
+   * The name is interned by key rather than by its contents, and is looked up
+   * in the stream dictionary by key if writing to a stream.
+   */
+  void emit_fragment(
+      uint64_t key, std::string_view fragment, size_t name_begin,
+      size_t name_end);
 
   /**
    * Emit a variable-length length field to the buffer as a sequence of
@@ -105,9 +210,20 @@ private:
   std::string buffer_;
   char direct_string_prefix_;
   char backref_string_prefix_;
+  char dictionary_string_prefix_;
+  char dictionary_ref_prefix_;
+
+  stream_dictionary *dictionary_;
 
   uint64_t next_idx_;
-  std::unordered_map<std::string, uint64_t> intern_table_;
+  std::unordered_map<
+      std::string, uint64_t, detail::string_hash, std::equal_to<>>
+      intern_table_;
+
+  // Interning table for strings emitted by emit_fragment; as for the stream
+  // dictionary, this is indexed directly by key and stores one past the
+  // offset of each string.
+  std::vector<uint64_t> keyed_intern_table_;
 
   /**
    * Emit the standard \xf7KORE prefix and version number to the buffer.
@@ -124,7 +240,23 @@ private:
    * Emit a string directly to the output buffer and update the interning table,
    * regardless of whether the string has already been interned or not.
    */
-  void emit_direct_string(std::string const &s);
+  void emit_direct_string(std::string_view s);
+
+  /**
+   * Emit a backreference to a string previously emitted at this offset.
+   */
+  void emit_backref(uint64_t previous);
+
+  /**
+   * Emit a reference to an existing entry in the stream dictionary.
+   */
+  void emit_dictionary_ref(uint64_t index);
+
+  /**
+   * Emit a string directly to the output buffer and append it to the stream
+   * dictionary, returning its index.
+   */
+  uint64_t emit_dictionary_string(std::string_view s);
 
   /**
    * Calculate the number of continued bytes required to serialize this value as
@@ -141,6 +273,34 @@ void serializer::emit(T val) {
 
 void emit_kore_rich_header(std::ostream &os, kore_definition *definition);
 
+/**
+ * The binary KORE encoding of a concrete symbol applied to its arguments, which
+ * can be emitted with serializer::emit_fragment after the arguments have been
+ * serialized. The encoding contains:
+ *
+ *   - the formal sort arguments of the symbol;
+ *   - the symbol itself, with its name directly encoded in the range
+ *     [name_begin, name_end); and
+ *   - the composite pattern header and arity.
+ *
+ * The formal sorts occupy the range [0, symbol_begin), and should be emitted
+ * with serializer::emit_sorts so that their names are interned; the rest of
+ * the fragment is emitted with serializer::emit_fragment.
+ *
+ * Injections are a special case: their target sort is contextual, so the
+ * fragment contains only the source sort, and the target sort must be emitted
+ * separately at offset symbol_begin.
+ */
+struct symbol_fragment {
+  std::string bytes;
+  size_t symbol_begin;
+  size_t name_begin;
+  size_t name_end;
+  bool is_injection;
+};
+
+symbol_fragment encode_symbol_fragment(kore_symbol const &symbol);
+
 } // namespace kllvm
 
 #endif
@@ -2,9 +2,12 @@
 #define BINDINGS_CORE_H
 
 #include <kllvm/ast/AST.h>
+#include <kllvm/ast/definition_index.h>
 
 #include <memory>
 #include <optional>
+#include <string>
+#include <vector>
 
 // These headers need to be included last because they pollute a number of macro
 // definitions into the global namespace.
@@ -42,9 +45,61 @@ bool is_sort_k(std::shared_ptr<kllvm::kore_sort> const &sort);
 std::shared_ptr<kore_pattern>
 evaluate_function(std::shared_ptr<kore_composite_pattern> const &term);
 
+/*
+ * Batched variants of simplify and evaluate_function for clients that issue
+ * many small queries against the same definition. Rather than converting each
+ * result back to a kore_pattern, these functions write the i-th result as a
+ * size-prefixed binary KORE buffer allocated with malloc to data_out[i], and
+ * its size to sizes_out[i]; both arrays must have room for one entry per
+ * input. Results have the same shape as the corresponding single-query
+ * functions: anything not of sort KItem is wrapped in rawTerm{}(inj{S,
+ * SortKItem{}}(...)).
+ */
+void simplify_batch(
+    std::vector<std::shared_ptr<kllvm::kore_pattern>> const &patterns,
+    std::shared_ptr<kllvm::kore_sort> const &sort, char **data_out,
+    size_t *sizes_out);
+
+/*
+ * As above, but the inputs are binary KORE buffers, and each result is
+ * serialized directly at the given sort as in kore_simplify_binary. The sort is
+ * passed in its printed form (e.g. SortFoo{}) so that it is only computed once
+ * per batch.
+ */
+void simplify_binary_batch(
+    char *const *data_in, size_t const *sizes_in, size_t count,
+    char const *sort, char **data_out, size_t *sizes_out);
+
+/*
+ * Evaluate each function call in the batch; each distinct function symbol is
+ * printed, and its tag and return sort looked up, once per batch.
+ */
+void evaluate_function_batch(
+    std::vector<std::shared_ptr<kore_composite_pattern>> const &terms,
+    char **data_out, size_t *sizes_out);
+
+/*
+ * Evaluate count calls to the function symbol with this label. The arguments
+ * are binary KORE buffers laid out call by call, such that the j-th argument
+ * of the i-th call is data_in[i * arity + j].
+ */
+void evaluate_function_binary_batch(
+    std::string const &label, char *const *data_in, size_t const *sizes_in,
+    size_t count, char **data_out, size_t *sizes_out);
+
+/**
+ * Get the metadata index for the definition at this path. The index is loaded
+ * from `definition.index` in the same directory if it is present and up to
+ * date, and otherwise computed by parsing the definition. Either way, the
+ * result is cached for the lifetime of the process, so only the first call for
+ * each path is expensive.
+ */
+definition_index const &
+get_definition_index(std::string const &definition_path);
+
 /**
  * Get the name of the LLVM function that attempts matching on the rule with
- * this label by parsing a KORE definition and examining its axioms.
+ * this label, using the cached index for the definition at this path.
  */
 std::optional<std::string> get_match_function_name(
     std::string const &definition_path, std::string const &label);
@@ -4,6 +4,8 @@
 #include <llvm/IR/Module.h>
 #include <llvm/Support/raw_ostream.h>
 
+#include <string>
+
 namespace kllvm {
 
 void do_bitcode_linking(llvm::Module &);
@@ -12,6 +14,12 @@ void apply_kllvm_opt_passes(llvm::Module &, bool hidden_visibility);
 
 void generate_object_file(llvm::Module &, llvm::raw_ostream &);
 
+/*
+ * Every setting other than the module itself that affects the object code
+ * produced by generate_object_file, including the host CPU and its features.
+ */
+std::string get_object_file_configuration();
+
 } // namespace kllvm
 
 #endif
@@ -0,0 +1,83 @@
+#ifndef KLLVM_BRANCH_PROFILE_H
+#define KLLVM_BRANCH_PROFILE_H
+
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Module.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace kllvm {
+
+/*
+ * Profile-guided optimization of the generated rewriter happens in two
+ * kompiles of the same definition:
+ *
+ *   - With --pgo-instrument, each switch in a decision tree gets an array of
+ *     counters with one entry per case, and each rule application gets a
+ *     single counter. The interpreter appends the counters to a profile file
+ *     when it exits.
+ *
+ *   - With --pgo-profile=<file>, the counts from that file become branch
+ *     weights on the corresponding switch instructions, hot cases are listed
+ *     first, and rules that were never applied are marked cold.
+ *
+ * Counters are identified by the name of the enclosing LLVM function and the
+ * position of the switch in that function. Switches are numbered in the order
+ * of the decision tree, whether or not a profile is given. A profile is only
+ * meaningful for the definition and decision trees it was collected from.
+ * Profile entries whose length does not match the current switch are ignored.
+ *
+ * The profile file is textual, with one counter array per line:
+ *
+ *   <key> '\t' <count> (' ' <count>)*
+ *
+ * Lines with the same key are summed, so that running an instrumented
+ * interpreter several times accumulates counts in the same file.
+ */
+class branch_profile {
+public:
+  /*
+   * The profile named by --pgo-profile, loaded on first use and again if the
+   * option changes; empty if no profile was given.
+   */
+  static branch_profile const &get();
+
+  static branch_profile load(std::string const &path);
+
+  [[nodiscard]] std::optional<std::vector<uint64_t>>
+  get_counts(std::string const &key, size_t size) const;
+
+  [[nodiscard]] bool empty() const { return counts_.empty(); }
+
+private:
+  std::unordered_map<std::string, std::vector<uint64_t>> counts_;
+};
+
+std::string switch_profile_key(llvm::Function *fn, unsigned index);
+std::string rule_profile_key(std::string const &rule);
+
+/*
+ * Create the counter array for this key in the module; the array is found by
+ * its name again when emitting the registration table.
+ */
+llvm::GlobalVariable *
+get_profile_counters(llvm::Module *mod, std::string const &key, size_t size);
+
+void emit_profile_increment(
+    llvm::GlobalVariable *counters, size_t index, llvm::BasicBlock *block);
+
+/*
+ * Emit a global constructor that registers every counter array in the module
+ * with the runtime, so that the counts are written out at exit. Does nothing
+ * if the module contains no counters.
+ */
+void emit_profile_registration(llvm::Module *mod);
+
+} // namespace kllvm
+
+#endif
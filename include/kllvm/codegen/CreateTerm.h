@@ -15,6 +15,24 @@ static constexpr int max_block_merge_size = 4096;
 
 namespace kllvm {
 
+class in_place_analysis;
+
+/* a block of the configuration that create_term may store into rather than
+   allocating a new block, or null if it must allocate one after all */
+struct reused_block {
+  llvm::Value *block;
+  std::vector<bool> unchanged;
+};
+
+/* a call to a function with the parallel attribute that has been started as a
+   task, and the environment that the task stores its result into */
+struct parallel_call {
+  llvm::Value *task;
+  llvm::Value *env;
+  llvm::StructType *env_type;
+  value_type return_cat;
+};
+
 class create_term {
 private:
   llvm::StringMap<llvm::Value *> &substitution_;
@@ -24,6 +42,10 @@ private:
   llvm::LLVMContext &ctx_;
   bool is_anywhere_owise_;
   std::set<kore_pattern *> static_terms_;
+  std::set<kore_pattern *> ground_terms_;
+  bool in_ground_term_ = false;
+  std::map<kore_pattern *, reused_block> reused_blocks_;
+  std::map<kore_pattern *, parallel_call> parallel_calls_;
 
   llvm::Value *alloc_arg(
       kore_composite_pattern *pattern, int idx,
@@ -41,7 +63,16 @@ private:
   llvm::Value *not_injection_case(
       kore_composite_pattern *constructor, llvm::Value *val,
       std::string const &location_stack = "");
+  bool is_parallel_call(kore_pattern *pattern);
+  void spawn_parallel_calls(
+      kore_composite_pattern *pattern, std::string const &location_stack);
+  void spawn_parallel_call(
+      kore_composite_pattern *pattern, std::string const &location_stack);
+  llvm::Value *join_parallel_call(parallel_call const &call);
   bool populate_static_set(kore_pattern *pattern);
+  bool populate_ground_set(kore_pattern *pattern);
+  std::pair<llvm::Value *, bool> create_ground_term(
+      kore_pattern *pattern, std::string const &location_stack);
   std::pair<llvm::Value *, bool> create_allocation(
       kore_pattern *pattern, std::string const &location_stack = "");
   llvm::Value *disable_gc();
@@ -88,6 +119,11 @@ public:
   [[nodiscard]] llvm::BasicBlock *get_current_block() const {
     return current_block_;
   }
+
+  /* sets the blocks to update in place when constructing each pattern */
+  void set_reused_blocks(std::map<kore_pattern *, reused_block> blocks) {
+    reused_blocks_ = std::move(blocks);
+  }
 };
 
 std::string escape(std::string const &str);
@@ -115,10 +151,12 @@ value_type term_type(
     kore_definition *definition);
 
 /** creates a function that applies the specified rule once it has matched, and
- * returns the name of the function. */
+ * returns the name of the function. If `in_place` is given, a rule that takes
+ * a step updates the configuration in place where the analysis allows. */
 void make_apply_rule_function(
     kore_axiom_declaration *axiom, kore_definition *definition,
-    llvm::Module *module, bool big_step = false);
+    llvm::Module *module, bool big_step = false,
+    in_place_analysis const *in_place = nullptr);
 std::string make_apply_rule_function(
     kore_axiom_declaration *axiom, kore_definition *definition,
     llvm::Module *module, std::vector<residual> const &residuals);
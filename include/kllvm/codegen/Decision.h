@@ -407,6 +407,14 @@ private:
   llvm::AllocaInst *has_search_results_;
   bool profile_matching_;
 
+  /* the number of switches generated so far in this function, used to
+     identify each switch in a branch profile */
+  unsigned num_switches_ = 0;
+
+  /* the configuration being rewritten, passed to rules that can update it in
+     place; null when generating anything other than k_step */
+  llvm::Value *configuration_{nullptr};
+
   std::map<var_type, llvm::AllocaInst *> symbols_{};
 
   llvm::Value *get_tag(llvm::Value *);
@@ -445,6 +453,10 @@ public:
   void store(var_type const &name, llvm::Value *val);
   llvm::Value *load(var_type const &name);
 
+  void set_configuration(llvm::Value *configuration) {
+    configuration_ = configuration;
+  }
+
   friend class switch_node;
   friend class make_pattern_node;
   friend class function_node;
@@ -5,8 +5,12 @@
 
 #include <llvm/IR/Module.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <map>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace kllvm {
@@ -36,6 +40,78 @@ partial_step parse_yaml_specialdecision_tree(
     std::map<std::string, kore_symbol *> const &syms,
     std::map<value_type, sptr<kore_composite_sort>> const &sorts);
 
+/*
+ * All of the decision trees for a definition, as written by the matching
+ * compiler to `decision_trees.bin` in a single indexed binary file. The file
+ * is mapped into memory, and each tree is decoded on demand by name:
+ *
+ *   - "dt" and "dt-search" for the top-level step functions,
+ *   - "dt_<ordinal>" and "match_<ordinal>" for the per-axiom trees, and
+ *   - the name of each function symbol for its evaluation function.
+ *
+ * The matching compiler hash-conses decision tree nodes, and the file stores
+ * each distinct node once, including nodes shared between trees. Each call to
+ * parse creates fresh nodes, with sharing preserved within the tree being
+ * parsed, exactly as for a tree read from YAML.
+ *
+ * All integers are 32-bit little-endian; strings are indices into the string
+ * table, and occurrences are a count followed by that many strings:
+ *
+ *   "\x7fKDT" | version | num_strings | num_nodes | num_trees
+ *   num_strings x (length | bytes)
+ *   node_data_size | num_nodes x node offset | node data
+ *   residual_data_size | residual data
+ *   num_trees x (name | root node | residual offset + 1, or 0)
+ *
+ * See DecisionTreeFile.scala in the matching compiler for the encoding of
+ * each kind of node.
+ */
+class decision_tree_file {
+public:
+  static constexpr uint32_t version = 1;
+
+  explicit decision_tree_file(std::string const &filename);
+  ~decision_tree_file();
+
+  decision_tree_file(decision_tree_file const &) = delete;
+  decision_tree_file &operator=(decision_tree_file const &) = delete;
+
+  [[nodiscard]] bool contains(std::string const &name) const;
+
+  decision_node *
+  parse(llvm::Module *, std::string const &name,
+        std::map<std::string, kore_symbol *> const &syms,
+        std::map<value_type, sptr<kore_composite_sort>> const &sorts) const;
+
+  partial_step parse_special(
+      llvm::Module *, std::string const &name,
+      std::map<std::string, kore_symbol *> const &syms,
+      std::map<value_type, sptr<kore_composite_sort>> const &sorts) const;
+
+private:
+  struct tree_entry {
+    uint32_t root;
+    uint32_t residuals;
+  };
+
+  std::string filename_;
+  char const *data_ = nullptr;
+  size_t size_ = 0;
+
+  std::vector<std::string_view> strings_;
+  uint32_t num_nodes_ = 0;
+  char const *node_offsets_ = nullptr;
+  char const *node_data_ = nullptr;
+  size_t node_data_size_ = 0;
+  char const *residual_data_ = nullptr;
+  size_t residual_data_size_ = 0;
+  std::unordered_map<std::string_view, tree_entry> trees_;
+
+  [[nodiscard]] tree_entry const &get_entry(std::string const &name) const;
+
+  friend class dt_binary_reader;
+};
+
 } // namespace kllvm
 
 #endif // DECISION_PARSER_H
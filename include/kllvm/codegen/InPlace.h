@@ -0,0 +1,88 @@
+#ifndef KLLVM_IN_PLACE_H
+#define KLLVM_IN_PLACE_H
+
+#include "kllvm/ast/AST.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace kllvm {
+
+/*
+ * A block of the configuration that a rule can update in place rather than
+ * allocating a copy of it.
+ */
+struct reusable_block {
+  /* the position of the block in the configuration matched by the rule: each
+     step is the symbol of a block on the path from the top cell, and the index
+     of the child of that block to follow */
+  std::vector<std::pair<kore_symbol *, unsigned>> path;
+  /* for each child of the block, whether the rule leaves it unchanged, in
+     which case it does not need to be stored again */
+  std::vector<bool> unchanged;
+};
+
+/*
+ * Decides which blocks of the configuration a rewrite rule can update in
+ * place with --in-place-rewrite.
+ *
+ * A rule that rewrites a cell deep in the configuration would normally
+ * allocate a copy of every block on the path from the top cell to that cell.
+ * If the right-hand side of the rule has the same constructor at the same
+ * position as the left-hand side, and nothing else refers to the block
+ * matched there, the rule can instead store the new children into that block.
+ *
+ * Whether something else refers to a block is approximated by its sort: a
+ * sort is shared if a term of that sort can be contained in a term that some
+ * rule duplicates (by using a variable more than once on its right-hand side,
+ * binding it with \and on its left-hand side, or passing it to a hook that
+ * replicates its argument). Blocks of shared sorts are never reused. Within a
+ * single rule, a block is also not reused if a variable used on the right-hand
+ * side is bound to it or to one of its ancestors, or if a collection stored
+ * directly in it is bound to a variable that is read after its children are
+ * stored.
+ *
+ * The analysis assumes that the configuration passed to k_step is not
+ * referred to from anywhere else, which is true of the interpreter's main loop
+ * but not of search or of terms passed in through the bindings; the generated
+ * code only reuses blocks when the interpreter enables it at runtime, and only
+ * blocks in the young generation so that the garbage collector never sees an
+ * old block pointing to a young one.
+ */
+class in_place_analysis {
+public:
+  explicit in_place_analysis(kore_definition *definition);
+
+  /* the blocks that the top-level rule `axiom` can update in place, keyed by
+     the pattern on its right-hand side that constructs each one */
+  [[nodiscard]] std::map<kore_pattern *, reusable_block>
+  reusable_blocks(kore_axiom_declaration *axiom) const;
+
+  [[nodiscard]] bool is_shared(std::string const &sort) const {
+    return shared_sorts_.contains(sort);
+  }
+
+  /* whether a block constructed by `symbol` can ever be reused */
+  [[nodiscard]] bool can_reuse(kore_symbol *symbol) const;
+
+  /* whether every term of `sort` has a single reference, so that a hook can
+     update its argument in place; unlike is_shared, this also accounts for
+     terms injected into a shared sort in the initial configuration, and for
+     terms read by a side condition, which are matched again if it fails */
+  [[nodiscard]] bool is_linear(std::string const &sort) const {
+    return !aliased_sorts_.contains(sort);
+  }
+
+private:
+  kore_definition *definition_;
+  std::set<std::string> shared_sorts_;
+  std::set<std::string> aliased_sorts_;
+  std::set<std::string> overloaded_;
+};
+
+} // namespace kllvm
+
+#endif
@@ -4,6 +4,7 @@
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 
+#include <cstdint>
 #include <string>
 
 namespace kllvm {
@@ -13,6 +14,10 @@ void add_kompiled_dir_symbol(
 
 void add_mutable_bytes_flag(llvm::Module &mod, bool enabled, bool debug);
 
+void add_linear_bytes_flag(llvm::Module &mod, bool enabled, bool debug);
+
+void add_contiguous_heap_symbol(llvm::Module &mod, uint64_t bytes, bool debug);
+
 void add_safe_partial_flag(llvm::Module &mod, bool enabled, bool debug);
 
 void add_proof_hint_instrumentation_slow_flag(
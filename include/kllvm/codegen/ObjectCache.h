@@ -0,0 +1,52 @@
+#ifndef KLLVM_OBJECT_CACHE_H
+#define KLLVM_OBJECT_CACHE_H
+
+#include <llvm/IR/Module.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace kllvm {
+
+/*
+ * A content-addressed cache of object code for the generated interpreter,
+ * used to avoid regenerating machine code for the parts of a definition that
+ * have not changed since a previous kompile.
+ *
+ * After optimization, the module is split into a fixed number of partitions;
+ * functions are assigned to partitions by a hash of their name, so an edit to
+ * a few rules or functions only changes the partitions that contain them. Each
+ * partition is keyed by a hash of its bitcode, the backend and LLVM versions,
+ * and the target configuration, and its object file is stored in the cache
+ * directory as <key>.o. Partitions that are not already in the cache are
+ * compiled in parallel.
+ */
+class object_cache {
+public:
+  struct stats {
+    size_t hits = 0;
+    size_t misses = 0;
+  };
+
+  explicit object_cache(std::string dir);
+
+  /*
+   * Split the module into partitions, and return the paths of the cached
+   * object files for each one, compiling any that are missing. The module is
+   * consumed by the split.
+   */
+  std::vector<std::string>
+  get_objects(std::unique_ptr<llvm::Module> mod, unsigned partitions);
+
+  [[nodiscard]] stats const &get_stats() const { return stats_; }
+
+private:
+  std::string dir_;
+  stats stats_;
+};
+
+} // namespace kllvm
+
+#endif
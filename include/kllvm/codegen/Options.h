@@ -14,6 +14,8 @@ extern llvm::cl::opt<bool> proof_hint_instrumentation;
 extern llvm::cl::opt<bool> proof_hint_instrumentation_slow;
 extern llvm::cl::opt<bool> keep_frame_pointer;
 extern llvm::cl::opt<char> optimization_level;
+extern llvm::cl::opt<bool> pgo_instrument;
+extern llvm::cl::opt<std::string> pgo_profile;
 
 namespace kllvm {
 
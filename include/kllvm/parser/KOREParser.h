@@ -14,13 +14,19 @@ namespace kllvm::parser {
 
 class kore_parser {
 public:
-  kore_parser(std::string const &filename)
+  kore_parser(std::string const &filename, ast_arena *arena = nullptr)
       : scanner_(kore_scanner(filename))
-      , loc_(location(filename)) { }
+      , loc_(location(filename))
+      , arena_(arena) { }
 
   static std::unique_ptr<kore_parser> from_string(std::string const &text);
 
-  ptr<kore_definition> definition();
+  /* Parse a definition. If use_arena is true, the definition is created in
+     arena mode and its pattern and sort nodes are allocated in its arena, with
+     sorts hash-consed; otherwise, the parser allocates into the arena it was
+     constructed with, if any. Symbols and variables are heap-allocated in
+     either case. */
+  ptr<kore_definition> definition(bool use_arena = false);
   sptr<kore_pattern> pattern();
   sptr<kore_sort> sort();
   ptr<kore_symbol> symbol();
@@ -31,6 +37,7 @@ public:
 private:
   kore_scanner scanner_;
   location loc_;
+  ast_arena *arena_;
   [[noreturn]] static void
   error(location const &loc, std::string const &err_message);
 
@@ -56,6 +63,7 @@ private:
   void sorts(Node *node);
   template <typename Node>
   void sorts_ne(Node *node);
+  std::vector<sptr<kore_sort>> sort_list();
 
   sptr<kore_pattern> pattern_internal();
   void patterns(kore_composite_pattern *node);
@@ -65,8 +73,8 @@ private:
 
   sptr<kore_pattern> application_pattern();
   sptr<kore_pattern> application_pattern(std::string const &name);
-  ptr<kore_composite_pattern> application_pattern_internal();
-  ptr<kore_composite_pattern>
+  sptr<kore_composite_pattern> application_pattern_internal();
+  sptr<kore_composite_pattern>
   application_pattern_internal(std::string const &name);
 
   struct {
@@ -3,6 +3,14 @@
 
 #include <cstddef>
 
+// The state of the allocator is local to each thread, so that parallel tasks
+// allocate without synchronisation. This uses the default (global-dynamic) TLS
+// model: the runtime is also linked into shared libraries that the bindings
+// load with dlopen, where initial-exec TLS can fail to load once the static
+// TLS block is full. When linking an executable, the linker relaxes accesses
+// to the cheaper initial-exec or local-exec models.
+#define KORE_THREAD_LOCAL thread_local
+
 extern "C" {
 
 // The maximum single allocation size in bytes.
@@ -12,6 +20,7 @@ extern size_t const BLOCK_SIZE;
 #define YOUNGSPACE_ID 0
 #define OLDSPACE_ID 1
 #define ALWAYSGCSPACE_ID 3
+#define STATICSPACE_ID 4
 
 char youngspace_collection_id(void);
 char oldspace_collection_id(void);
@@ -37,6 +46,11 @@ void *kore_alloc_always_gc(size_t requested);
 // if the swapOld flag is set, it also swaps the two semispaces of the old
 // generation
 void kore_alloc_swap(bool swap_old);
+// redirects allocations into the young generation to the static arena, which
+// is never collected, until the matching call to kore_static_alloc_end. Used to
+// build the ground terms of a definition, which live as long as the program.
+void kore_static_alloc_begin(void);
+void kore_static_alloc_end(void);
 // resets the alwaysgcspace, freeing all memory allocated by it
 void kore_clear(void);
 // resizes the last allocation into the young generation
@@ -2,6 +2,7 @@
 #define ARENA_H
 
 #include <cstddef>
+#include <cstdint>
 #include <sys/types.h>
 
 #include "runtime/alloc.h"
@@ -32,10 +33,22 @@ using memory_block_header = struct {
 #define REGISTER_ARENA(name, id)                                               \
   static struct arena name = {.allocation_semispace_id = (id)}
 
+// Like REGISTER_ARENA, but each thread allocates into its own copy of the
+// arena.
+#define REGISTER_THREAD_LOCAL_ARENA(name, id)                                  \
+  static KORE_THREAD_LOCAL struct arena name                                   \
+      = {.allocation_semispace_id = (id)}
+
 #define MEM_BLOCK_START(ptr)                                                   \
   ((char *)(((uintptr_t)(ptr)-1) & ~(BLOCK_SIZE - 1)))
 
-extern bool time_for_collection;
+extern constinit KORE_THREAD_LOCAL bool time_for_collection;
+
+// The number of bytes of address space to reserve for the arenas as a single
+// region, set by llvm-kompile --contiguous-heap; 0 when the arenas are
+// allocated in separate superblocks. This only changes where blocks come from:
+// references between terms are ordinary 64-bit pointers either way.
+extern uint64_t contiguous_heap_size;
 
 size_t get_gc_threshold();
 
@@ -92,6 +105,11 @@ void arena_swap_and_clear(struct arena *);
 // arena.
 void arena_clear(struct arena *);
 
+// Appends the blocks of the second arena to the first, which then allocates
+// from the end of the last of them. Both arenas must use the same semispace,
+// and the second must only have been allocated into since it was last reset.
+void arena_merge(struct arena *, struct arena *);
+
 // Returns the address of the first byte that belongs in the given arena.
 // Returns 0 if nothing has been allocated ever in that arena.
 char *arena_start_ptr(const struct arena *);
@@ -125,6 +143,36 @@ size_t arena_size(const struct arena *);
 
 // Deallocates all the memory allocated for registered arenas.
 void free_all_memory(void);
+
+// The arenas that a parallel task allocates into. They use the semispaces of
+// the thread that spawns the task, and are merged into its arenas when it
+// joins the task, so that the task's results become part of its heap.
+struct task_arenas {
+  struct arena young;
+  struct arena old;
+  bool time_for_collection;
+};
+
+// Prepares the arenas of a task spawned by the calling thread.
+void kore_alloc_task_init(struct task_arenas *);
+
+// Exchanges the arenas of the calling thread with those of a task; a thread
+// calls this before and after it runs the task.
+void kore_alloc_task_swap(struct task_arenas *);
+
+// Merges the arenas of a finished task into those of the calling thread.
+void kore_alloc_task_merge(struct task_arenas *);
+
+// Runs fn(env) as a task on a pool of worker threads, and returns a handle to
+// pass to kore_join. The generated code spawns calls to functions with the
+// parallel attribute. The number of workers is read from KLLVM_THREADS, and
+// is one less than the number of hardware threads by default.
+void *kore_spawn(void (*fn)(void *), void *env);
+
+// Waits for a task to finish, running other tasks in the meantime, and merges
+// the memory that the task allocated into the heap of the calling thread. An
+// exception thrown by the task is rethrown here.
+void kore_join(void *);
 }
 
 #endif // ARENA_H
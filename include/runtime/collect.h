@@ -37,8 +37,11 @@ void migrate_map(void *m);
 void migrate_rangemap(void *m);
 void migrate_set(void *s);
 void migrate_collection_node(void **node_ptr);
+// marks every object reachable from a term as static, so that it is never
+// migrated. The layout is that of the term, as in a layoutitem.
+void make_static(void *term, uint16_t layout);
 void set_kore_memory_functions_for_gmp(void);
-void kore_collect(void **, uint8_t, layoutitem *, bool force = false);
+void kore_collect(void **, uint32_t, layoutitem *, bool force = false);
 }
 
 #ifdef GC_DBG
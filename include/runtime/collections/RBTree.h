@@ -9,19 +9,47 @@
 #include <cassert>
 #include <functional>
 #include <memory>
+#include <new>
 #include <stdexcept>
 #include <string>
 #include <utility>
 
 namespace rb_tree {
 
+//---                       Allocation of tree nodes.                      ---//
+
+// Nodes are reference counted with std::shared_ptr.
+struct refcount_policy {
+  template <class N>
+  using pointer = std::shared_ptr<N>;
+
+  template <class N, class... Args>
+  static pointer<N> make(Args &&...args) {
+    return std::make_shared<N>(std::forward<Args>(args)...);
+  }
+};
+
+// Nodes are allocated with Heap::allocate and never freed, in the same way as
+// the nodes of the immer collections in include/runtime/header.h; the owner of
+// the heap is responsible for reclaiming them (see RBTree::migrate).
+template <class Heap>
+struct heap_policy {
+  template <class N>
+  using pointer = N *;
+
+  template <class N, class... Args>
+  static pointer<N> make(Args &&...args) {
+    return new (Heap::allocate(sizeof(N))) N(std::forward<Args>(args)...);
+  }
+};
+
 //---               Ordered map on top of a red-black tree.                ---//
 
 // 1. No red node has a red child.
 // 2. Every path from root to empty node contains the same
 // number of black nodes.
 
-template <class T, class V>
+template <class T, class V, class MemoryPolicy = refcount_policy>
 class RBTree {
   // Colors used by the red black tree: Red (R), Black (B), and Double Black
   // (BB). BB is a transitory color that allows to temporarily preserve the
@@ -39,6 +67,9 @@ class RBTree {
     }
   }
 
+  struct Node;
+  using node_ptr = typename MemoryPolicy::template pointer<Node>;
+
   // Virtual class, for a node of the red-black tree.
   struct Node {
     Node(Color c)
@@ -67,38 +98,44 @@ class RBTree {
   struct InternalNode : public Node {
     // Create a new InternalNode object with the given lft and rgt children,
     // key and value, and color.
-    InternalNode(
-        Color c, std::shared_ptr<Node> lft, T key, V val,
-        std::shared_ptr<Node> rgt)
+    InternalNode(Color c, node_ptr lft, T key, V val, node_ptr rgt)
         : Node(c)
         , lft_(std::move(lft))
         , data_(key, val)
         , rgt_(std::move(rgt)) {
       this->s_ = 1 + lft_->s_ + rgt_->s_;
     }
-    std::shared_ptr<Node> lft_; // Left child
+    node_ptr lft_; // Left child
     std::pair<T, V> data_; // data_.first: Node key. data_.second: Node value.
-    std::shared_ptr<Node> rgt_; // Right child
+    node_ptr rgt_; // Right child
 
     [[nodiscard]] bool is_leaf() const override { return false; }
     ~InternalNode() override = default;
   };
 
+  // Leaves carry no data, so every empty tree of a given color shares one.
+  static node_ptr leaf(Color c) {
+    static node_ptr const black = MemoryPolicy::template make<Leaf>(Color::B);
+    static node_ptr const double_black
+        = MemoryPolicy::template make<Leaf>(Color::BB);
+    return c == Color::B ? black : double_black;
+  }
+
   // Create an empty red-black tree, with the specified color. Only B and BB
   // are valid colors for this constructor.
   RBTree(Color c)
-      : root_(std::make_shared<Leaf>(c)) { }
+      : root_(leaf(c)) { }
 
   // Create a red-black tree, with a root of the spefified color, key and value,
   // and children lft and rgt.
   RBTree(Color c, RBTree const &lft, T key, V val, RBTree const &rgt)
-      : root_(
-          std::make_shared<InternalNode>(c, lft.root_, key, val, rgt.root_)) {
+      : root_(MemoryPolicy::template make<InternalNode>(
+          c, lft.root_, key, val, rgt.root_)) {
     assert(lft.empty() || lft.root_key() < key);
     assert(rgt.empty() || key < rgt.root_key());
   }
 
-  explicit RBTree(std::shared_ptr<Node> node)
+  explicit RBTree(node_ptr node)
       : root_(std::move(node)) { }
 
   // Return this Node's color when it is not empty.
@@ -116,7 +153,7 @@ class RBTree {
 public:
   // Create an empty red-black tree.
   RBTree()
-      : root_(std::make_shared<Leaf>(Color::B)) { }
+      : root_(leaf(Color::B)) { }
 
   // Create a red-black tree with elements from the container designated by the
   // beginning and end iterator arguments. The container should contain elements
@@ -132,12 +169,12 @@ public:
 
   RBTree(RBTree const &other) = default;
 
-  RBTree(RBTree &&other) { other.root_.swap(root_); }
+  RBTree(RBTree &&other) { std::swap(root_, other.root_); }
 
   RBTree &operator=(RBTree const &other) = default;
 
   RBTree &operator=(RBTree &&other) {
-    other.root_.swap(root_);
+    std::swap(root_, other.root_);
     return *this;
   }
 
@@ -147,14 +184,14 @@ public:
   // Return the key stored in the root Node of this tree.
   [[nodiscard]] T const &root_key() const {
     assert(!empty());
-    auto const *r = static_cast<InternalNode const *>(root_.get());
+    auto const *r = static_cast<InternalNode const *>(&*root_);
     return r->data_.first;
   }
 
   // Return the value stored in the root Node of this tree.
   [[nodiscard]] V const &root_val() const {
     assert(!empty());
-    auto const *r = static_cast<InternalNode const *>(root_.get());
+    auto const *r = static_cast<InternalNode const *>(&*root_);
     return r->data_.second;
   }
 
@@ -162,7 +199,7 @@ public:
   // Node of this tree.
   [[nodiscard]] std::pair<T, V> const &root_data() const {
     assert(!empty());
-    auto const *r = static_cast<InternalNode const *>(root_.get());
+    auto const *r = static_cast<InternalNode const *>(&*root_);
     return r->data_;
   }
 
@@ -182,24 +219,40 @@ public:
   // this tree.
   std::pair<T, V> &root_data_mutable() {
     assert(!empty());
-    auto *r = static_cast<InternalNode *>(root_.get());
+    auto *r = static_cast<InternalNode *>(&*root_);
     return r->data_;
   }
 
+  // Call migrate_node on every pointer to a node of this tree, and then
+  // migrate_data on the data of the node it points to, visiting parents before
+  // their children. This is for use by the garbage collector, which moves the
+  // nodes of trees with a heap_policy; the same warning applies as to
+  // root_data_mutable.
+  template <class MigrateNode, class MigrateData>
+  void migrate(MigrateNode &&migrate_node, MigrateData &&migrate_data) {
+    migrate(root_, migrate_node, migrate_data);
+  }
+
   // Return the left subtree of this tree.
   [[nodiscard]] RBTree left() const {
     assert(!empty());
-    auto const *r = static_cast<InternalNode const *>(root_.get());
+    auto const *r = static_cast<InternalNode const *>(&*root_);
     return RBTree(r->lft_);
   }
 
   // Return the right subtree of this tree.
   [[nodiscard]] RBTree right() const {
     assert(!empty());
-    auto const *r = static_cast<InternalNode const *>(root_.get());
+    auto const *r = static_cast<InternalNode const *>(&*root_);
     return RBTree(r->rgt_);
   }
 
+  // Return true if this tree and t have the same root node, in which case
+  // they are equal without comparing their contents.
+  [[nodiscard]] bool shares_root(RBTree const &t) const {
+    return root_ == t.root_;
+  }
+
   // Return the size of this tree, i.e., the number of non-leaf nodes.
   [[nodiscard]] size_t size() const { return root_->s_; }
 
@@ -627,13 +680,26 @@ private:
     return RBTree(c, left(), root_key(), root_val(), right());
   }
 
-  std::shared_ptr<Node> root_;
+  template <class MigrateNode, class MigrateData>
+  static void migrate(
+      node_ptr &node, MigrateNode &migrate_node, MigrateData &migrate_data) {
+    migrate_node(node);
+    if (node->is_leaf()) {
+      return;
+    }
+    auto *n = static_cast<InternalNode *>(&*node);
+    migrate_data(n->data_);
+    migrate(n->lft_, migrate_node, migrate_data);
+    migrate(n->rgt_, migrate_node, migrate_data);
+  }
+
+  node_ptr root_{};
 };
 
 // Recursively (using inorder traversal) apply function f to all elements of
 // tree t. Function f must accept two arguments of types T and V respectively.
-template <class T, class V, class F>
-void for_each(RBTree<T, V> const &t, F &&f) {
+template <class T, class V, class P, class F>
+void for_each(RBTree<T, V, P> const &t, F &&f) {
   if (!t.empty()) {
     for_each(t.left(), std::forward<F>(f));
     std::invoke(f, t.root_key(), t.root_val());
@@ -644,8 +710,8 @@ void for_each(RBTree<T, V> const &t, F &&f) {
 // Return a red-black tree with all elements in t, and then also from the
 // container designated by the beginning and end iterator arguments. The
 // container should contain elements of type std::pair<T,V>.
-template <class T, class V, class I>
-RBTree<T, V> inserted(RBTree<T, V> const &t, I it, I end) {
+template <class T, class V, class P, class I>
+RBTree<T, V, P> inserted(RBTree<T, V, P> const &t, I it, I end) {
   if (it == end) {
     return t;
   }
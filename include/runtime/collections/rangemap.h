@@ -113,20 +113,21 @@ public:
 // Map whose keys are stored as ranges.
 // - T : class of map keys
 // - V : class of map values
-template <class T, class V>
+// - P : memory policy for the nodes of the underlying red-black tree
+template <class T, class V, class P = rb_tree::refcount_policy>
 class RangeMap {
 
 private:
   // Ordered map based on red-black tree.
-  rb_tree::RBTree<Range<T>, V> treemap_;
+  rb_tree::RBTree<Range<T>, V, P> treemap_;
 
   // Create a rangemap on top of a red-black tree that uses ranges as keys.
   // The red black tree should already be a well-formed rangemap.
-  RangeMap(rb_tree::RBTree<Range<T>, V> t)
+  RangeMap(rb_tree::RBTree<Range<T>, V, P> t)
       : treemap_(std::move(t)) { }
 
   [[nodiscard]] std::optional<std::pair<Range<T>, V>>
-  get_key_value(rb_tree::RBTree<Range<T>, V> const &t, T const &k) const {
+  get_key_value(rb_tree::RBTree<Range<T>, V, P> const &t, T const &k) const {
     if (t.empty()) {
       return std::nullopt;
     }
@@ -145,7 +146,7 @@ private:
   // Return true if range r partially or completely overlaps with any range
   // stored in the ordered map t that is passed as an argument.
   [[nodiscard]] bool
-  overlaps(rb_tree::RBTree<Range<T>, V> const &t, Range<T> const &r) const {
+  overlaps(rb_tree::RBTree<Range<T>, V, P> const &t, Range<T> const &r) const {
     if (t.empty()) {
       return false;
     }
@@ -177,7 +178,7 @@ private:
   // Gather all <Range<T>, V> pairs in t that are overlapping or directly
   // adjacent (share a boundary) with range r, in v.
   void get_overlapping_or_adjacent_ranges(
-      rb_tree::RBTree<Range<T>, V> const &t, Range<T> const &r,
+      rb_tree::RBTree<Range<T>, V, P> const &t, Range<T> const &r,
       std::vector<std::pair<Range<T>, V>> &v) const {
     if (t.empty()) {
       return;
@@ -227,7 +228,7 @@ private:
 
   // Gather all <Range, V> pairs in t that are overlapping with range r, in v.
   void get_overlapping_ranges(
-      rb_tree::RBTree<Range<T>, V> const &t, Range<T> const &r,
+      rb_tree::RBTree<Range<T>, V, P> const &t, Range<T> const &r,
       std::vector<std::pair<Range<T>, V>> &v) const {
     if (t.empty()) {
       return;
@@ -314,7 +315,7 @@ private:
 public:
   // Create an empty rangemap.
   RangeMap()
-      : treemap_(rb_tree::RBTree<Range<T>, V>()) { }
+      : treemap_(rb_tree::RBTree<Range<T>, V, P>()) { }
 
   // Create a rangemap with elements from the container designated by the
   // beginning and end iterator arguments. The container should contain elements
@@ -337,10 +338,19 @@ public:
   RangeMap &operator=(RangeMap &&other) = default;
 
   // Getter for the rb-tree underlying this rangemap.
-  [[nodiscard]] rb_tree::RBTree<Range<T>, V> treemap() const {
+  [[nodiscard]] rb_tree::RBTree<Range<T>, V, P> treemap() const {
     return treemap_;
   }
 
+  // Return a reference to the rb-tree underlying this rangemap, so that the
+  // garbage collector can move its nodes; see RBTree::migrate.
+  rb_tree::RBTree<Range<T>, V, P> &treemap_mutable() { return treemap_; }
+
+  // Return true if this rangemap and m are represented by the same tree.
+  [[nodiscard]] bool shares_tree(RangeMap const &m) const {
+    return treemap_.shares_root(m.treemap_);
+  }
+
   // Return the number of key ranges in the map.
   [[nodiscard]] size_t size() const { return treemap_.size(); }
 
@@ -392,7 +402,7 @@ public:
     // these changes.
     T is = r.start();
     T ie = r.end();
-    rb_tree::RBTree<Range<T>, V> tmpmap = treemap_;
+    rb_tree::RBTree<Range<T>, V, P> tmpmap = treemap_;
     for (auto &p : ranges) {
       Range<T> rr = p.first;
       V rv = p.second;
@@ -455,7 +465,7 @@ public:
     // these changes.
     T const &ds = r.start();
     T const &de = r.end();
-    rb_tree::RBTree<Range<T>, V> tmpmap = treemap_;
+    rb_tree::RBTree<Range<T>, V, P> tmpmap = treemap_;
     for (auto &p : ranges) {
       Range<T> rr = p.first;
       V rv = p.second;
@@ -550,17 +560,17 @@ public:
 // Instead we only need to iterate. Therefore, these iterators provide
 // prefix increment operator, dereference operator, arrow operator, and a
 // function that tests if there are more elements instead of equality operator.
-template <class T, class V>
+template <class T, class V, class P = rb_tree::refcount_policy>
 class AbstractRangeMapIterator {
 
 private:
-  std::stack<rb_tree::RBTree<Range<T>, V>> stack_{};
+  std::stack<rb_tree::RBTree<Range<T>, V, P>> stack_{};
 
 protected:
   [[nodiscard]] auto const &stack() const { return stack_; }
 
-  void update_stack_state(rb_tree::RBTree<Range<T>, V> const &t) {
-    rb_tree::RBTree<Range<T>, V> tmp = t;
+  void update_stack_state(rb_tree::RBTree<Range<T>, V, P> const &t) {
+    rb_tree::RBTree<Range<T>, V, P> tmp = t;
     while (!tmp.empty()) {
       stack_.push(tmp);
       tmp = tmp.left();
@@ -568,14 +578,14 @@ protected:
   }
 
   // Create an iterator over rangemap m.
-  AbstractRangeMapIterator(RangeMap<T, V> m) {
+  AbstractRangeMapIterator(RangeMap<T, V, P> const &m) {
     update_stack_state(m.treemap());
   }
 
 public:
   // Prefix increment operator.
   void operator++() {
-    rb_tree::RBTree<Range<T>, V> const &t = stack_.top();
+    rb_tree::RBTree<Range<T>, V, P> const &t = stack_.top();
     stack_.pop();
     update_stack_state(t.right());
   }
@@ -584,23 +594,23 @@ public:
   [[nodiscard]] bool has_next() const { return !stack_.empty(); }
 };
 
-template <class T, class V>
-class ConstRangeMapIterator : public AbstractRangeMapIterator<T, V> {
+template <class T, class V, class P = rb_tree::refcount_policy>
+class ConstRangeMapIterator : public AbstractRangeMapIterator<T, V, P> {
 
 public:
   // Create an iterator over rangemap m.
-  ConstRangeMapIterator(RangeMap<T, V> m)
-      : AbstractRangeMapIterator<T, V>(m) { }
+  ConstRangeMapIterator(RangeMap<T, V, P> const &m)
+      : AbstractRangeMapIterator<T, V, P>(m) { }
 
   // Dereference operator.
   std::pair<Range<T>, V> const &operator*() const {
-    rb_tree::RBTree<Range<T>, V> const &t = this->stack().top();
+    rb_tree::RBTree<Range<T>, V, P> const &t = this->stack().top();
     return t.root_data();
   }
 
   // Member access (arrow) operator.
   std::pair<Range<T>, V> const *operator->() const {
-    rb_tree::RBTree<Range<T>, V> const &t = this->stack().top();
+    rb_tree::RBTree<Range<T>, V, P> const &t = this->stack().top();
     return &t.root_data();
   }
 };
@@ -616,25 +626,25 @@ public:
  * (see include/runtime/header.h). Only request a RangeMapIterator instead of *
  * a ConstRangeMapIterator if you in fact need to edit the data structure in  *
  * place for a specific reason, e.g. garbage collection.                      */
-template <class T, class V>
-class RangeMapIterator : public AbstractRangeMapIterator<T, V> {
+template <class T, class V, class P = rb_tree::refcount_policy>
+class RangeMapIterator : public AbstractRangeMapIterator<T, V, P> {
 
 public:
-  using AbstractRangeMapIterator<T, V>::stack_;
+  using AbstractRangeMapIterator<T, V, P>::stack_;
 
   // Create an iterator over rangemap m.
-  RangeMapIterator(RangeMap<T, V> m)
-      : AbstractRangeMapIterator<T, V>(m) { }
+  RangeMapIterator(RangeMap<T, V, P> const &m)
+      : AbstractRangeMapIterator<T, V, P>(m) { }
 
   // Non-const dereference operator.
   std::pair<Range<T>, V> &operator*() {
-    rb_tree::RBTree<Range<T>, V> &t = stack_.top();
+    rb_tree::RBTree<Range<T>, V, P> &t = stack_.top();
     return t.root_data_mutable();
   }
 
   // Non-const member access (arrow) operator.
   std::pair<Range<T>, V> *operator->() {
-    rb_tree::RBTree<Range<T>, V> &t = stack_.top();
+    rb_tree::RBTree<Range<T>, V, P> &t = stack_.top();
     return &t.root_data_mutable();
   }
 };
@@ -642,8 +652,8 @@ public:
 // Return a rangemap with all elements in m, and then also from the container
 // designated by the beginning and end iterator arguments. The container should
 // contain elements of type std::pair<Range<T>, V>.
-template <class T, class V, class I>
-RangeMap<T, V> inserted(RangeMap<T, V> const &m, I it, I end) {
+template <class T, class V, class P, class I>
+RangeMap<T, V, P> inserted(RangeMap<T, V, P> const &m, I it, I end) {
   if (it == end) {
     return m;
   }
@@ -656,8 +666,8 @@ RangeMap<T, V> inserted(RangeMap<T, V> const &m, I it, I end) {
 // Apply function f to all elements of rangemap m.
 // Function f must accept two arguments of types T, corresponding to the start
 // and end of a range, and one of type V correspondong to the mapped value.
-template <class T, class V, class F>
-void for_each(RangeMap<T, V> const &m, F &&f) {
+template <class T, class V, class P, class F>
+void for_each(RangeMap<T, V, P> const &m, F &&f) {
   for_each(m.treemap(), [&f](Range<T> const &x, V const &v) {
     std::invoke(f, x.start(), x.end(), v);
   });
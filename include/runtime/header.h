@@ -1,6 +1,7 @@
 #ifndef RUNTIME_HEADER_H
 #define RUNTIME_HEADER_H
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <limits>
@@ -89,6 +90,18 @@ using floating_hdr = struct floating_hdr {
   floating f;
 };
 
+// The pre-encoded binary KORE for a symbol, emitted at kompile time for each
+// tag; see kllvm::symbol_fragment for the meaning of each field.
+// llvm: binary_fragment = type { i32, i32, i32, i32, i32, [0 x i8] }
+using binary_fragment = struct binary_fragment {
+  uint32_t size;
+  uint32_t symbol_begin;
+  uint32_t name_begin;
+  uint32_t name_end;
+  uint32_t is_injection;
+  char data[];
+};
+
 using layoutitem = struct layoutitem {
   uint64_t offset;
   uint16_t cat;
@@ -111,8 +124,9 @@ size_t hash_k(block *);
 void k_hash(block *, void *);
 bool hash_enter(void);
 void hash_exit(void);
+void reset_hash_state(void);
 
-extern bool gc_enabled;
+extern constinit KORE_THREAD_LOCAL bool gc_enabled;
 }
 
 __attribute__((always_inline)) constexpr uint64_t len_hdr(uint64_t hdr) {
@@ -262,7 +276,8 @@ using map = immer::map<
     k_elem, k_elem, hash_block, std::equal_to<>, list::memory_policy>;
 using set
     = immer::set<k_elem, hash_block, std::equal_to<>, list::memory_policy>;
-using rangemap = rng_map::RangeMap<k_elem, k_elem>;
+using rangemap = rng_map::RangeMap<
+    k_elem, k_elem, rb_tree::heap_policy<kore_alloc_heap>>;
 
 using mapiter = struct mapiter {
   map::iterator curr{};
@@ -300,6 +315,10 @@ extern "C" {
 
 block *parse_configuration(char const *filename);
 block *deserialize_configuration(char *, size_t);
+// Read the next pattern from a binary KORE stream written by
+// serialize_configuration_to_stream, advancing *data past it.
+block *deserialize_configuration_from_stream(
+    char **data, char *end, kllvm::stream_dictionary *dictionary);
 
 void print_configuration(FILE *file, block *subject);
 void print_statistics(FILE *file, uint64_t steps);
@@ -338,6 +357,14 @@ void serialize_configuration(
     bool emit_size, bool use_intern);
 void serialize_configuration_to_file(
     FILE *file, block *subject, bool emit_size, bool use_intern);
+
+// Write a configuration as the next pattern of a binary KORE stream. Symbol
+// and sort names are only written out in full the first time they appear in
+// the stream; the caller should use the same dictionary for every pattern
+// written to one stream, and read them back with the same discipline.
+void serialize_configuration_to_stream(
+    FILE *file, block *subject, char const *sort,
+    kllvm::stream_dictionary *dictionary);
 void serialize_term_to_file(
     FILE *file, void *subject, char const *sort, bool use_intern,
     bool k_item_inj = false);
@@ -345,6 +372,20 @@ void serialize_raw_term_to_file(
     FILE *file, void *subject, char const *sort, bool use_intern);
 void serialize_configuration_to_proof_trace(
     FILE *file, block *subject, uint32_t sort);
+
+// Set by the interpreter's main function, which is the only caller of
+// take_steps that does not keep another reference to the configuration it
+// passes in; rules compiled with --in-place-rewrite only update the
+// configuration in place when this is true.
+extern bool in_place_rewrite;
+
+// Checkpoints of a rewrite in progress, written at the top of k_step and read
+// back by --resume; see runtime/util/checkpoint.cpp for the format.
+extern std::atomic<bool> time_for_checkpoint;
+void init_checkpoint(void);
+void kore_checkpoint(block *subject);
+void write_checkpoint(char const *filename, block *subject);
+block *read_checkpoint(char const *filename);
 void serialize_term_to_proof_trace(
     FILE *file, void *subject, uint64_t block_header, uint64_t bits);
 
@@ -394,6 +435,7 @@ uint32_t get_injection_for_sort_of_tag(uint32_t tag);
 bool hook_STRING_eq(SortString, SortString);
 
 char const *get_symbol_name_for_tag(uint32_t tag);
+binary_fragment const *get_binary_fragment_for_tag(uint32_t tag);
 char const *get_return_sort_for_tag(uint32_t tag);
 char const **get_argument_sorts_for_tag(uint32_t tag);
 uint32_t *
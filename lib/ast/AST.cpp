@@ -1614,7 +1614,7 @@ void kore_string_pattern::serialize_to(serializer &s) const {
 
 void kore_sort_variable::serialize_to(serializer &s) const {
   s.emit(header_byte<kore_sort_variable>);
-  s.emit_string(name_);
+  s.emit_name(name_);
 }
 
 void kore_composite_sort::serialize_to(serializer &s) const {
@@ -1624,7 +1624,7 @@ void kore_composite_sort::serialize_to(serializer &s) const {
 
   s.emit(header_byte<kore_composite_sort>);
   s.emit_length(arguments_.size());
-  s.emit_string(name_);
+  s.emit_name(name_);
 }
 
 void kore_symbol::serialize_to(serializer &s) const {
@@ -1634,7 +1634,7 @@ void kore_symbol::serialize_to(serializer &s) const {
 
   s.emit(header_byte<kore_symbol>);
   s.emit_length(formal_arguments_.size());
-  s.emit_string(name_);
+  s.emit_name(name_);
 }
 
 void kore_variable::serialize_to(serializer &s) const {
@@ -0,0 +1,75 @@
+#include <kllvm/ast/AST.h>
+#include <kllvm/ast/arena.h>
+
+#include <algorithm>
+#include <memory>
+
+namespace kllvm {
+
+void *ast_arena::allocate(size_t size, size_t align) {
+  void *ptr = next_;
+  auto space = static_cast<size_t>(end_ - next_);
+
+  if (!next_ || !std::align(align, size, ptr, space)) {
+    auto new_block_size = std::max(block_size, size + align);
+    blocks_.emplace_back(new std::byte[new_block_size]);
+
+    next_ = blocks_.back().get();
+    end_ = next_ + new_block_size;
+
+    ptr = next_;
+    space = new_block_size;
+    std::align(align, size, ptr, space);
+  }
+
+  next_ = static_cast<std::byte *>(ptr) + size;
+  bytes_allocated_ += size;
+  return ptr;
+}
+
+std::string_view ast_arena::intern(std::string_view str) {
+  if (auto it = strings_.find(str); it != strings_.end()) {
+    return *it;
+  }
+
+  auto *data = static_cast<char *>(allocate(str.size(), 1));
+  std::copy(str.begin(), str.end(), data);
+  return *strings_.emplace(data, str.size()).first;
+}
+
+std::shared_ptr<kore_composite_sort> ast_arena::composite_sort(
+    std::string_view name,
+    std::vector<std::shared_ptr<kore_sort>> const &arguments) {
+  auto key = sort_key{intern(name), {}};
+  key.arguments.reserve(arguments.size());
+  for (auto const &arg : arguments) {
+    key.arguments.push_back(arg.get());
+  }
+
+  if (auto it = composite_sorts_.find(key); it != composite_sorts_.end()) {
+    return it->second;
+  }
+
+  auto sort = make<kore_composite_sort>(
+      std::string(key.name), value_type{sort_category::Uncomputed, 0});
+  for (auto const &arg : arguments) {
+    sort->add_argument(arg);
+  }
+
+  composite_sorts_.emplace(std::move(key), sort);
+  return sort;
+}
+
+std::shared_ptr<kore_sort_variable>
+ast_arena::sort_variable(std::string_view name) {
+  auto interned = intern(name);
+  if (auto it = sort_variables_.find(interned); it != sort_variables_.end()) {
+    return it->second;
+  }
+
+  auto var = make<kore_sort_variable>(std::string(interned));
+  sort_variables_.emplace(interned, var);
+  return var;
+}
+
+} // namespace kllvm
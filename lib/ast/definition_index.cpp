@@ -0,0 +1,160 @@
+#include <kllvm/ast/definition_index.h>
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace kllvm {
+
+namespace {
+
+constexpr auto magic = std::array{'\x7f', 'K', 'D', 'I'};
+
+template <typename T>
+void write_value(std::ostream &os, T val) {
+  os.write(reinterpret_cast<char const *>(&val), sizeof(T));
+}
+
+void write_string(std::ostream &os, std::string const &str) {
+  write_value<uint32_t>(os, str.size());
+  os.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+
+class index_reader {
+public:
+  index_reader(char const *begin, char const *end)
+      : ptr_(begin)
+      , end_(end) { }
+
+  template <typename T>
+  T read_value() {
+    if (end_ - ptr_ < sizeof(T)) {
+      throw std::runtime_error("truncated definition index");
+    }
+    auto val = T{};
+    std::memcpy(&val, ptr_, sizeof(T));
+    ptr_ += sizeof(T);
+    return val;
+  }
+
+  std::string read_string() {
+    auto len = read_value<uint32_t>();
+    if (end_ - ptr_ < len) {
+      throw std::runtime_error("truncated definition index");
+    }
+    auto str = std::string(ptr_, len);
+    ptr_ += len;
+    return str;
+  }
+
+private:
+  char const *ptr_;
+  char const *end_;
+};
+
+} // namespace
+
+definition_index definition_index::build(kore_definition const &definition) {
+  auto index = definition_index{};
+
+  for (auto *axiom : definition.get_axioms()) {
+    if (axiom->attributes().contains(attribute_set::key::Label)) {
+      index.label_ordinals_.emplace(
+          axiom->attributes().get_string(attribute_set::key::Label),
+          axiom->get_ordinal());
+    }
+  }
+
+  for (auto const &[tag, symbol] : definition.get_symbols()) {
+    index.symbol_tags_.emplace(ast_to_string(*symbol), tag);
+  }
+
+  return index;
+}
+
+definition_index definition_index::load(std::string const &path) {
+  auto in = std::ifstream(path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("could not open definition index: " + path);
+  }
+
+  auto data = std::string(
+      std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  auto reader = index_reader(data.data(), data.data() + data.size());
+
+  for (auto c : magic) {
+    if (reader.read_value<char>() != c) {
+      throw std::runtime_error("invalid magic in definition index: " + path);
+    }
+  }
+
+  if (reader.read_value<uint32_t>() != version) {
+    throw std::runtime_error("invalid definition index version: " + path);
+  }
+
+  auto num_labels = reader.read_value<uint32_t>();
+  auto num_symbols = reader.read_value<uint32_t>();
+
+  auto index = definition_index{};
+  index.label_ordinals_.reserve(num_labels);
+  index.symbol_tags_.reserve(num_symbols);
+
+  for (uint32_t i = 0; i < num_labels; ++i) {
+    auto label = reader.read_string();
+    index.label_ordinals_.emplace(
+        std::move(label), reader.read_value<uint64_t>());
+  }
+
+  for (uint32_t i = 0; i < num_symbols; ++i) {
+    auto symbol = reader.read_string();
+    index.symbol_tags_.emplace(
+        std::move(symbol), reader.read_value<uint32_t>());
+  }
+
+  return index;
+}
+
+void definition_index::write(std::ostream &os) const {
+  os.write(magic.data(), magic.size());
+  write_value<uint32_t>(os, version);
+  write_value<uint32_t>(os, label_ordinals_.size());
+  write_value<uint32_t>(os, symbol_tags_.size());
+
+  for (auto const &[label, ordinal] : label_ordinals_) {
+    write_string(os, label);
+    write_value<uint64_t>(os, ordinal);
+  }
+
+  for (auto const &[symbol, tag] : symbol_tags_) {
+    write_string(os, symbol);
+    write_value<uint32_t>(os, tag);
+  }
+}
+
+void definition_index::write(std::string const &path) const {
+  auto os = std::ofstream(path, std::ios::binary);
+  if (!os) {
+    throw std::runtime_error("could not open definition index: " + path);
+  }
+  write(os);
+}
+
+std::optional<uint64_t>
+definition_index::get_ordinal_for_label(std::string const &label) const {
+  if (auto it = label_ordinals_.find(label); it != label_ordinals_.end()) {
+    return it->second;
+  }
+  return std::nullopt;
+}
+
+std::optional<uint32_t>
+definition_index::get_tag_for_symbol(std::string const &symbol) const {
+  if (auto it = symbol_tags_.find(symbol); it != symbol_tags_.end()) {
+    return it->second;
+  }
+  return std::nullopt;
+}
+
+} // namespace kllvm
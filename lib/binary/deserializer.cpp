@@ -32,9 +32,10 @@ bool has_binary_kore_header(std::string const &filename) {
   return std::equal(reference.begin(), reference.end(), first_bytes.begin());
 }
 
-sptr<kore_pattern> deserialize_pattern(std::string const &filename) {
+sptr<kore_pattern>
+deserialize_pattern(std::string const &filename, ast_arena *arena) {
   auto data = file_contents(filename);
-  return deserialize_pattern(data.begin(), data.end());
+  return deserialize_pattern(data.begin(), data.end(), true, arena);
 }
 
 // NOLINTNEXTLINE(*-cognitive-complexity)
@@ -1,6 +1,8 @@
 #include <kllvm/binary/serializer.h>
 #include <kllvm/binary/version.h>
 
+#include <stdexcept>
+
 namespace kllvm {
 
 namespace detail {
@@ -16,12 +18,53 @@ bool is_big_endian() {
 serializer::serializer()
     : serializer(NONE) { }
 
+std::optional<uint64_t> stream_dictionary::find(std::string_view str) const {
+  if (auto it = indices_.find(str); it != indices_.end()) {
+    return it->second;
+  }
+  return std::nullopt;
+}
+
+std::optional<uint64_t> stream_dictionary::find_key(uint64_t key) const {
+  if (key < keys_.size() && keys_[key] != 0) {
+    return keys_[key] - 1;
+  }
+  return std::nullopt;
+}
+
+uint64_t stream_dictionary::add(std::string_view str) {
+  auto index = entries_.size();
+  entries_.emplace_back(str);
+  indices_.emplace(entries_.back(), index);
+  return index;
+}
+
+void stream_dictionary::add_key(uint64_t key, uint64_t index) {
+  if (key >= keys_.size()) {
+    keys_.resize(key + 1, 0);
+  }
+  keys_[key] = index + 1;
+}
+
+std::string const &stream_dictionary::at(uint64_t index) const {
+  if (index >= entries_.size()) {
+    throw std::runtime_error("invalid binary KORE stream dictionary index");
+  }
+  return entries_[index];
+}
+
 serializer::serializer(flags f)
+    : serializer(f, nullptr) { }
+
+serializer::serializer(flags f, stream_dictionary *dictionary)
     : use_header_(!(f & DropHeader))
     , use_arity_(!(f & DropArity))
     , use_intern_(!(f & NoIntern))
     , direct_string_prefix_{0x01}
     , backref_string_prefix_{0x02}
+    , dictionary_string_prefix_{0x03}
+    , dictionary_ref_prefix_{0x04}
+    , dictionary_(dictionary)
     , next_idx_(0) {
   if (use_header_) {
     emit_header_and_version();
@@ -44,6 +87,7 @@ void serializer::reset() {
   buffer_.clear();
   next_idx_ = 0;
   intern_table_.clear();
+  keyed_intern_table_.clear();
 
   if (use_header_) {
     emit_header_and_version();
@@ -60,9 +104,10 @@ void serializer::emit_header_and_version() {
     emit(b);
   }
 
-  emit(version.v_major);
-  emit(version.v_minor);
-  emit(version.v_patch);
+  auto const &v = dictionary_ ? stream_version : version;
+  emit(v.v_major);
+  emit(v.v_minor);
+  emit(v.v_patch);
 }
 
 void serializer::emit_zero_size() {
@@ -85,25 +130,157 @@ void serializer::emit(char b) {
   next_idx_++;
 }
 
-void serializer::emit_string(std::string const &s) {
+void serializer::emit_string(std::string_view s) {
   if (!use_intern_) {
     emit_direct_string(s);
     return;
   }
-  if (intern_table_.find(s) == intern_table_.end()) {
+  if (auto it = intern_table_.find(s); it != intern_table_.end()) {
+    emit_backref(it->second);
+  } else {
     emit_direct_string(s);
+  }
+}
+
+void serializer::emit_backref(uint64_t previous) {
+  emit(backref_string_prefix_);
+
+  // This iteration makes sure that the diff field correctly encodes the
+  // offset relative to _itself_ as well as to the prefix.
+  uint64_t base_diff = next_idx_ - previous;
+  auto chunks = required_chunks(base_diff + required_chunks(base_diff));
+
+  emit_length(base_diff + chunks);
+}
+
+void serializer::emit_bytes(std::string_view bytes) {
+  buffer_.append(bytes);
+  next_idx_ += bytes.size();
+}
+
+void serializer::emit_sorts(std::string_view sorts) {
+  auto idx = size_t{0};
+
+  auto copy_length = [&] {
+    auto begin = idx;
+    while (sorts[idx] & 0x80) {
+      ++idx;
+    }
+    ++idx;
+    emit_bytes(sorts.substr(begin, idx - begin));
+  };
+
+  auto read_name = [&] {
+    // Skip over the direct string prefix, then decode the length field.
+    ++idx;
+    auto len = uint64_t{0};
+    auto shift = 0;
+    while (true) {
+      auto chunk = static_cast<uint8_t>(sorts[idx++]);
+      len |= static_cast<uint64_t>(chunk & 0x7F) << shift;
+      shift += 7;
+      if (!(chunk & 0x80)) {
+        break;
+      }
+    }
+
+    auto name = sorts.substr(idx, len);
+    idx += len;
+    return name;
+  };
+
+  while (idx < sorts.size()) {
+    auto header = sorts[idx++];
+    emit(header);
+
+    if (header == header_byte<kore_composite_sort>) {
+      copy_length();
+    } else if (header != header_byte<kore_sort_variable>) {
+      throw std::runtime_error("invalid header byte in pre-encoded sort");
+    }
+
+    emit_name(read_name());
+  }
+}
+
+void serializer::emit_fragment(
+    uint64_t key, std::string_view fragment, size_t name_begin,
+    size_t name_end) {
+  auto prefix = fragment.substr(0, name_begin);
+  auto suffix = fragment.substr(name_end);
+
+  if (dictionary_) {
+    // Skip over the direct string prefix and length field to recover the
+    // contents of the name.
+    auto name_data = name_begin + 1;
+    while (fragment[name_data] & 0x80) {
+      ++name_data;
+    }
+    ++name_data;
+
+    emit_bytes(prefix);
+    emit_keyed_name(key, fragment.substr(name_data, name_end - name_data));
+    emit_bytes(suffix);
+    return;
+  }
+
+  if (!use_intern_) {
+    emit_bytes(fragment);
+    return;
+  }
+
+  if (key < keyed_intern_table_.size() && keyed_intern_table_[key] != 0) {
+    emit_bytes(prefix);
+    emit_backref(keyed_intern_table_[key] - 1);
+    emit_bytes(suffix);
+    return;
+  }
+
+  if (key >= keyed_intern_table_.size()) {
+    keyed_intern_table_.resize(key + 1, 0);
+  }
+
+  // Backreferences point at the length field following the direct string
+  // prefix byte; the table stores one past that offset.
+  auto length_offset = next_idx_ + name_begin + 1;
+  keyed_intern_table_[key] = length_offset + 1;
+  emit_bytes(fragment);
+}
+
+void serializer::emit_name(std::string_view name) {
+  if (!dictionary_) {
+    emit_string(name);
+    return;
+  }
+
+  if (auto index = dictionary_->find(name)) {
+    emit_dictionary_ref(*index);
   } else {
-    emit(backref_string_prefix_);
+    emit_dictionary_string(name);
+  }
+}
 
-    uint64_t previous = intern_table_.at(s);
+void serializer::emit_keyed_name(uint64_t key, std::string_view name) {
+  if (!dictionary_) {
+    emit_string(name);
+    return;
+  }
 
-    // This iteration makes sure that the diff field correctly encodes the
-    // offset relative to _itself_ as well as to the prefix.
-    uint64_t base_diff = next_idx_ - previous;
-    auto chunks = required_chunks(base_diff + required_chunks(base_diff));
+  if (auto index = dictionary_->find_key(key)) {
+    emit_dictionary_ref(*index);
+    return;
+  }
 
-    emit_length(base_diff + chunks);
+  // The same name may already be in the dictionary without this key if it was
+  // previously emitted through emit_name.
+  auto index = dictionary_->find(name);
+  if (index) {
+    emit_dictionary_ref(*index);
+  } else {
+    index = emit_dictionary_string(name);
   }
+
+  dictionary_->add_key(key, *index);
 }
 
 int serializer::emit_length(uint64_t len) {
@@ -132,16 +309,28 @@ int serializer::required_chunks(uint64_t len) {
   return ret;
 }
 
-void serializer::emit_direct_string(std::string const &s) {
+void serializer::emit_direct_string(std::string_view s) {
   emit(direct_string_prefix_);
 
   if (use_intern_) {
-    intern_table_[s] = next_idx_;
+    intern_table_.insert_or_assign(std::string(s), next_idx_);
   }
 
   emit_length(s.size());
-  buffer_.append(s);
-  next_idx_ += s.size();
+  emit_bytes(s);
+}
+
+void serializer::emit_dictionary_ref(uint64_t index) {
+  emit(dictionary_ref_prefix_);
+  emit_length(index);
+}
+
+uint64_t serializer::emit_dictionary_string(std::string_view s) {
+  emit(dictionary_string_prefix_);
+  emit_length(s.size());
+  emit_bytes(s);
+
+  return dictionary_->add(s);
 }
 
 void emit_kore_rich_header(std::ostream &os, kore_definition *definition) {
@@ -217,4 +406,33 @@ void emit_kore_rich_header(std::ostream &os, kore_definition *definition) {
   }
 }
 
+symbol_fragment encode_symbol_fragment(kore_symbol const &symbol) {
+  auto flags = serializer::DropHeader | serializer::NoIntern;
+  auto s = serializer(static_cast<serializer::flags>(flags));
+
+  auto const &formals = symbol.get_formal_arguments();
+  auto is_injection = symbol.get_name() == "inj";
+  if (is_injection && formals.size() != 2) {
+    throw std::runtime_error("malformed injection symbol");
+  }
+
+  auto num_fixed_formals = is_injection ? 1 : formals.size();
+  for (size_t i = 0; i < num_fixed_formals; ++i) {
+    formals[i]->serialize_to(s);
+  }
+
+  auto symbol_begin = s.data().size();
+  s.emit(header_byte<kore_symbol>);
+  s.emit_length(formals.size());
+
+  auto name_begin = s.data().size();
+  s.emit_string(symbol.get_name());
+  auto name_end = s.data().size();
+
+  s.emit(header_byte<kore_composite_pattern>);
+  s.emit_length(symbol.get_arguments().size());
+
+  return {s.data(), symbol_begin, name_begin, name_end, is_injection};
+}
+
 } // namespace kllvm
@@ -24,6 +24,7 @@
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Target/TargetOptions.h>
+#include <llvm/Transforms/IPO/HotColdSplitting.h>
 #include <llvm/Transforms/Scalar.h>
 #include <llvm/Transforms/Utils.h>
 
@@ -106,6 +107,16 @@ void apply_kllvm_opt_passes(llvm::Module &mod, bool hidden_visibility) {
             llvm::createModuleToFunctionPassAdaptor(remove_dead_k_functions()));
       });
 
+  // Rules that a branch profile shows were never applied are marked cold
+  // during code generation; outline the code that calls them so that the hot
+  // paths through each decision tree stay compact.
+  if (!pgo_profile.empty()) {
+    pb.registerOptimizerLastEPCallback(
+        [](llvm::ModulePassManager &pm, OptimizationLevel level) {
+          pm.addPass(HotColdSplittingPass());
+        });
+  }
+
   // Create the pass manager.
   ModulePassManager mpm
       = pb.buildPerModuleDefaultPipeline(get_pass_opt_level());
@@ -114,6 +125,23 @@ void apply_kllvm_opt_passes(llvm::Module &mod, bool hidden_visibility) {
   mpm.run(mod, mam);
 }
 
+namespace {
+
+std::string get_host_features() {
+  auto features = SubtargetFeatures{};
+  auto host_features = StringMap<bool>{};
+
+  if (sys::getHostCPUFeatures(host_features)) {
+    for (auto &feat : host_features) {
+      features.AddFeature(feat.first(), feat.second);
+    }
+  }
+
+  return features.getString();
+}
+
+} // namespace
+
 void generate_object_file(llvm::Module &mod, llvm::raw_ostream &os) {
   if (keep_frame_pointer) {
     mod.setFramePointer(FramePointerKind::All);
@@ -128,16 +156,7 @@ void generate_object_file(llvm::Module &mod, llvm::raw_ostream &os) {
   auto const *target = TargetRegistry::lookupTarget(triple, error);
   auto cpu = sys::getHostCPUName();
 
-  auto features = SubtargetFeatures{};
-  auto host_features = StringMap<bool>{};
-
-  if (sys::getHostCPUFeatures(host_features)) {
-    for (auto &feat : host_features) {
-      features.AddFeature(feat.first(), feat.second);
-    }
-  }
-
-  auto features_string = features.getString();
+  auto features_string = get_host_features();
   auto options = TargetOptions{};
   options.GuaranteedTailCallOpt = true;
 
@@ -161,6 +180,13 @@ void generate_object_file(llvm::Module &mod, llvm::raw_ostream &os) {
   pm.run(mod);
 }
 
+std::string get_object_file_configuration() {
+  return fmt::format(
+      "{} {} {} -O{}{}", BACKEND_TARGET_TRIPLE, sys::getHostCPUName().str(),
+      get_host_features(), optimization_level.getValue(),
+      keep_frame_pointer ? " -fno-omit-frame-pointer" : "");
+}
+
 /* This function links the code generated module generated by
  * llvm-kompile-codegen with any llvm bitcode modules we wish to place in the
  * same translation unit as the code generated code during optimization. This
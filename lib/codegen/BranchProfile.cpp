@@ -0,0 +1,173 @@
+#include <kllvm/codegen/BranchProfile.h>
+#include <kllvm/codegen/Options.h>
+#include <kllvm/codegen/Util.h>
+
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Transforms/Utils/ModuleUtils.h>
+
+#include <fmt/format.h>
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+namespace kllvm {
+
+namespace {
+
+std::string const counters_prefix = "pgo_counters.";
+
+} // namespace
+
+branch_profile const &branch_profile::get() {
+  static auto path = std::string{};
+  static auto profile = branch_profile{};
+  if (path != pgo_profile) {
+    path = pgo_profile;
+    profile = path.empty() ? branch_profile{} : branch_profile::load(path);
+  }
+  return profile;
+}
+
+branch_profile branch_profile::load(std::string const &path) {
+  auto in = std::ifstream(path);
+  if (!in) {
+    throw std::runtime_error("could not open branch profile: " + path);
+  }
+
+  auto profile = branch_profile{};
+
+  auto line = std::string{};
+  while (std::getline(in, line)) {
+    auto delim = line.find('\t');
+    if (delim == std::string::npos) {
+      throw std::runtime_error("malformed line in branch profile: " + line);
+    }
+
+    auto counts = std::vector<uint64_t>{};
+    auto ss = std::istringstream(line.substr(delim + 1));
+    for (uint64_t count = 0; ss >> count;) {
+      counts.push_back(count);
+    }
+
+    auto &entry = profile.counts_[line.substr(0, delim)];
+    if (entry.empty()) {
+      entry = std::move(counts);
+    } else if (entry.size() == counts.size()) {
+      for (size_t i = 0; i < counts.size(); ++i) {
+        entry[i] += counts[i];
+      }
+    } else {
+      throw std::runtime_error(
+          "inconsistent counter sizes in branch profile: " + line);
+    }
+  }
+
+  return profile;
+}
+
+std::optional<std::vector<uint64_t>>
+branch_profile::get_counts(std::string const &key, size_t size) const {
+  if (auto it = counts_.find(key);
+      it != counts_.end() && it->second.size() == size) {
+    return it->second;
+  }
+  return std::nullopt;
+}
+
+std::string switch_profile_key(llvm::Function *fn, unsigned index) {
+  return fmt::format("{}:switch{}", fn->getName().str(), index);
+}
+
+std::string rule_profile_key(std::string const &rule) {
+  return fmt::format("rule:{}", rule);
+}
+
+llvm::GlobalVariable *
+get_profile_counters(llvm::Module *mod, std::string const &key, size_t size) {
+  auto *ty
+      = llvm::ArrayType::get(llvm::Type::getInt64Ty(mod->getContext()), size);
+  auto *global = mod->getOrInsertGlobal(counters_prefix + key, ty);
+  auto *global_var = llvm::cast<llvm::GlobalVariable>(global);
+
+  if (!global_var->hasInitializer()) {
+    global_var->setInitializer(llvm::ConstantAggregateZero::get(ty));
+  }
+
+  return global_var;
+}
+
+void emit_profile_increment(
+    llvm::GlobalVariable *counters, size_t index, llvm::BasicBlock *block) {
+  auto *i64_ty = llvm::Type::getInt64Ty(block->getContext());
+  auto *ptr = llvm::GetElementPtrInst::CreateInBounds(
+      counters->getValueType(), counters,
+      {llvm::ConstantInt::get(i64_ty, 0),
+       llvm::ConstantInt::get(i64_ty, index)},
+      "", block);
+
+  // Functions marked parallel can run on several threads at once, so the
+  // increment must be atomic; the counts are only read at exit, so no
+  // ordering is needed.
+  new llvm::AtomicRMWInst(
+      llvm::AtomicRMWInst::Add, ptr, llvm::ConstantInt::get(i64_ty, 1),
+      llvm::Align(8), llvm::AtomicOrdering::Monotonic, llvm::SyncScope::System,
+      block);
+}
+
+void emit_profile_registration(llvm::Module *mod) {
+  auto &ctx = mod->getContext();
+  auto *i64_ty = llvm::Type::getInt64Ty(ctx);
+  auto *ptr_ty = llvm::PointerType::getUnqual(ctx);
+  auto *entry_ty = llvm::StructType::get(ctx, {ptr_ty, ptr_ty, i64_ty});
+
+  auto counters = std::vector<llvm::GlobalVariable *>{};
+  for (auto &global : mod->globals()) {
+    if (std::string_view(global.getName()).starts_with(counters_prefix)) {
+      counters.push_back(&global);
+    }
+  }
+
+  if (counters.empty()) {
+    return;
+  }
+
+  auto entries = std::vector<llvm::Constant *>{};
+  for (auto *global : counters) {
+    auto key = global->getName().drop_front(counters_prefix.size()).str();
+    auto *key_cst = llvm::ConstantDataArray::getString(ctx, key, true);
+    auto *key_var = new llvm::GlobalVariable(
+        *mod, key_cst->getType(), true, llvm::GlobalValue::PrivateLinkage,
+        key_cst, "pgo_key." + key);
+
+    auto size = llvm::cast<llvm::ArrayType>(global->getValueType())
+                    ->getNumElements();
+    entries.push_back(llvm::ConstantStruct::get(
+        entry_ty, {key_var, global, llvm::ConstantInt::get(i64_ty, size)}));
+  }
+
+  auto *table_ty = llvm::ArrayType::get(entry_ty, entries.size());
+  auto *table = new llvm::GlobalVariable(
+      *mod, table_ty, true, llvm::GlobalValue::PrivateLinkage,
+      llvm::ConstantArray::get(table_ty, entries), "pgo_table");
+
+  auto *ctor = llvm::Function::Create(
+      llvm::FunctionType::get(llvm::Type::getVoidTy(ctx), false),
+      llvm::GlobalValue::InternalLinkage, "pgo_register", mod);
+  auto *block = llvm::BasicBlock::Create(ctx, "entry", ctor);
+
+  llvm::CallInst::Create(
+      get_or_insert_function(
+          mod, "register_branch_profile", llvm::Type::getVoidTy(ctx), ptr_ty,
+          i64_ty),
+      {table, llvm::ConstantInt::get(i64_ty, entries.size())}, "", block);
+  llvm::ReturnInst::Create(ctx, block);
+
+  llvm::appendToGlobalCtors(*mod, ctor, 65535);
+}
+
+} // namespace kllvm
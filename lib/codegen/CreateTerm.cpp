@@ -1,6 +1,8 @@
 #include "kllvm/codegen/CreateTerm.h"
 #include "kllvm/codegen/CreateStaticTerm.h"
 #include "kllvm/codegen/Debug.h"
+#include "kllvm/codegen/InPlace.h"
+#include "kllvm/codegen/Options.h"
 #include "kllvm/codegen/ProofEvent.h"
 #include "kllvm/codegen/Util.h"
 
@@ -16,10 +18,12 @@
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IRReader/IRReader.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Local.h"
 
 namespace kllvm {
 
@@ -699,6 +703,12 @@ static bool hook_is_collection_unit_or_element(std::string const &name) {
          || name == "RANGEMAP.unit" || name == "RANGEMAP.element";
 }
 
+static bool hook_is_ground_collection(std::string const &name) {
+  return name == "LIST.unit" || name == "LIST.element" || name == "LIST.concat"
+         || name == "MAP.unit" || name == "MAP.element" || name == "MAP.concat"
+         || name == "SET.unit" || name == "SET.element" || name == "SET.concat";
+}
+
 llvm::Value *create_term::create_hook(
     kore_composite_pattern *hook_att, kore_composite_pattern *pattern,
     std::string const &location_stack) {
@@ -782,6 +792,7 @@ llvm::Value *create_term::disable_gc() {
   llvm::Constant *global
       = module_->getOrInsertGlobal("gc_enabled", llvm::Type::getInt1Ty(ctx_));
   auto *global_var = llvm::cast<llvm::GlobalVariable>(global);
+  global_var->setThreadLocalMode(llvm::GlobalValue::GeneralDynamicTLSModel);
   auto *old_val = new llvm::LoadInst(
       llvm::Type::getInt1Ty(ctx_), global_var, "was_enabled", current_block_);
   new llvm::StoreInst(
@@ -793,6 +804,7 @@ void create_term::enable_gc(llvm::Value *was_enabled) {
   llvm::Constant *global
       = module_->getOrInsertGlobal("gc_enabled", llvm::Type::getInt1Ty(ctx_));
   auto *global_var = llvm::cast<llvm::GlobalVariable>(global);
+  global_var->setThreadLocalMode(llvm::GlobalValue::GeneralDynamicTLSModel);
   new llvm::StoreInst(was_enabled, global_var, current_block_);
 }
 
@@ -813,6 +825,7 @@ llvm::Value *create_term::create_function_call(
   bool impure = att.contains(attribute_set::key::Impure)
                 || !att.contains(attribute_set::key::Total);
 
+  spawn_parallel_calls(pattern, location_stack);
   int i = 0;
   for (auto const &sort : pattern->get_constructor()->get_arguments()) {
     auto *concrete_sort = dynamic_cast<kore_composite_sort *>(sort.get());
@@ -911,6 +924,150 @@ llvm::Value *create_term::create_function_call(
   return call;
 }
 
+bool create_term::is_parallel_call(kore_pattern *pattern) {
+  auto *composite = dynamic_cast<kore_composite_pattern *>(pattern);
+  if (!composite) {
+    return false;
+  }
+  auto const &decls = definition_->get_symbol_declarations();
+  auto decl = decls.find(composite->get_constructor()->get_name());
+  if (decl == decls.end()) {
+    return false;
+  }
+  // A call is only moved to another thread if evaluating it can neither fail
+  // nor have an effect, so that it does not matter when it is evaluated.
+  auto const &att = decl->second->attributes();
+  return att.contains(attribute_set::key::Function)
+         && att.contains(attribute_set::key::Parallel)
+         && att.contains(attribute_set::key::Total)
+         && !att.contains(attribute_set::key::Impure)
+         && !att.contains(attribute_set::key::Hook);
+}
+
+// Starts the calls to parallel functions among the children of a pattern as
+// tasks, other than the last, which is evaluated by the current thread while
+// the others run. Each task is joined when create_allocation reaches the call.
+void create_term::spawn_parallel_calls(
+    kore_composite_pattern *pattern, std::string const &location_stack) {
+  if (proof_hint_instrumentation) {
+    return;
+  }
+  std::vector<size_t> calls;
+  auto const &children = pattern->get_arguments();
+  for (size_t i = 0; i < children.size(); ++i) {
+    if (is_parallel_call(children[i].get())) {
+      calls.push_back(i);
+    }
+  }
+  if (calls.size() < 2) {
+    return;
+  }
+  calls.pop_back();
+  for (auto i : calls) {
+    std::string new_location = location_stack.empty()
+                                   ? fmt::format("{}", i)
+                                   : fmt::format("{}:{}", location_stack, i);
+    spawn_parallel_call(
+        dynamic_cast<kore_composite_pattern *>(children[i].get()),
+        new_location);
+  }
+}
+
+// The arguments of the call are evaluated by the current thread and stored
+// in an environment, together with space for the result, which a wrapper
+// function passes to the function on the thread that runs the task.
+// Collections are stored by value, so that the environment of a given
+// function always has the same layout.
+void create_term::spawn_parallel_call(
+    kore_composite_pattern *pattern, std::string const &location_stack) {
+  kore_symbol const *symbol = pattern->get_constructor();
+  auto fn_name = fmt::format("eval_{}", ast_to_string(*symbol, 0, false));
+  auto *return_sort
+      = dynamic_cast<kore_composite_sort *>(symbol->get_sort().get());
+  auto return_cat = return_sort->get_category(definition_);
+
+  std::vector<llvm::Value *> args;
+  std::vector<llvm::Type *> types{getvalue_type(return_cat, module_)};
+  int i = 0;
+  for (auto const &sort : symbol->get_arguments()) {
+    auto *concrete_sort = dynamic_cast<kore_composite_sort *>(sort.get());
+    auto cat = concrete_sort->get_category(definition_);
+    llvm::Value *arg = alloc_arg(pattern, i, location_stack);
+    i++;
+    auto *type = getvalue_type(cat, module_);
+    if (is_collection_sort(cat) && arg->getType()->isPointerTy()) {
+      arg = new llvm::LoadInst(type, arg, "", current_block_);
+    }
+    args.push_back(arg);
+    types.push_back(type);
+  }
+  auto *env_type = llvm::StructType::get(ctx_, types);
+
+  auto field = [&](llvm::Value *env, unsigned idx) {
+    return llvm::GetElementPtrInst::CreateInBounds(
+        env_type, env,
+        {llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx_), 0),
+         llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx_), idx)},
+        "", current_block_);
+  };
+
+  auto *ptr_ty = llvm::PointerType::getUnqual(ctx_);
+  auto *wrapper = get_or_insert_function(
+      module_, fmt::format("parallel_{}", fn_name), llvm::Type::getVoidTy(ctx_),
+      ptr_ty);
+  if (wrapper->empty()) {
+    wrapper->setLinkage(llvm::GlobalValue::InternalLinkage);
+    auto *caller_block = current_block_;
+    current_block_ = llvm::BasicBlock::Create(ctx_, "entry", wrapper);
+    auto *env = wrapper->arg_begin();
+    std::vector<llvm::Value *> env_args;
+    for (unsigned idx = 1; idx < types.size(); ++idx) {
+      llvm::Value *arg = field(env, idx);
+      if (!types[idx]->isStructTy()) {
+        arg = new llvm::LoadInst(types[idx], arg, "", current_block_);
+      }
+      env_args.push_back(arg);
+    }
+    llvm::Value *result = create_function_call(
+        fn_name, return_cat, env_args, false, true, false);
+    if (is_collection_sort(return_cat)) {
+      result = new llvm::LoadInst(types[0], result, "", current_block_);
+    }
+    new llvm::StoreInst(result, field(env, 0), current_block_);
+    llvm::ReturnInst::Create(ctx_, current_block_);
+    current_block_ = caller_block;
+  }
+
+  auto *env = allocate_term(env_type, current_block_, "kore_alloc_always_gc");
+  for (unsigned idx = 1; idx < types.size(); ++idx) {
+    new llvm::StoreInst(args[idx - 1], field(env, idx), current_block_);
+  }
+  auto *task = llvm::CallInst::Create(
+      get_or_insert_function(module_, "kore_spawn", ptr_ty, ptr_ty, ptr_ty),
+      {wrapper, env}, "task", current_block_);
+  set_debug_loc(task);
+  parallel_calls_[pattern] = {task, env, env_type, return_cat};
+}
+
+llvm::Value *create_term::join_parallel_call(parallel_call const &call) {
+  auto *join = llvm::CallInst::Create(
+      get_or_insert_function(
+          module_, "kore_join", llvm::Type::getVoidTy(ctx_),
+          llvm::PointerType::getUnqual(ctx_)),
+      {call.task}, "", current_block_);
+  set_debug_loc(join);
+  llvm::Value *result = llvm::GetElementPtrInst::CreateInBounds(
+      call.env_type, call.env,
+      {llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx_), 0),
+       llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx_), 0)},
+      "", current_block_);
+  if (is_collection_sort(call.return_cat)) {
+    return result;
+  }
+  return new llvm::LoadInst(
+      call.env_type->getElementType(0), result, "", current_block_);
+}
+
 /* create a term, given the assumption that the created term will not be a
  * triangle injection pair */
 llvm::Value *create_term::not_injection_case(
@@ -924,15 +1081,21 @@ llvm::Value *create_term::not_injection_case(
       = get_block_header(module_, definition_, symbol, block_type);
   int idx = 0;
   std::vector<llvm::Value *> children;
+  // for each element of children, the child of the pattern it belongs to
+  std::vector<int> child_idx;
   bool is_injection
       = symbol_decl->attributes().contains(attribute_set::key::SortInjection);
   assert(!is_injection || constructor->get_arguments().size() == 1);
+  if (val == nullptr) {
+    spawn_parallel_calls(constructor, location_stack);
+  }
   for (auto const &child : constructor->get_arguments()) {
     auto *sort = dynamic_cast<kore_composite_sort *>(child->get_sort().get());
     auto cat = sort->get_category(definition_);
     if (is_collection_sort(cat)) {
       children.push_back(get_offset_of_member(
           module_, block_type, get_block_offset(definition_, symbol, idx)));
+      child_idx.push_back(idx);
     }
     llvm::Value *child_value = nullptr;
     if (idx == 0 && val != nullptr) {
@@ -953,24 +1116,69 @@ llvm::Value *create_term::not_injection_case(
           child_value, "", current_block_);
     }
     children.push_back(child_value);
+    child_idx.push_back(idx);
     idx++;
   }
-  llvm::Value *block
-      = allocate_term(block_type, current_block_, "kore_alloc", true);
-  llvm::Value *block_header_ptr = llvm::GetElementPtrInst::CreateInBounds(
-      block_type, block,
-      {llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx_), 0),
-       llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx_), 0)},
-      symbol->get_name(), current_block_);
-  new llvm::StoreInst(block_header, block_header_ptr, current_block_);
-  idx = 2;
-  for (auto &child_value : children) {
-    llvm::Value *child_ptr = llvm::GetElementPtrInst::CreateInBounds(
+
+  auto store_children = [&](llvm::Value *block, auto should_store) {
+    for (size_t i = 0; i < children.size(); ++i) {
+      if (!should_store(child_idx[i])) {
+        continue;
+      }
+      llvm::Value *child_ptr = llvm::GetElementPtrInst::CreateInBounds(
+          block_type, block,
+          {llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx_), 0),
+           llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx_), i + 2)},
+          "", current_block_);
+      new llvm::StoreInst(children[i], child_ptr, current_block_);
+    }
+  };
+  auto allocate_block = [&]() {
+    llvm::Value *block
+        = allocate_term(block_type, current_block_, "kore_alloc", true);
+    llvm::Value *block_header_ptr = llvm::GetElementPtrInst::CreateInBounds(
         block_type, block,
         {llvm::ConstantInt::get(llvm::Type::getInt64Ty(ctx_), 0),
-         llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx_), idx++)},
-        "", current_block_);
-    new llvm::StoreInst(child_value, child_ptr, current_block_);
+         llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx_), 0)},
+        symbol->get_name(), current_block_);
+    new llvm::StoreInst(block_header, block_header_ptr, current_block_);
+    return block;
+  };
+
+  llvm::Value *block = nullptr;
+  auto reused = reused_blocks_.find(constructor);
+  if (reused == reused_blocks_.end()) {
+    block = allocate_block();
+    store_children(block, [](int) { return true; });
+  } else {
+    // The block matched by the rule already has the right header, and the
+    // children that the rule leaves unchanged, so only the other children
+    // need to be stored into it. If it could not be reused after all, a new
+    // block is allocated and the unchanged children copied into it first.
+    auto const &unchanged = reused->second.unchanged;
+    auto *old_block = reused->second.block;
+    llvm::Function *fn = current_block_->getParent();
+    auto *alloc_block = llvm::BasicBlock::Create(ctx_, "allocBlock", fn);
+    auto *reuse_block = llvm::BasicBlock::Create(ctx_, "reuseBlock", fn);
+    auto *is_null = new llvm::ICmpInst(
+        *current_block_, llvm::CmpInst::ICMP_EQ, old_block,
+        llvm::ConstantPointerNull::get(
+            llvm::cast<llvm::PointerType>(old_block->getType())));
+    llvm::BranchInst::Create(alloc_block, reuse_block, is_null, current_block_);
+    auto *reuse_pred = current_block_;
+
+    current_block_ = alloc_block;
+    auto *new_block = allocate_block();
+    store_children(new_block, [&](int i) { return unchanged[i]; });
+    llvm::BranchInst::Create(reuse_block, current_block_);
+
+    auto *phi = llvm::PHINode::Create(
+        old_block->getType(), 2, "reused", reuse_block);
+    phi->addIncoming(old_block, reuse_pred);
+    phi->addIncoming(new_block, current_block_);
+    current_block_ = reuse_block;
+    block = phi;
+    store_children(block, [&](int i) { return !unchanged[i]; });
   }
 
   auto *block_ptr = llvm::PointerType::getUnqual(module_->getContext());
@@ -989,6 +1197,11 @@ llvm::Value *create_term::not_injection_case(
 // injection
 std::pair<llvm::Value *, bool> create_term::operator()(kore_pattern *pattern) {
   populate_static_set(pattern);
+  // Building a ground term once means that the hook events for the functions
+  // in it are only emitted the first time it is evaluated.
+  if (!proof_hint_instrumentation) {
+    populate_ground_set(pattern);
+  }
 
   return create_allocation(pattern);
 }
@@ -1023,6 +1236,180 @@ bool create_term::populate_static_set(kore_pattern *pattern) {
   return can_be_static;
 }
 
+/* A ground term is one that contains no variables, and whose only functions
+ * are the constructors of lists, maps and sets. Such a term cannot be emitted
+ * as a constant like the terms in static_terms_, because the layout of a
+ * collection is only known to the runtime, but it always evaluates to the same
+ * value. */
+bool create_term::populate_ground_set(kore_pattern *pattern) {
+  auto *constructor = dynamic_cast<kore_composite_pattern *>(pattern);
+  if (!constructor) {
+    return false;
+  }
+
+  kore_symbol const *symbol = constructor->get_constructor();
+  if (symbol->get_name() == "\\dv") {
+    return true;
+  }
+
+  bool is_ground = true;
+  auto const &att = definition_->get_symbol_declarations()
+                        .at(symbol->get_name())
+                        ->attributes();
+  if (att.contains(attribute_set::key::Function)
+      || (att.contains(attribute_set::key::Anywhere) && !is_anywhere_owise_)) {
+    is_ground = att.contains(attribute_set::key::Hook)
+                && hook_is_ground_collection(
+                    att.get_string(attribute_set::key::Hook));
+  }
+  for (auto const &sptr_next_pattern : constructor->get_arguments()) {
+    is_ground &= populate_ground_set(sptr_next_pattern.get());
+  }
+
+  if (is_ground && !static_terms_.contains(pattern)) {
+    auto *sort = dynamic_cast<kore_composite_sort *>(symbol->get_sort().get());
+    switch (sort->get_category(definition_).cat) {
+    case sort_category::Map:
+    case sort_category::List:
+    case sort_category::Set:
+    case sort_category::Symbol: ground_terms_.insert(pattern); break;
+    default: break;
+    }
+  }
+
+  return is_ground;
+}
+
+/* A hook called while a ground term is being built may throw (e.g. MAP.concat
+ * of two maps with a key in common), and the exception may be caught by a
+ * caller that goes on to allocate. Each such call is made with an invoke, whose
+ * cleanup swaps the static arena back out of the young generation before the
+ * exception propagates further. */
+static void end_static_alloc_on_unwind(
+    llvm::Module *module, llvm::Function *fn,
+    std::vector<llvm::CallInst *> const &calls) {
+  if (calls.empty()) {
+    return;
+  }
+
+  auto &ctx = module->getContext();
+  auto *i32_ty = llvm::Type::getInt32Ty(ctx);
+  if (!fn->hasPersonalityFn()) {
+    fn->setPersonalityFn(get_or_insert_function(
+        module, "__gxx_personality_v0",
+        llvm::FunctionType::get(i32_ty, true)));
+  }
+
+  auto *cleanup = llvm::BasicBlock::Create(ctx, "groundUnwind", fn);
+  auto *landing_pad = llvm::LandingPadInst::Create(
+      llvm::StructType::get(ctx, {llvm::PointerType::getUnqual(ctx), i32_ty}),
+      0, "", cleanup);
+  landing_pad->setCleanup(true);
+  llvm::CallInst::Create(
+      get_or_insert_function(
+          module, "kore_static_alloc_end", llvm::Type::getVoidTy(ctx)),
+      {}, "", cleanup);
+  llvm::ResumeInst::Create(landing_pad, cleanup);
+
+  for (auto *call : calls) {
+    llvm::changeToInvokeAndSplitBasicBlock(call, cleanup);
+  }
+}
+
+/* Ground terms are built the first time they are evaluated, into an arena that
+ * is never collected, and the result is cached in a global variable so that
+ * every later evaluation shares the same term. Parallel functions may build the
+ * same term on several threads at once, so the cache is read with an acquire
+ * load and published with a compare-and-swap that keeps the first term stored;
+ * a thread that loses the race uses that term and leaves its own to leak. */
+std::pair<llvm::Value *, bool> create_term::create_ground_term(
+    kore_pattern *pattern, std::string const &location_stack) {
+  auto *ptr_ty = llvm::PointerType::getUnqual(ctx_);
+  auto *void_ty = llvm::Type::getVoidTy(ctx_);
+  auto *null = llvm::ConstantPointerNull::get(ptr_ty);
+
+  std::ostringstream kore_string;
+  pattern->print(kore_string);
+  auto *global_var = llvm::cast<llvm::GlobalVariable>(
+      module_->getOrInsertGlobal("ground_" + kore_string.str(), ptr_ty));
+  if (!global_var->hasInitializer()) {
+    global_var->setInitializer(null);
+  }
+
+  auto align = module_->getDataLayout().getABITypeAlign(ptr_ty);
+  auto *cached = new llvm::LoadInst(
+      ptr_ty, global_var, "", false, align, llvm::AtomicOrdering::Acquire,
+      llvm::SyncScope::System, current_block_);
+  auto *is_built = new llvm::ICmpInst(
+      *current_block_, llvm::CmpInst::ICMP_NE, cached, null);
+  auto *cached_block = current_block_;
+  auto *build_block = llvm::BasicBlock::Create(
+      ctx_, "buildGround", current_block_->getParent());
+  auto *merge_block = llvm::BasicBlock::Create(
+      ctx_, "ground", current_block_->getParent());
+  llvm::BranchInst::Create(merge_block, build_block, is_built, current_block_);
+
+  current_block_ = build_block;
+  auto *begin
+      = get_or_insert_function(module_, "kore_static_alloc_begin", void_ty);
+  begin->setDoesNotThrow();
+  llvm::CallInst::Create(begin, {}, "", current_block_);
+  in_ground_term_ = true;
+  auto result = create_allocation(pattern, location_stack);
+  in_ground_term_ = false;
+
+  // The term is built in build_block and in the blocks created since
+  // merge_block, which are appended to the end of the function.
+  auto *fn = build_block->getParent();
+  auto may_throw = std::vector<llvm::CallInst *>{};
+  auto collect_calls = [&](llvm::BasicBlock &block) {
+    for (auto &inst : block) {
+      auto *call = llvm::dyn_cast<llvm::CallInst>(&inst);
+      if (call && !call->doesNotThrow() && !call->isInlineAsm()
+          && !llvm::isa<llvm::IntrinsicInst>(call)) {
+        may_throw.push_back(call);
+      }
+    }
+  };
+  collect_calls(*build_block);
+  for (auto it = std::next(merge_block->getIterator()); it != fn->end(); ++it) {
+    collect_calls(*it);
+  }
+
+  llvm::CallInst::Create(
+      get_or_insert_function(module_, "kore_static_alloc_end", void_ty), {},
+      "", current_block_);
+
+  auto *sort = dynamic_cast<kore_composite_sort *>(pattern->get_sort().get());
+  auto cat = sort->get_category(definition_);
+  llvm::CallInst::Create(
+      get_or_insert_function(
+          module_, "make_static", void_ty, ptr_ty,
+          llvm::Type::getInt16Ty(ctx_)),
+      {result.first,
+       llvm::ConstantInt::get(
+           llvm::Type::getInt16Ty(ctx_), (int)cat.cat + cat.bits)},
+      "", current_block_);
+  auto *cmpxchg = new llvm::AtomicCmpXchgInst(
+      global_var, null, result.first, align,
+      llvm::AtomicOrdering::AcquireRelease, llvm::AtomicOrdering::Acquire,
+      llvm::SyncScope::System, current_block_);
+  auto *winner
+      = llvm::ExtractValueInst::Create(cmpxchg, {0}, "", current_block_);
+  auto *stored
+      = llvm::ExtractValueInst::Create(cmpxchg, {1}, "", current_block_);
+  auto *built = llvm::SelectInst::Create(
+      stored, result.first, winner, "", current_block_);
+  llvm::BranchInst::Create(merge_block, current_block_);
+
+  auto *phi = llvm::PHINode::Create(ptr_ty, 2, "", merge_block);
+  phi->addIncoming(cached, cached_block);
+  phi->addIncoming(built, current_block_);
+  current_block_ = merge_block;
+  end_static_alloc_on_unwind(module_, fn, may_throw);
+  return std::make_pair(phi, result.second);
+}
+
 std::pair<llvm::Value *, bool> create_term::create_allocation(
     kore_pattern *pattern, std::string const &location_stack) {
   if (static_terms_.contains(pattern)) {
@@ -1030,6 +1417,10 @@ std::pair<llvm::Value *, bool> create_term::create_allocation(
     return (*static_term)(pattern);
   }
 
+  if (ground_terms_.contains(pattern) && !in_ground_term_) {
+    return create_ground_term(pattern, location_stack);
+  }
+
   if (auto *variable = dynamic_cast<kore_variable_pattern *>(pattern)) {
     auto *val = substitution_.lookup(variable->get_name());
     if (!val) {
@@ -1052,6 +1443,12 @@ std::pair<llvm::Value *, bool> create_term::create_allocation(
             constructor, location_stack);
         return std::make_pair(val, true);
       }
+      if (auto call = parallel_calls_.find(pattern);
+          call != parallel_calls_.end()) {
+        auto *result = join_parallel_call(call->second);
+        parallel_calls_.erase(call);
+        return std::make_pair(result, true);
+      }
       auto fn_name = fmt::format("eval_{}", ast_to_string(*symbol, 0, false));
       std::vector<llvm::Value *> args;
       return std::make_pair(
@@ -1145,10 +1542,64 @@ bool can_tail_call(llvm::Type *type) {
   return int_type->getBitWidth() <= 192;
 }
 
+/* Loads each block that a rule may update in place from the configuration it
+ * rewrites. A block is only reused if the interpreter has enabled in-place
+ * rewriting and the block is in the young generation: constants and ground
+ * terms may be shared, and the garbage collector assumes that blocks in the
+ * old generation never point to younger ones. Otherwise it is null, and
+ * create_term allocates a new block as usual. */
+static llvm::BasicBlock *load_reused_blocks(
+    kore_definition *definition, llvm::Module *module,
+    std::map<kore_pattern *, reusable_block> const &blocks,
+    llvm::Value *subject, llvm::BasicBlock *entry,
+    std::map<kore_pattern *, reused_block> &result) {
+  auto &ctx = module->getContext();
+  auto *fn = entry->getParent();
+  auto *ptr_ty = llvm::PointerType::getUnqual(ctx);
+  auto *null = llvm::ConstantPointerNull::get(ptr_ty);
+  auto *load_block = llvm::BasicBlock::Create(ctx, "loadReused", fn);
+  auto *body = llvm::BasicBlock::Create(ctx, "body", fn);
+
+  auto builder = llvm::IRBuilder<>(entry);
+  auto *flag = module->getOrInsertGlobal(
+      "in_place_rewrite", llvm::Type::getInt1Ty(ctx));
+  auto *enabled = builder.CreateAnd(
+      builder.CreateLoad(llvm::Type::getInt1Ty(ctx), flag),
+      builder.CreateIsNotNull(subject));
+  builder.CreateCondBr(enabled, load_block, body);
+
+  builder.SetInsertPoint(load_block);
+  std::vector<std::pair<kore_pattern *, llvm::Value *>> loaded;
+  for (auto const &[pattern, block] : blocks) {
+    llvm::Value *ptr = subject;
+    for (auto const &[symbol, idx] : block.path) {
+      auto *block_type = get_block_type(module, definition, symbol);
+      auto *child_ptr = builder.CreateStructGEP(
+          block_type, ptr, get_block_offset(definition, symbol, idx));
+      ptr = builder.CreateLoad(ptr_ty, child_ptr);
+    }
+    auto *hdr = builder.CreateLoad(builder.getInt64Ty(), ptr);
+    auto *young = builder.CreateICmpEQ(
+        builder.CreateAnd(hdr, NOT_YOUNG_OBJECT_BIT), builder.getInt64(0));
+    loaded.emplace_back(pattern, builder.CreateSelect(young, ptr, null));
+  }
+  builder.CreateBr(body);
+
+  builder.SetInsertPoint(body);
+  for (auto const &[pattern, value] : loaded) {
+    auto *phi = builder.CreatePHI(ptr_ty, 2);
+    phi->addIncoming(null, entry);
+    phi->addIncoming(value, load_block);
+    result[pattern] = {phi, blocks.at(pattern).unchanged};
+  }
+  return body;
+}
+
 bool make_function(
     std::string const &name, kore_pattern *pattern, kore_definition *definition,
     llvm::Module *module, bool tailcc, bool big_step, bool apply,
-    kore_axiom_declaration *axiom, std::string const &postfix) {
+    kore_axiom_declaration *axiom, std::string const &postfix,
+    std::map<kore_pattern *, reusable_block> const &reused = {}) {
   std::map<std::string, kore_variable_pattern *> vars;
   if (apply) {
     for (kore_pattern *lhs : axiom->get_left_hand_side()) {
@@ -1192,10 +1643,18 @@ bool make_function(
   case sort_category::Set: return_type = ptr_ty; break;
   default: break;
   }
+  // A rule that updates the configuration in place also takes the
+  // configuration it rewrites as its last argument.
+  if (!reused.empty()) {
+    param_types.push_back(ptr_ty);
+  }
   llvm::FunctionType *func_type
       = llvm::FunctionType::get(return_type, param_types, false);
   llvm::Function *apply_rule = get_or_insert_function(module, name, func_type);
   apply_rule->setLinkage(llvm::GlobalValue::InternalLinkage);
+  if (!reused.empty()) {
+    apply_rule->addFnAttr("kllvm-in-place");
+  }
   init_debug_axiom(axiom->attributes());
   std::string debug_name = name;
   if (axiom->attributes().contains(attribute_set::key::Label)) {
@@ -1215,8 +1674,8 @@ bool make_function(
   llvm::BasicBlock *block
       = llvm::BasicBlock::Create(module->getContext(), "entry", apply_rule);
   int i = 0;
-  for (auto *val = apply_rule->arg_begin(); val != apply_rule->arg_end();
-       ++val, ++i) {
+  for (auto *val = apply_rule->arg_begin();
+       val != apply_rule->arg_begin() + param_names.size(); ++val, ++i) {
     subst.insert({param_names[i], val});
     if (debug_args[i]) {
       init_debug_param(
@@ -1224,7 +1683,15 @@ bool make_function(
           llvm::cast<llvm::DIType>(debug_args[i])->getName().str());
     }
   }
+  std::map<kore_pattern *, reused_block> reused_blocks;
+  if (!reused.empty()) {
+    auto *subject = apply_rule->getArg(apply_rule->arg_size() - 1);
+    subject->setName("subject");
+    block = load_reused_blocks(
+        definition, module, reused, subject, block, reused_blocks);
+  }
   create_term creator = create_term(subst, definition, block, module, false);
+  creator.set_reused_blocks(std::move(reused_blocks));
   llvm::Value *retval = creator(pattern).first;
 
   auto *current_block = creator.get_current_block();
@@ -1265,11 +1732,16 @@ bool make_function(
 
 void make_apply_rule_function(
     kore_axiom_declaration *axiom, kore_definition *definition,
-    llvm::Module *module, bool big_step) {
+    llvm::Module *module, bool big_step, in_place_analysis const *in_place) {
   kore_pattern *pattern = axiom->get_right_hand_side();
   std::string name = "apply_rule_" + std::to_string(axiom->get_ordinal());
+  std::map<kore_pattern *, reusable_block> reused;
+  if (big_step && in_place) {
+    reused = in_place->reusable_blocks(axiom);
+  }
   make_function(
-      name, pattern, definition, module, true, big_step, true, axiom, ".rhs");
+      name, pattern, definition, module, true, big_step, true, axiom, ".rhs",
+      reused);
   if (big_step) {
     make_function(
         name + "_search", pattern, definition, module, true, false, true, axiom,
@@ -1,7 +1,9 @@
 #include "kllvm/codegen/Decision.h"
 
+#include "kllvm/codegen/BranchProfile.h"
 #include "kllvm/codegen/CreateTerm.h"
 #include "kllvm/codegen/Debug.h"
+#include "kllvm/codegen/Options.h"
 #include "kllvm/codegen/ProofEvent.h"
 #include "kllvm/codegen/Util.h"
 
@@ -23,6 +25,7 @@
 #include <llvm/IR/InstrTypes.h>
 #include <llvm/IR/Instruction.h>
 #include <llvm/IR/Instructions.h>
+#include <llvm/IR/MDBuilder.h>
 #include <llvm/IR/Metadata.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Type.h>
@@ -31,6 +34,7 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <iostream>
 #include <limits>
 #include <memory>
@@ -141,6 +145,28 @@ static std::pair<std::string, std::string> get_fail_pattern(
   return std::make_pair(sort, reason);
 }
 
+/*
+ * Branch weights for a switch instruction with these (profiled) successor
+ * counts, default destination first. LLVM requires 32-bit weights, so large
+ * counts are scaled down proportionally.
+ */
+static llvm::MDNode *get_branch_weights(
+    llvm::LLVMContext &ctx, std::vector<uint64_t> const &counts) {
+  auto max = *std::max_element(counts.begin(), counts.end());
+  if (max == 0) {
+    return nullptr;
+  }
+
+  uint64_t scale = max / std::numeric_limits<uint32_t>::max() + 1;
+
+  auto weights = std::vector<uint32_t>{};
+  for (auto count : counts) {
+    weights.push_back(count / scale);
+  }
+
+  return llvm::MDBuilder(ctx).createBranchWeights(weights);
+}
+
 // NOLINTNEXTLINE(*-cognitive-complexity)
 void switch_node::codegen(decision *d) {
   if (begin_node(d, "switch" + name_)) {
@@ -176,6 +202,36 @@ void switch_node::codegen(decision *d) {
       default_case = &c;
     }
   }
+
+  // Counters are indexed by the position of each case in the decision tree,
+  // so that a profile collected from one kompile can be matched up against
+  // the same switch in another.
+  auto profile_key = switch_profile_key(
+      d->current_block_->getParent(), d->num_switches_++);
+  llvm::GlobalVariable *counters = nullptr;
+  if (pgo_instrument && !d->fail_pattern_) {
+    counters = get_profile_counters(d->module_, profile_key, cases_.size());
+  }
+  auto counts = branch_profile::get().get_counts(profile_key, cases_.size());
+  auto case_count = [&](decision_case const *c) -> uint64_t {
+    return counts ? (*counts)[c - cases_.data()] : 0;
+  };
+
+  // With a profile, list the most frequently taken cases first in the switch
+  // instruction. The children are still generated in the order of case_data,
+  // which also determines the failure reason reported by matching: switches
+  // are numbered in the order they are generated, so the numbering must not
+  // depend on the profile for the keys to match those of the instrumented
+  // build.
+  auto ordered_cases = case_data;
+  if (counts) {
+    std::stable_sort(
+        ordered_cases.begin(), ordered_cases.end(),
+        [&](auto const &a, auto const &b) {
+          return case_count(a.second) > case_count(b.second);
+        });
+  }
+
   if (is_check_null_) {
     auto *cast = new llvm::PtrToIntInst(
         val, llvm::Type::getInt64Ty(d->ctx_), "", d->current_block_);
@@ -195,10 +251,11 @@ void switch_node::codegen(decision *d) {
     fail_sort = d->string_literal(fail_reason.first);
     fail_pattern = d->string_literal(fail_reason.second);
   }
+  llvm::SwitchInst *switch_inst = nullptr;
   if (is_int) {
-    auto *switch_inst = llvm::SwitchInst::Create(
+    switch_inst = llvm::SwitchInst::Create(
         val, default_block, cases_.size(), d->current_block_);
-    for (auto &c : case_data) {
+    for (auto &c : ordered_cases) {
       switch_inst->addCase(
           llvm::ConstantInt::get(d->ctx_, c.second->get_literal()), c.first);
     }
@@ -207,9 +264,9 @@ void switch_node::codegen(decision *d) {
       llvm::BranchInst::Create(default_block, d->current_block_);
     } else {
       llvm::Value *tag_val = d->get_tag(val);
-      auto *switch_inst = llvm::SwitchInst::Create(
+      switch_inst = llvm::SwitchInst::Create(
           tag_val, default_block, case_data.size(), d->current_block_);
-      for (auto &c : case_data) {
+      for (auto &c : ordered_cases) {
         switch_inst->addCase(
             llvm::ConstantInt::get(
                 llvm::Type::getInt32Ty(d->ctx_),
@@ -218,6 +275,21 @@ void switch_node::codegen(decision *d) {
       }
     }
   }
+  if (switch_inst && counts) {
+    // Cases that go straight to the failure block are not counted, and so
+    // get no weight.
+    auto successor_counts = std::vector<uint64_t>{
+        default_case && default_block != d->failure_block_
+            ? case_count(default_case)
+            : 0};
+    for (auto &c : ordered_cases) {
+      successor_counts.push_back(
+          c.first == d->failure_block_ ? 0 : case_count(c.second));
+    }
+    if (auto *weights = get_branch_weights(d->ctx_, successor_counts)) {
+      switch_inst->setMetadata(llvm::LLVMContext::MD_prof, weights);
+    }
+  }
   auto *curr_choice_block = d->choice_block_;
   d->choice_block_ = nullptr;
   auto *switch_block = d->current_block_;
@@ -232,6 +304,10 @@ void switch_node::codegen(decision *d) {
       continue;
     }
     d->current_block_ = entry.first;
+    if (counters) {
+      emit_profile_increment(
+          counters, entry.second - cases_.data(), d->current_block_);
+    }
     if (!is_int) {
       int offset = 0;
       llvm::StructType *block_type = get_block_type(
@@ -347,6 +423,10 @@ void switch_node::codegen(decision *d) {
     if (default_block != d->failure_block_) {
       // process default also
       d->current_block_ = default_block;
+      if (counters) {
+        emit_profile_increment(
+            counters, default_case - cases_.data(), d->current_block_);
+      }
       default_case->get_child()->codegen(d);
     } else if (d->fail_pattern_) {
       d->fail_subject_->addIncoming(ptr_val, switch_block);
@@ -583,9 +663,33 @@ void leaf_node::codegen(decision *d) {
   }
   auto *type = get_param_type(d->cat_, d->module_);
 
+  // Rules compiled with --in-place-rewrite also take the configuration being
+  // rewritten, so that they can reuse its blocks.
+  if (auto *fn = d->module_->getFunction(name_);
+      fn && fn->hasFnAttribute("kllvm-in-place")) {
+    auto *ptr_ty = llvm::PointerType::getUnqual(d->ctx_);
+    args.push_back(
+        d->configuration_ ? d->configuration_
+                          : llvm::ConstantPointerNull::get(ptr_ty));
+    types.push_back(ptr_ty);
+  }
+
   auto *apply_rule = get_or_insert_function(
       d->module_, name_, llvm::FunctionType::get(type, types, false));
 
+  if (pgo_instrument) {
+    emit_profile_increment(
+        get_profile_counters(d->module_, rule_profile_key(name_), 1), 0,
+        d->current_block_);
+  } else if (auto counts
+             = branch_profile::get().get_counts(rule_profile_key(name_), 1)) {
+    // Rules that were never applied while profiling are unlikely to be hot,
+    // so let the optimizer move calls to them out of the way.
+    if ((*counts)[0] == 0) {
+      apply_rule->addFnAttr(llvm::Attribute::Cold);
+    }
+  }
+
   // We are generating code for a function with name beginning apply_rule_\d+; to
   // retrieve the corresponding ordinal we drop the apply_rule_ prefix.
   auto ordinal = std::stoll(name_.substr(11));
@@ -955,10 +1059,11 @@ void make_anywhere_function(
   make_eval_or_anywhere_function(function, definition, module, dt, add_owise);
 }
 
-// writes pointers to gc_roots prior to garbage collection
+// writes pointers to the root frame of the step function prior to garbage
+// collection
 static void store_ptrs_for_gc(
     unsigned nroots, llvm::Module *module, llvm::Type *root_ty,
-    llvm::Constant *arr, llvm::BasicBlock *collect,
+    llvm::Value *arr, llvm::BasicBlock *collect,
     std::vector<llvm::Value *> const &roots,
     std::vector<value_type> const &types,
     std::vector<llvm::Type *> const &ptr_types,
@@ -971,14 +1076,12 @@ static void store_ptrs_for_gc(
         {zero, llvm::ConstantInt::get(
                    llvm::Type::getInt64Ty(module->getContext()), i)},
         "", collect);
-    auto *casted = new llvm::BitCastInst(
-        ptr, llvm::PointerType::getUnqual(module->getContext()), "", collect);
-    new llvm::StoreInst(roots[i], casted, collect);
-    root_ptrs.emplace_back(casted, ptr_types[i]);
+    new llvm::StoreInst(roots[i], ptr, collect);
+    root_ptrs.emplace_back(ptr, ptr_types[i]);
   }
 }
 
-// reads pointers from gc_roots global variable following garbage collection
+// reads pointers from the root frame following garbage collection
 // and creates phi nodes for assigning the correct new value for the roots
 static void load_ptrs_for_gc(
     llvm::Module *module, llvm::BasicBlock *check_collect,
@@ -1012,6 +1115,8 @@ std::pair<std::vector<llvm::Value *>, llvm::BasicBlock *> step_function_header(
 
   auto *collection = module->getOrInsertGlobal(
       "time_for_collection", llvm::Type::getInt1Ty(module->getContext()));
+  llvm::cast<llvm::GlobalVariable>(collection)->setThreadLocalMode(
+      llvm::GlobalValue::GeneralDynamicTLSModel);
   auto *is_collection = new llvm::LoadInst(
       llvm::Type::getInt1Ty(module->getContext()), collection, "is_collection",
       check_collect);
@@ -1053,8 +1158,16 @@ std::pair<std::vector<llvm::Value *>, llvm::BasicBlock *> step_function_header(
     }
     i++;
   }
-  auto *root_ty = llvm::ArrayType::get(ptr_ty, 256);
-  auto *arr = module->getOrInsertGlobal("gc_roots", root_ty);
+  // The roots are spilled to a frame in the stack of the step function rather
+  // than to a global array, so that there is no limit on their number and the
+  // stores to it are only ever made on the path that calls the collector.
+  auto *root_ty = llvm::ArrayType::get(ptr_ty, nroots);
+  llvm::Value *arr = llvm::ConstantPointerNull::get(ptr_ty);
+  if (nroots > 0) {
+    arr = new llvm::AllocaInst(
+        root_ty, 0, "gc_roots",
+        block->getParent()->getEntryBlock().getFirstNonPHI());
+  }
   std::vector<std::pair<llvm::Value *, llvm::Type *>> root_ptrs;
 
   store_ptrs_for_gc(
@@ -1105,14 +1218,14 @@ std::pair<std::vector<llvm::Value *>, llvm::BasicBlock *> step_function_header(
       module, "kore_collect",
       llvm::FunctionType::get(
           llvm::Type::getVoidTy(module->getContext()),
-          {arr->getType(), llvm::Type::getInt8Ty(module->getContext()), ptr_ty,
-           ptr_ty, llvm::Type::getInt1Ty(module->getContext())},
+          {ptr_ty, llvm::Type::getInt32Ty(module->getContext()), ptr_ty,
+           llvm::Type::getInt1Ty(module->getContext())},
           false));
   auto *call = llvm::CallInst::Create(
       kore_collect,
       {arr,
        llvm::ConstantInt::get(
-           llvm::Type::getInt8Ty(module->getContext()), nroots),
+           llvm::Type::getInt32Ty(module->getContext()), nroots),
        llvm::ConstantExpr::getBitCast(layout, ptr_ty),
        llvm::ConstantInt::getFalse(module->getContext())},
       "", collect);
@@ -1142,6 +1255,40 @@ std::pair<std::vector<llvm::Value *>, llvm::BasicBlock *> step_function_header(
   return std::make_pair(results, merge);
 }
 
+// At the top of k_step, the subject is the whole configuration, so this is the
+// one point at which the state of the rewrite can be saved and later resumed.
+// The runtime sets time_for_checkpoint every --checkpoint-interval steps or
+// when the interpreter receives SIGUSR1. It is a std::atomic<bool>, as it is
+// written by a signal handler, and so it is read with an atomic byte load.
+static llvm::BasicBlock *checkpoint_header(
+    llvm::Module *module, llvm::BasicBlock *block, llvm::Value *subject) {
+  auto *flag_type = llvm::Type::getInt8Ty(module->getContext());
+  auto *checkpoint
+      = module->getOrInsertGlobal("time_for_checkpoint", flag_type);
+  auto *flag = new llvm::LoadInst(
+      flag_type, checkpoint, "time_for_checkpoint", false, llvm::Align(1),
+      llvm::AtomicOrdering::Monotonic, llvm::SyncScope::System, block);
+  set_debug_loc(flag);
+  auto *is_checkpoint = new llvm::ICmpInst(
+      *block, llvm::CmpInst::ICMP_NE, flag,
+      llvm::ConstantInt::get(flag_type, 0), "is_checkpoint");
+  auto *write = llvm::BasicBlock::Create(
+      module->getContext(), "isCheckpoint", block->getParent());
+  auto *merge = llvm::BasicBlock::Create(
+      module->getContext(), "afterCheckpoint", block->getParent());
+  llvm::BranchInst::Create(write, merge, is_checkpoint, block);
+
+  auto *kore_checkpoint = get_or_insert_function(
+      module, "kore_checkpoint",
+      llvm::FunctionType::get(
+          llvm::Type::getVoidTy(module->getContext()), {subject->getType()},
+          false));
+  auto *call = llvm::CallInst::Create(kore_checkpoint, {subject}, "", write);
+  set_debug_loc(call);
+  llvm::BranchInst::Create(merge, write);
+  return merge;
+}
+
 void make_step_function(
     kore_definition *definition, llvm::Module *module, decision_node *dt,
     bool search, bool profile_matching) {
@@ -1207,13 +1354,20 @@ void make_step_function(
       0, module, definition, block, stuck, {val}, {{sort_category::Symbol, 0}});
   auto *collected_val = result.first[0];
   collected_val->setName("_1");
+  auto *step = result.second;
+  if (!search) {
+    step = checkpoint_header(module, step, collected_val);
+  }
   decision codegen(
-      definition, result.second, fail, jump, choice_buffer, choice_depth,
+      definition, step, fail, jump, choice_buffer, choice_depth,
       module, {sort_category::Symbol, 0}, nullptr, nullptr, nullptr,
       has_search_results, profile_matching);
   codegen.store(
       std::make_pair(collected_val->getName().str(), collected_val->getType()),
       collected_val);
+  if (!search) {
+    codegen.set_configuration(collected_val);
+  }
   if (search) {
     llvm::ReturnInst::Create(module->getContext(), stuck);
   } else {
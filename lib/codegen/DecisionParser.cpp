@@ -13,11 +13,18 @@
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Type.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
+#include <string_view>
 #include <utility>
 
 namespace kllvm {
@@ -431,4 +438,452 @@ partial_step parse_yaml_specialdecision_tree(
   return result;
 }
 
+namespace {
+
+constexpr auto dt_magic = std::string_view("\x7f" "KDT", 4);
+constexpr uint32_t dt_none = 0xffffffff;
+
+enum dt_node_kind : uint8_t {
+  FailNode,
+  LeafNode,
+  SearchLeafNode,
+  SwitchNode,
+  SwitchLitNode,
+  CheckNullNode,
+  FunctionNode,
+  MakePatternNode,
+  MakeIteratorNode,
+  IterNextNode,
+};
+
+enum dt_pattern_kind : uint8_t {
+  VariablePattern,
+  ResidualVariablePattern,
+  LiteralPattern,
+  SymbolPattern,
+};
+
+/*
+ * A bounds-checked cursor over part of a memory-mapped decision tree file.
+ */
+class dt_cursor {
+public:
+  dt_cursor(std::string const &filename, char const *begin, char const *end)
+      : filename_(filename)
+      , ptr_(begin)
+      , end_(end) { }
+
+  uint8_t u8() { return static_cast<uint8_t>(*advance(1)); }
+
+  uint32_t u32() {
+    auto const *bytes = reinterpret_cast<unsigned char const *>(advance(4));
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16)
+           | (static_cast<uint32_t>(bytes[3]) << 24);
+  }
+
+  std::string_view bytes(size_t len) { return {advance(len), len}; }
+
+private:
+  std::string const &filename_;
+  char const *ptr_;
+  char const *end_;
+
+  char const *advance(size_t len) {
+    if (static_cast<size_t>(end_ - ptr_) < len) {
+      throw std::runtime_error(
+          fmt::format("Truncated decision tree file: {}", filename_));
+    }
+    auto const *result = ptr_;
+    ptr_ += len;
+    return result;
+  }
+};
+
+} // namespace
+
+class dt_binary_reader {
+private:
+  decision_tree_file const &file_;
+  std::vector<decision_node *> unique_nodes_;
+  std::map<std::string, kore_symbol *> const &syms_;
+  std::map<value_type, sptr<kore_composite_sort>> const &sorts_;
+  kore_symbol *dv_;
+  llvm::Module *mod_;
+
+  dt_cursor cursor(char const *begin, size_t size, size_t offset) {
+    if (offset > size) {
+      throw std::runtime_error(fmt::format(
+          "Invalid offset in decision tree file: {}", file_.filename_));
+    }
+    return {file_.filename_, begin + offset, begin + size};
+  }
+
+  std::string str(dt_cursor &c) {
+    auto idx = c.u32();
+    if (idx >= file_.strings_.size()) {
+      throw std::runtime_error(fmt::format(
+          "Invalid string in decision tree file: {}", file_.filename_));
+    }
+    return std::string(file_.strings_[idx]);
+  }
+
+  std::vector<std::string> occurrence(dt_cursor &c) {
+    auto size = c.u32();
+    std::vector<std::string> result;
+    for (uint32_t i = 0; i < size; ++i) {
+      result.push_back(str(c));
+    }
+    return result;
+  }
+
+  llvm::Type *param_type(std::string const &hook) {
+    return get_param_type(kore_composite_sort::get_category(hook), mod_);
+  }
+
+  decision_node *function(dt_cursor &c) {
+    std::string function = str(c);
+    std::string hook_name = str(c);
+    value_type cat = kore_composite_sort::get_category(hook_name);
+    std::string binding = dt_preprocessor::to_string(occurrence(c));
+
+    std::vector<std::pair<std::vector<std::string>, std::string>> args;
+    auto num_args = c.u32();
+    for (uint32_t i = 0; i < num_args; ++i) {
+      auto occ = occurrence(c);
+      args.emplace_back(std::move(occ), str(c));
+    }
+
+    auto *child = node(c.u32());
+    auto *result = function_node::create(
+        binding, function, child, cat, get_param_type(cat, mod_));
+
+    for (auto const &[occ, hook] : args) {
+      if (occ.size() == 3 && occ[0] == "lit" && occ[2] == "MINT.MInt 64") {
+        result->add_binding(
+            occ[1], kore_composite_sort::get_category(hook), mod_);
+      } else {
+        result->add_binding(
+            dt_preprocessor::to_string(occ),
+            kore_composite_sort::get_category(hook), mod_);
+      }
+    }
+    return result;
+  }
+
+  ptr<kore_pattern> parse_pattern(
+      dt_cursor &c, std::vector<std::pair<std::string, llvm::Type *>> &uses) {
+    auto kind = c.u8();
+    switch (kind) {
+    case VariablePattern:
+    case ResidualVariablePattern: {
+      std::string name = kind == ResidualVariablePattern
+                             ? str(c)
+                             : dt_preprocessor::to_string(occurrence(c));
+      value_type hook = kore_composite_sort::get_category(str(c));
+      uses.emplace_back(name, get_param_type(hook, mod_));
+      return kore_variable_pattern::create(name, sorts_.at(hook));
+    }
+    case LiteralPattern: {
+      auto sym = kore_symbol::create("\\dv");
+      auto hook = str(c);
+      auto sort = sorts_.at(kore_composite_sort::get_category(hook));
+      auto val = str(c);
+      if (hook == "BOOL.Bool") {
+        val = val == "1" ? "true" : "false";
+      }
+
+      sym->add_formal_argument(sort);
+      sym->add_sort(sort);
+      auto pat = kore_composite_pattern::create(std::move(sym));
+      pat->add_argument(kore_string_pattern::create(val));
+      return pat;
+    }
+    case SymbolPattern: {
+      auto *sym = syms_.at(str(c));
+      auto pat = kore_composite_pattern::create(sym);
+      auto num_args = c.u32();
+      for (uint32_t i = 0; i < num_args; ++i) {
+        pat->add_argument(parse_pattern(c, uses));
+      }
+      return pat;
+    }
+    default:
+      throw std::runtime_error(fmt::format(
+          "Invalid pattern in decision tree file: {}", file_.filename_));
+    }
+  }
+
+  decision_node *make_pattern(dt_cursor &c) {
+    std::string name = dt_preprocessor::to_string(occurrence(c));
+    llvm::Type *type = param_type(str(c));
+
+    std::vector<std::pair<std::string, llvm::Type *>> uses;
+    ptr<kore_pattern> pat = parse_pattern(c, uses);
+
+    auto *child = node(c.u32());
+
+    return make_pattern_node::create(name, type, pat.release(), uses, child);
+  }
+
+  decision_node *make_iterator(dt_cursor &c) {
+    auto hook_name = str(c);
+    auto collection = dt_preprocessor::to_string(occurrence(c));
+    auto *type = param_type(str(c));
+    auto *child = node(c.u32());
+
+    return make_iterator_node::create(
+        collection, type, collection + "_iter",
+        llvm::PointerType::getUnqual(mod_->getContext()), hook_name, child);
+  }
+
+  decision_node *iter_next(dt_cursor &c) {
+    auto function = str(c);
+    auto iterator = dt_preprocessor::to_string(occurrence(c)) + "_iter";
+    auto *type = param_type(str(c));
+    auto binding = dt_preprocessor::to_string(occurrence(c));
+    auto *child = node(c.u32());
+
+    return iter_next_node::create(
+        iterator, llvm::PointerType::getUnqual(mod_->getContext()), binding,
+        type, function, child);
+  }
+
+  decision_node *switch_case(dt_node_kind kind, dt_cursor &c) {
+    auto occ = occurrence(c);
+    std::string name = dt_preprocessor::to_string(occ);
+    llvm::Type *type = param_type(str(c));
+    unsigned bitwidth = kind == SwitchLitNode ? c.u32() : 1;
+
+    auto *result = switch_node::create(name, type, kind == CheckNullNode);
+
+    auto num_cases = c.u32();
+    for (uint32_t i = 0; i < num_cases; ++i) {
+      auto ctor = str(c);
+      auto child_idx = c.u32();
+
+      std::vector<std::string> hooks;
+      auto num_bindings = c.u32();
+      for (uint32_t j = 0; j < num_bindings; ++j) {
+        hooks.push_back(str(c));
+      }
+
+      auto *child = node(child_idx);
+
+      if (kind != SwitchNode) {
+        result->add_case({dv_, {bitwidth, ctor, 10}, child});
+        continue;
+      }
+
+      kore_symbol *symbol = syms_.at(ctor);
+      std::vector<std::pair<std::string, llvm::Type *>> bindings;
+      for (unsigned j = 0; j < symbol->get_arguments().size(); ++j) {
+        auto new_occurrence = occ;
+        new_occurrence.insert(new_occurrence.begin(), std::to_string(j));
+        bindings.emplace_back(
+            dt_preprocessor::to_string(new_occurrence),
+            param_type(hooks.at(j)));
+      }
+      result->add_case({symbol, bindings, child});
+    }
+
+    if (auto default_idx = c.u32(); default_idx != dt_none) {
+      result->add_case(
+          {nullptr, std::vector<std::pair<std::string, llvm::Type *>>{},
+           node(default_idx)});
+    }
+    return result;
+  }
+
+  decision_node *leaf(dt_node_kind kind, dt_cursor &c) {
+    std::string name = "apply_rule_" + std::to_string(c.u32());
+    if (kind == SearchLeafNode) {
+      name = name + "_search";
+    }
+    auto *result = leaf_node::create(name);
+
+    auto num_vars = c.u32();
+    for (uint32_t i = 0; i < num_vars; ++i) {
+      auto occ = occurrence(c);
+      value_type cat = kore_composite_sort::get_category(str(c));
+      result->add_binding(dt_preprocessor::to_string(occ), cat, mod_);
+    }
+
+    if (kind == SearchLeafNode) {
+      result->set_child(node(c.u32()));
+    }
+    return result;
+  }
+
+public:
+  dt_binary_reader(
+      decision_tree_file const &file,
+      std::map<std::string, kore_symbol *> const &syms,
+      std::map<value_type, sptr<kore_composite_sort>> const &sorts,
+      llvm::Module *mod)
+      : file_(file)
+      , unique_nodes_(file.num_nodes_, nullptr)
+      , syms_(syms)
+      , sorts_(sorts)
+      , dv_(kore_symbol::create("\\dv").release())
+      , mod_(mod) { }
+
+  decision_node *node(uint32_t idx) {
+    if (idx >= unique_nodes_.size()) {
+      throw std::runtime_error(fmt::format(
+          "Invalid node in decision tree file: {}", file_.filename_));
+    }
+    if (auto *unique = unique_nodes_[idx]) {
+      return unique;
+    }
+
+    auto offset = dt_cursor(
+                      file_.filename_, file_.node_offsets_ + (4 * idx),
+                      file_.node_offsets_ + (4 * (idx + 1)))
+                      .u32();
+    auto c = cursor(file_.node_data_, file_.node_data_size_, offset);
+
+    auto kind = static_cast<dt_node_kind>(c.u8());
+    decision_node *ret = nullptr;
+    switch (kind) {
+    case FailNode: ret = fail_node::get(); break;
+    case LeafNode:
+    case SearchLeafNode: ret = leaf(kind, c); break;
+    case SwitchNode:
+    case SwitchLitNode:
+    case CheckNullNode: ret = switch_case(kind, c); break;
+    case FunctionNode: ret = function(c); break;
+    case MakePatternNode: ret = make_pattern(c); break;
+    case MakeIteratorNode: ret = make_iterator(c); break;
+    case IterNextNode: ret = iter_next(c); break;
+    default:
+      throw std::runtime_error(fmt::format(
+          "Invalid node in decision tree file: {}", file_.filename_));
+    }
+    unique_nodes_[idx] = ret;
+    return ret;
+  }
+
+  std::vector<residual> residuals(uint32_t offset) {
+    auto c = cursor(file_.residual_data_, file_.residual_data_size_, offset);
+
+    std::vector<residual> res;
+    auto size = c.u32();
+    for (uint32_t i = 0; i < size; ++i) {
+      residual r;
+      std::vector<std::pair<std::string, llvm::Type *>> uses;
+      r.pattern = parse_pattern(c, uses).release();
+      r.occurrence = dt_preprocessor::to_string(occurrence(c));
+      res.push_back(r);
+    }
+    return res;
+  }
+};
+
+decision_tree_file::decision_tree_file(std::string const &filename)
+    : filename_(filename) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error(
+        fmt::format("Could not open decision tree file: {}", filename));
+  }
+
+  struct stat st { };
+  if (fstat(fd, &st) < 0 || st.st_size == 0) {
+    close(fd);
+    throw std::runtime_error(
+        fmt::format("Could not read decision tree file: {}", filename));
+  }
+
+  size_ = st.st_size;
+  void *mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    throw std::runtime_error(
+        fmt::format("Could not map decision tree file: {}", filename));
+  }
+  data_ = static_cast<char const *>(mapped);
+
+  auto c = dt_cursor(filename_, data_, data_ + size_);
+  if (c.bytes(dt_magic.size()) != dt_magic) {
+    throw std::runtime_error(
+        fmt::format("Invalid magic in decision tree file: {}", filename));
+  }
+  if (c.u32() != version) {
+    throw std::runtime_error(
+        fmt::format("Invalid decision tree file version: {}", filename));
+  }
+
+  auto num_strings = c.u32();
+  num_nodes_ = c.u32();
+  auto num_trees = c.u32();
+
+  strings_.reserve(num_strings);
+  for (uint32_t i = 0; i < num_strings; ++i) {
+    auto len = c.u32();
+    strings_.push_back(c.bytes(len));
+  }
+
+  node_data_size_ = c.u32();
+  node_offsets_ = c.bytes(4 * static_cast<size_t>(num_nodes_)).data();
+  node_data_ = c.bytes(node_data_size_).data();
+
+  residual_data_size_ = c.u32();
+  residual_data_ = c.bytes(residual_data_size_).data();
+
+  trees_.reserve(num_trees);
+  for (uint32_t i = 0; i < num_trees; ++i) {
+    auto name = c.u32();
+    auto root = c.u32();
+    auto residuals = c.u32();
+    if (name >= strings_.size()) {
+      throw std::runtime_error(fmt::format(
+          "Invalid tree name in decision tree file: {}", filename));
+    }
+    trees_.emplace(strings_[name], tree_entry{root, residuals});
+  }
+}
+
+decision_tree_file::~decision_tree_file() {
+  munmap(const_cast<char *>(data_), size_);
+}
+
+bool decision_tree_file::contains(std::string const &name) const {
+  return trees_.find(name) != trees_.end();
+}
+
+decision_tree_file::tree_entry const &
+decision_tree_file::get_entry(std::string const &name) const {
+  auto it = trees_.find(name);
+  if (it == trees_.end()) {
+    throw std::runtime_error(fmt::format(
+        "No decision tree named {} in file: {}", name, filename_));
+  }
+  return it->second;
+}
+
+decision_node *decision_tree_file::parse(
+    llvm::Module *mod, std::string const &name,
+    std::map<std::string, kore_symbol *> const &syms,
+    std::map<value_type, sptr<kore_composite_sort>> const &sorts) const {
+  return dt_binary_reader(*this, syms, sorts, mod).node(get_entry(name).root);
+}
+
+partial_step decision_tree_file::parse_special(
+    llvm::Module *mod, std::string const &name,
+    std::map<std::string, kore_symbol *> const &syms,
+    std::map<value_type, sptr<kore_composite_sort>> const &sorts) const {
+  auto const &entry = get_entry(name);
+  if (entry.residuals == 0) {
+    throw std::runtime_error(fmt::format(
+        "Decision tree {} has no residuals in file: {}", name, filename_));
+  }
+
+  auto reader = dt_binary_reader(*this, syms, sorts, mod);
+
+  partial_step result;
+  result.dt = reader.node(entry.root);
+  result.residuals = reader.residuals(entry.residuals - 1);
+  return result;
+}
+
 } // namespace kllvm
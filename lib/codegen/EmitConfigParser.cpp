@@ -3,6 +3,8 @@
 #include "kllvm/codegen/Debug.h"
 #include "kllvm/codegen/Util.h"
 
+#include "kllvm/binary/serializer.h"
+
 #include <llvm/ADT/StringMap.h>
 #include <llvm/ADT/StringRef.h>
 #include <llvm/ADT/Twine.h>
@@ -1361,6 +1363,53 @@ emit_symbol_is_instantiation(kore_definition *def, llvm::Module *mod) {
       get_bool_debug_type(), def, mod, getter);
 }
 
+/*
+ * Emit a table mapping symbol tags to the pre-encoded binary KORE for that
+ * symbol (see encode_symbol_fragment), so that the runtime can serialize terms
+ * without looking up or parsing symbol names. Each value in the table points
+ * to a global with the layout of the runtime's binary_fragment struct:
+ *
+ *   { i32 size, i32 symbol_begin, i32 name_begin, i32 name_end,
+ *     i32 is_injection, [size x i8] data }
+ */
+static void
+emit_binary_fragment_table(kore_definition *def, llvm::Module *mod) {
+  auto getter = [](kore_definition *definition, llvm::Module *module,
+                   kore_symbol *symbol) -> llvm::Constant * {
+    auto &ctx = module->getContext();
+    auto *i32_ty = llvm::Type::getInt32Ty(ctx);
+
+    auto fragment = encode_symbol_fragment(*symbol);
+    auto *data = llvm::ConstantDataArray::getString(ctx, fragment.bytes, false);
+
+    auto fields = std::vector<llvm::Constant *>{
+        llvm::ConstantInt::get(i32_ty, fragment.bytes.size()),
+        llvm::ConstantInt::get(i32_ty, fragment.symbol_begin),
+        llvm::ConstantInt::get(i32_ty, fragment.name_begin),
+        llvm::ConstantInt::get(i32_ty, fragment.name_end),
+        llvm::ConstantInt::get(i32_ty, fragment.is_injection),
+        data,
+    };
+
+    auto *init = llvm::ConstantStruct::getAnon(ctx, fields);
+    auto *global = module->getOrInsertGlobal(
+        fmt::format("binary_fragment_{}", ast_to_string(*symbol)),
+        init->getType());
+    auto *global_var = llvm::cast<llvm::GlobalVariable>(global);
+    if (!global_var->hasInitializer()) {
+      global_var->setConstant(true);
+      global_var->setInitializer(init);
+    }
+
+    return global_var;
+  };
+
+  emit_data_table_for_symbol(
+      "get_binary_fragment_for_tag",
+      llvm::PointerType::getUnqual(mod->getContext()),
+      get_char_ptr_debug_type(), def, mod, getter);
+}
+
 void emit_config_parser_functions(
     kore_definition *definition, llvm::Module *module) {
   emit_get_tag_for_symbol_name(definition, module);
@@ -1386,6 +1435,7 @@ void emit_config_parser_functions(
   emit_sort_table_for_proof_trace_serialization(definition, module);
   emit_return_sort_table(definition, module);
   emit_symbol_is_instantiation(definition, module);
+  emit_binary_fragment_table(definition, module);
 }
 
 } // namespace kllvm
@@ -0,0 +1,395 @@
+#include "kllvm/codegen/InPlace.h"
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+
+namespace kllvm {
+
+namespace {
+
+using path_type = std::vector<unsigned>;
+
+// Variables under a function or collection pattern on a left-hand side are not
+// bound to a child of the block matched at that position.
+constexpr auto not_a_child = std::numeric_limits<unsigned>::max();
+
+bool is_constructor(kore_definition *definition, kore_symbol *symbol) {
+  if (symbol->is_builtin()) {
+    return false;
+  }
+  auto *decl = definition->get_symbol_declarations().at(symbol->get_name());
+  return !decl->attributes().contains(attribute_set::key::Function)
+         && !decl->is_hooked();
+}
+
+bool is_collection(kore_definition *definition, kore_sort *sort) {
+  auto *composite = dynamic_cast<kore_composite_sort *>(sort);
+  if (!composite) {
+    return false;
+  }
+  switch (composite->get_category(definition).cat) {
+  case sort_category::Map:
+  case sort_category::RangeMap:
+  case sort_category::List:
+  case sort_category::Set: return true;
+  default: return false;
+  }
+}
+
+bool is_prefix(path_type const &prefix, path_type const &path) {
+  return prefix.size() <= path.size()
+         && std::equal(prefix.begin(), prefix.end(), path.begin());
+}
+
+void count_variables(
+    kore_pattern *pattern, std::map<std::string, unsigned> &counts) {
+  if (auto *var = dynamic_cast<kore_variable_pattern *>(pattern)) {
+    counts[var->get_name()]++;
+  } else if (auto *comp = dynamic_cast<kore_composite_pattern *>(pattern)) {
+    for (auto const &arg : comp->get_arguments()) {
+      count_variables(arg.get(), counts);
+    }
+  }
+}
+
+bool uses_any(
+    kore_pattern *pattern, std::map<std::string, unsigned> const &counts) {
+  auto vars = std::map<std::string, kore_variable_pattern *>{};
+  pattern->mark_variables(vars);
+  return std::any_of(vars.begin(), vars.end(), [&](auto const &entry) {
+    return counts.contains(entry.first);
+  });
+}
+
+/*
+ * The sorts of terms that a single axiom may make reachable from more than one
+ * place, the sorts of the variables its side condition reads, and the
+ * injections it constructs.
+ */
+class axiom_scanner {
+public:
+  axiom_scanner(
+      std::set<std::string> &duplicated, std::set<std::string> &conditions,
+      std::set<std::string> &injections)
+      : duplicated_(duplicated)
+      , conditions_(conditions)
+      , injections_(injections) { }
+
+  void scan(kore_axiom_declaration *axiom) {
+    auto *rhs = axiom->get_right_hand_side();
+    auto counts = std::map<std::string, unsigned>{};
+    count_variables(rhs, counts);
+    scan_rhs(rhs, counts);
+    for (auto *lhs : axiom->get_left_hand_side()) {
+      scan_lhs(lhs, counts);
+    }
+    if (auto *side_condition = axiom->get_requires()) {
+      scan_side_condition(side_condition);
+    }
+  }
+
+private:
+  std::set<std::string> &duplicated_;
+  std::set<std::string> &conditions_;
+  std::set<std::string> &injections_;
+
+  // A side condition is evaluated before the rule is known to apply, and if it
+  // fails then the same subject is matched against the next rule, or the owise
+  // rule. A term that it reads is therefore still referred to afterwards, even
+  // if the rule uses it nowhere else.
+  void scan_side_condition(kore_pattern *side_condition) {
+    auto vars = std::map<std::string, kore_variable_pattern *>{};
+    side_condition->mark_variables(vars);
+    for (auto const &[name, var] : vars) {
+      conditions_.insert(ast_to_string(*var->get_sort()));
+    }
+  }
+
+  void scan_rhs(
+      kore_pattern *pattern, std::map<std::string, unsigned> const &counts) {
+    if (auto *var = dynamic_cast<kore_variable_pattern *>(pattern)) {
+      if (counts.at(var->get_name()) > 1) {
+        duplicated_.insert(ast_to_string(*var->get_sort()));
+      }
+    } else if (auto *comp = dynamic_cast<kore_composite_pattern *>(pattern)) {
+      auto *symbol = comp->get_constructor();
+      if (symbol->get_name() == "inj") {
+        injections_.insert(ast_to_string(*symbol));
+      }
+      for (auto const &arg : comp->get_arguments()) {
+        scan_rhs(arg.get(), counts);
+      }
+    }
+  }
+
+  // A variable bound with \and refers to the same term as the pattern it is
+  // conjoined with, so if both are used then that term is duplicated.
+  void scan_lhs(
+      kore_pattern *pattern, std::map<std::string, unsigned> const &counts) {
+    auto *comp = dynamic_cast<kore_composite_pattern *>(pattern);
+    if (!comp) {
+      return;
+    }
+    auto const &args = comp->get_arguments();
+    if (comp->get_constructor()->get_name() == "\\and") {
+      for (auto const &arg : args) {
+        auto *var = dynamic_cast<kore_variable_pattern *>(arg.get());
+        if (!var || !counts.contains(var->get_name())) {
+          continue;
+        }
+        for (auto const &other : args) {
+          if (other != arg && uses_any(other.get(), counts)) {
+            duplicated_.insert(ast_to_string(*var->get_sort()));
+          }
+        }
+      }
+    }
+    for (auto const &arg : args) {
+      scan_lhs(arg.get(), counts);
+    }
+  }
+};
+
+using sort_graph = std::map<std::string, std::set<std::string>>;
+
+std::set<std::string>
+reachable(std::set<std::string> const &roots, sort_graph const &edges) {
+  auto result = std::set<std::string>{};
+  auto work = std::deque<std::string>(roots.begin(), roots.end());
+  while (!work.empty()) {
+    auto sort = work.front();
+    work.pop_front();
+    if (!result.insert(sort).second) {
+      continue;
+    }
+    if (auto it = edges.find(sort); it != edges.end()) {
+      work.insert(work.end(), it->second.begin(), it->second.end());
+    }
+  }
+  return result;
+}
+
+void bind_variables(
+    kore_definition *definition, kore_pattern *pattern, path_type &path,
+    std::map<std::string, std::vector<path_type>> &bindings) {
+  if (auto *var = dynamic_cast<kore_variable_pattern *>(pattern)) {
+    bindings[var->get_name()].push_back(path);
+    return;
+  }
+  auto *comp = dynamic_cast<kore_composite_pattern *>(pattern);
+  if (!comp) {
+    return;
+  }
+
+  auto *symbol = comp->get_constructor();
+  auto const &args = comp->get_arguments();
+  if (symbol->get_name() == "\\and") {
+    for (auto const &arg : args) {
+      bind_variables(definition, arg.get(), path, bindings);
+    }
+  } else if (is_constructor(definition, symbol)) {
+    for (unsigned i = 0; i < args.size(); ++i) {
+      path.push_back(i);
+      bind_variables(definition, args[i].get(), path, bindings);
+      path.pop_back();
+    }
+  } else {
+    path.push_back(not_a_child);
+    for (auto const &arg : args) {
+      bind_variables(definition, arg.get(), path, bindings);
+    }
+    path.pop_back();
+  }
+}
+
+class reuse_finder {
+public:
+  reuse_finder(
+      kore_definition *definition, in_place_analysis const &analysis,
+      kore_pattern *lhs, kore_pattern *rhs)
+      : definition_(definition)
+      , analysis_(analysis) {
+    auto path = path_type{};
+    bind_variables(definition_, lhs, path, bindings_);
+    rhs->mark_variables(rhs_vars_);
+  }
+
+  void find(kore_pattern *lhs, kore_pattern *rhs) {
+    auto *l = dynamic_cast<kore_composite_pattern *>(lhs);
+    auto *r = dynamic_cast<kore_composite_pattern *>(rhs);
+    if (!l || !r || *l->get_constructor() != *r->get_constructor()
+        || !analysis_.can_reuse(r->get_constructor())) {
+      return;
+    }
+
+    // The block, or a term containing it, is still used by the rule.
+    if (is_bound([&](path_type const &binding) {
+          return is_prefix(binding, path_);
+        })) {
+      return;
+    }
+
+    auto const &largs = l->get_arguments();
+    auto const &rargs = r->get_arguments();
+    auto block = reusable_block{steps_, {}};
+    for (size_t i = 0; i < rargs.size(); ++i) {
+      auto *lvar = dynamic_cast<kore_variable_pattern *>(largs[i].get());
+      auto *rvar = dynamic_cast<kore_variable_pattern *>(rargs[i].get());
+      block.unchanged.push_back(
+          lvar && rvar && lvar->get_name() == rvar->get_name());
+    }
+
+    // Collections are stored inline in the block, and a variable bound to one
+    // points into the block; it is read while constructing the children of
+    // the block, so it must not be used anywhere else.
+    auto subtree_vars = std::map<std::string, kore_variable_pattern *>{};
+    r->mark_variables(subtree_vars);
+    auto in_block = [&](path_type const &binding) {
+      return binding.size() == path_.size() + 1 && is_prefix(path_, binding);
+    };
+    bool reusable = std::none_of(
+        rhs_vars_.begin(), rhs_vars_.end(), [&](auto const &entry) {
+          return !subtree_vars.contains(entry.first)
+                 && is_collection(
+                     definition_, entry.second->get_sort().get())
+                 && is_bound_at(entry.first, in_block);
+        });
+    if (reusable) {
+      result_[r] = std::move(block);
+    }
+
+    for (unsigned i = 0; i < rargs.size(); ++i) {
+      path_.push_back(i);
+      steps_.emplace_back(r->get_constructor(), i);
+      find(largs[i].get(), rargs[i].get());
+      steps_.pop_back();
+      path_.pop_back();
+    }
+  }
+
+  std::map<kore_pattern *, reusable_block> &result() { return result_; }
+
+private:
+  kore_definition *definition_;
+  in_place_analysis const &analysis_;
+  std::map<std::string, std::vector<path_type>> bindings_;
+  std::map<std::string, kore_variable_pattern *> rhs_vars_;
+  path_type path_;
+  std::vector<std::pair<kore_symbol *, unsigned>> steps_;
+  std::map<kore_pattern *, reusable_block> result_;
+
+  template <typename Pred>
+  bool is_bound_at(std::string const &name, Pred pred) const {
+    auto it = bindings_.find(name);
+    return it != bindings_.end()
+           && std::any_of(it->second.begin(), it->second.end(), pred);
+  }
+
+  template <typename Pred>
+  bool is_bound(Pred pred) const {
+    return std::any_of(
+        rhs_vars_.begin(), rhs_vars_.end(),
+        [&](auto const &entry) { return is_bound_at(entry.first, pred); });
+  }
+};
+
+} // namespace
+
+in_place_analysis::in_place_analysis(kore_definition *definition)
+    : definition_(definition) {
+  auto duplicated = std::set<std::string>{};
+  auto conditions = std::set<std::string>{};
+  auto injections = std::set<std::string>{};
+  auto scanner = axiom_scanner(duplicated, conditions, injections);
+  for (auto *axiom : definition->get_axioms()) {
+    scanner.scan(axiom);
+  }
+
+  // S |-> {T . a term of sort S can directly contain a term of sort T}
+  auto contains = sort_graph{};
+  // The same, also counting the injections that no rule constructs.
+  auto may_contain = sort_graph{};
+  for (auto const &[name, symbol] : definition->get_all_symbols()) {
+    auto *decl = definition->get_symbol_declarations().at(symbol->get_name());
+    auto const &att = decl->attributes();
+    auto *sort = dynamic_cast<kore_composite_sort *>(symbol->get_sort().get());
+    if (!sort) {
+      continue;
+    }
+
+    bool has_children = false;
+    if (att.contains(attribute_set::key::SortInjection)) {
+      for (auto const &arg : symbol->get_arguments()) {
+        may_contain[ast_to_string(*sort)].insert(ast_to_string(*arg));
+      }
+      // Only injections that some rule constructs matter: the definition
+      // declares injections from cell sorts into KItem, for example, but
+      // rules do not normally store cells in a K sequence.
+      has_children = injections.contains(name);
+    } else if (att.contains(attribute_set::key::Hook)) {
+      auto hook = att.get_string(attribute_set::key::Hook);
+      has_children = is_collection(definition, sort);
+      if (hook == "LIST.make" || hook == "LIST.fill") {
+        duplicated.insert(ast_to_string(*symbol->get_arguments().back()));
+      }
+    } else {
+      has_children = !att.contains(attribute_set::key::Function);
+    }
+
+    if (has_children) {
+      for (auto const &arg : symbol->get_arguments()) {
+        contains[ast_to_string(*sort)].insert(ast_to_string(*arg));
+        may_contain[ast_to_string(*sort)].insert(ast_to_string(*arg));
+      }
+    }
+  }
+
+  // Evaluating a side condition never updates a block in place, as only the
+  // right-hand side of a rule does, but a hook in it may update Bytes.
+  shared_sorts_ = reachable(duplicated, contains);
+  conditions.insert(duplicated.begin(), duplicated.end());
+  aliased_sorts_ = reachable(conditions, may_contain);
+
+  for (auto const &[overload, overloaded] : definition->get_overloads()) {
+    overloaded_.insert(overload->get_name());
+    for (auto *symbol : overloaded) {
+      overloaded_.insert(symbol->get_name());
+    }
+  }
+}
+
+bool in_place_analysis::can_reuse(kore_symbol *symbol) const {
+  if (!is_constructor(definition_, symbol) || !symbol->is_concrete()
+      || symbol->get_arguments().empty()
+      || overloaded_.contains(symbol->get_name())) {
+    return false;
+  }
+
+  auto *decl = definition_->get_symbol_declarations().at(symbol->get_name());
+  auto const &att = decl->attributes();
+  if (att.contains(attribute_set::key::Anywhere)
+      || att.contains(attribute_set::key::SortInjection)
+      || att.contains(attribute_set::key::Binder)) {
+    return false;
+  }
+
+  auto *sort = dynamic_cast<kore_composite_sort *>(symbol->get_sort().get());
+  return sort && sort->get_category(definition_).cat == sort_category::Symbol
+         && !is_shared(ast_to_string(*sort));
+}
+
+std::map<kore_pattern *, reusable_block>
+in_place_analysis::reusable_blocks(kore_axiom_declaration *axiom) const {
+  auto lhs = axiom->get_left_hand_side();
+  if (lhs.size() != 1) {
+    return {};
+  }
+
+  auto *rhs = axiom->get_right_hand_side();
+  auto finder = reuse_finder(definition_, *this, lhs[0], rhs);
+  finder.find(lhs[0], rhs);
+  return std::move(finder.result());
+}
+
+} // namespace kllvm
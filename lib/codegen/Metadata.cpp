@@ -12,7 +12,9 @@ namespace {
 
 std::string kompiled_dir = "kompiled_directory";
 std::string strict_bytes = "enable_mutable_bytes";
+std::string linear_bytes = "linear_bytes";
 std::string safe_partial = "safe_partial";
+std::string contiguous_heap_size = "contiguous_heap_size";
 std::string proof_hint_instrumentation_slow = "proof_hint_instrumentation_slow";
 
 void add_boolean_flag(
@@ -58,6 +60,29 @@ void add_mutable_bytes_flag(llvm::Module &mod, bool enabled, bool debug) {
   add_boolean_flag(mod, strict_bytes, enabled, debug);
 }
 
+void add_linear_bytes_flag(llvm::Module &mod, bool enabled, bool debug) {
+  add_boolean_flag(mod, linear_bytes, enabled, debug);
+}
+
+void add_contiguous_heap_symbol(
+    llvm::Module &mod, uint64_t bytes, bool debug) {
+  auto &ctx = mod.getContext();
+
+  auto *i64_ty = llvm::Type::getInt64Ty(ctx);
+  auto *bytes_cst = llvm::ConstantInt::get(i64_ty, bytes);
+
+  auto *global = mod.getOrInsertGlobal(contiguous_heap_size, i64_ty);
+  auto *global_var = llvm::cast<llvm::GlobalVariable>(global);
+
+  if (!global_var->hasInitializer()) {
+    global_var->setInitializer(bytes_cst);
+  }
+
+  if (debug) {
+    init_debug_global(contiguous_heap_size, get_long_debug_type(), global_var);
+  }
+}
+
 void add_safe_partial_flag(llvm::Module &mod, bool enabled, bool debug) {
   add_boolean_flag(mod, safe_partial, enabled, debug);
 }
@@ -0,0 +1,167 @@
+#include <kllvm/codegen/ApplyPasses.h>
+#include <kllvm/codegen/ObjectCache.h>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+namespace kllvm {
+
+namespace {
+
+struct partition {
+  std::string bitcode;
+  std::string path;
+};
+
+/*
+ * Each partition is compiled in its own context so that partitions can be
+ * compiled in parallel. The object file is written to a temporary file and
+ * then renamed into place, so that a concurrent kompile sharing the same cache
+ * never sees a partially written object.
+ */
+void compile_partition(partition const &part, std::string const &dir) {
+  auto ctx = llvm::LLVMContext{};
+  auto mod = llvm::parseBitcodeFile(
+      llvm::MemoryBufferRef(part.bitcode, part.path), ctx);
+  if (!mod) {
+    throw std::runtime_error(fmt::format(
+        "Could not read partition {}: {}", part.path,
+        llvm::toString(mod.takeError())));
+  }
+
+  int fd = -1;
+  auto tmp_path = llvm::SmallString<128>{};
+  if (auto ec = llvm::sys::fs::createUniqueFile(
+          dir + "/%%%%%%%%%%%%.o.tmp", fd, tmp_path)) {
+    throw std::runtime_error(fmt::format(
+        "Could not create temporary file in object cache {}: {}", dir,
+        ec.message()));
+  }
+
+  auto write_error = std::error_code{};
+  {
+    auto os = llvm::raw_fd_ostream(fd, true);
+    generate_object_file(**mod, os);
+    os.close();
+    write_error = os.error();
+    os.clear_error();
+  }
+
+  if (write_error) {
+    llvm::sys::fs::remove(tmp_path);
+    throw std::runtime_error(fmt::format(
+        "Error writing object file {}: {}", part.path, write_error.message()));
+  }
+
+  if (auto ec = llvm::sys::fs::rename(tmp_path, part.path)) {
+    llvm::sys::fs::remove(tmp_path);
+    throw std::runtime_error(fmt::format(
+        "Could not write object file {}: {}", part.path, ec.message()));
+  }
+}
+
+void compile_partitions(
+    std::vector<partition> const &parts, std::string const &dir) {
+  auto num_threads = std::min<size_t>(
+      parts.size(), std::max(1U, std::thread::hardware_concurrency()));
+
+  auto next = std::atomic<size_t>{0};
+  auto errors = std::vector<std::exception_ptr>(num_threads);
+
+  auto threads = std::vector<std::thread>{};
+  for (size_t t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t] {
+      try {
+        for (auto i = next++; i < parts.size(); i = next++) {
+          compile_partition(parts[i], dir);
+        }
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+    });
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (auto const &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+} // namespace
+
+object_cache::object_cache(std::string dir)
+    : dir_(std::move(dir)) {
+  if (auto ec = llvm::sys::fs::create_directories(dir_)) {
+    throw std::runtime_error(fmt::format(
+        "Could not create object cache {}: {}", dir_, ec.message()));
+  }
+}
+
+std::vector<std::string> object_cache::get_objects(
+    std::unique_ptr<llvm::Module> mod, unsigned partitions) {
+  auto config = fmt::format(
+      "{}\n{}\n{}\n", LLVM_BACKEND_VERSION, LLVM_VERSION_STRING,
+      get_object_file_configuration());
+
+  auto objects = std::vector<std::string>{};
+  auto missing = std::vector<partition>{};
+  auto seen = std::unordered_set<std::string>{};
+
+  llvm::SplitModule(
+      *mod, std::max(1U, partitions), [&](std::unique_ptr<llvm::Module> part) {
+        auto bitcode = std::string{};
+        auto os = llvm::raw_string_ostream(bitcode);
+        llvm::WriteBitcodeToFile(*part, os);
+        os.flush();
+
+        auto sha = llvm::SHA1{};
+        sha.update(config);
+        sha.update(bitcode);
+        auto path
+            = fmt::format("{}/{}.o", dir_, llvm::toHex(sha.final(), true));
+
+        // Empty partitions all have the same key.
+        if (!seen.insert(path).second) {
+          return;
+        }
+
+        if (llvm::sys::fs::exists(path)) {
+          ++stats_.hits;
+        } else {
+          ++stats_.misses;
+          missing.push_back({std::move(bitcode), path});
+        }
+
+        objects.push_back(std::move(path));
+      });
+
+  compile_partitions(missing, dir_);
+
+  return objects;
+}
+
+} // namespace kllvm
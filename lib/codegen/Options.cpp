@@ -48,6 +48,19 @@ cl::opt<bool> force_binary(
     "f", cl::desc("Force binary bitcode output to stdout"), cl::Hidden,
     cl::cat(codegen_lib_cat));
 
+cl::opt<bool> pgo_instrument(
+    "pgo-instrument",
+    cl::desc("Instrument decision trees to count how often each case is taken, "
+             "writing the counts to a branch profile when the interpreter "
+             "exits"),
+    cl::cat(codegen_lib_cat));
+
+cl::opt<std::string> pgo_profile(
+    "pgo-profile",
+    cl::desc("Optimize decision trees using the counts in this branch profile, "
+             "as produced by an interpreter built with --pgo-instrument"),
+    cl::cat(codegen_lib_cat));
+
 namespace kllvm {
 
 void validate_codegen_args(bool is_tty) {
@@ -62,6 +75,11 @@ void validate_codegen_args(bool is_tty) {
         "or force binary with -f\n");
   }
 
+  if (pgo_instrument && !pgo_profile.empty()) {
+    throw std::runtime_error(
+        "Cannot specify --pgo-instrument with --pgo-profile");
+  }
+
   if (proof_hint_instrumentation_slow) {
     proof_hint_instrumentation = true;
   }
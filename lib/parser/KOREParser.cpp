@@ -79,9 +79,12 @@ token kore_parser::peek() {
   return buffer_.tok;
 }
 
-ptr<kore_definition> kore_parser::definition() {
+ptr<kore_definition> kore_parser::definition(bool use_arena) {
   consume(token::LeftBracket);
-  auto result = kore_definition::create();
+  auto result = kore_definition::create(use_arena);
+  if (use_arena) {
+    arena_ = result->get_arena();
+  }
   attributes(result.get());
   consume(token::RightBracket);
   modules(result.get());
@@ -251,12 +254,14 @@ void kore_parser::sort_variables(kore_declaration *node) {
 
 void kore_parser::sort_variables_ne(kore_declaration *node) {
   std::string name = consume(token::Id);
-  auto var = kore_sort_variable::create(name);
+  auto var = arena_ ? arena_->sort_variable(name)
+                    : kore_sort_variable::create(name);
   node->add_object_sort_variable(var);
   while (peek() == token::Comma) {
     consume(token::Comma);
     name = consume(token::Id);
-    var = kore_sort_variable::create(name);
+    var = arena_ ? arena_->sort_variable(name)
+                 : kore_sort_variable::create(name);
     node->add_object_sort_variable(var);
   }
 }
@@ -279,13 +284,9 @@ void kore_parser::sorts_ne(Node *node) {
   }
 }
 
-std::pair<std::string, std::vector<sptr<kore_sort>>>
-kore_parser::symbol_sort_list() {
+std::vector<sptr<kore_sort>> kore_parser::sort_list() {
   auto ret = std::vector<sptr<kore_sort>>{};
 
-  auto id = consume(token::Id);
-  consume(token::LeftBrace);
-
   if (peek() == token::Id) {
     ret.push_back(sort());
 
@@ -295,6 +296,14 @@ kore_parser::symbol_sort_list() {
     }
   }
 
+  return ret;
+}
+
+std::pair<std::string, std::vector<sptr<kore_sort>>>
+kore_parser::symbol_sort_list() {
+  auto id = consume(token::Id);
+  consume(token::LeftBrace);
+  auto ret = sort_list();
   consume(token::RightBrace);
   return {id, ret};
 }
@@ -303,11 +312,21 @@ sptr<kore_sort> kore_parser::sort() {
   std::string name = consume(token::Id);
   if (peek() == token::LeftBrace) {
     consume(token::LeftBrace);
+    if (arena_) {
+      // Sorts are hash-consed in arena mode, so we can only look up the node
+      // once all of its arguments are known.
+      auto args = sort_list();
+      consume(token::RightBrace);
+      return arena_->composite_sort(name, args);
+    }
     auto sort = kore_composite_sort::create(name);
     sorts(sort.get());
     consume(token::RightBrace);
     return sort;
   }
+  if (arena_) {
+    return arena_->sort_variable(name);
+  }
   return kore_sort_variable::create(name);
 }
 
@@ -320,13 +339,13 @@ sptr<kore_pattern> kore_parser::pattern_internal() {
     switch (current) {
     case token::Colon:
       consume(token::Colon);
-      return kore_variable_pattern::create(name, sort());
+      return kore_variable_pattern::create(name, sort(), arena_);
     case token::LeftBrace: return application_pattern(name);
     default: error(loc_, "Expected: [:, {] Actual: " + str(current));
     }
   }
   case token::String:
-    return kore_string_pattern::create(consume(token::String));
+    return kore_string_pattern::create(consume(token::String), arena_);
   default: error(loc_, "Expected: [<id>, <string>] Actual: " + str(current));
   }
 }
@@ -334,7 +353,7 @@ sptr<kore_pattern> kore_parser::pattern_internal() {
 sptr<kore_pattern> kore_parser::application_pattern() {
   return application_pattern(consume(token::Id));
 }
-ptr<kore_composite_pattern> kore_parser::application_pattern_internal() {
+sptr<kore_composite_pattern> kore_parser::application_pattern_internal() {
   return application_pattern_internal(consume(token::Id));
 }
 
@@ -353,7 +372,7 @@ sptr<kore_pattern> kore_parser::application_pattern(std::string const &name) {
       sptr<kore_pattern> accum = pats[0];
       for (auto i = 1U; i < pats.size(); i++) {
         sptr<kore_composite_pattern> new_accum
-            = kore_composite_pattern::create(sym.get());
+            = kore_composite_pattern::create(sym.get(), arena_);
         new_accum->add_argument(accum);
         new_accum->add_argument(pats[i]);
         accum = new_accum;
@@ -363,7 +382,7 @@ sptr<kore_pattern> kore_parser::application_pattern(std::string const &name) {
     sptr<kore_pattern> accum = pats[pats.size() - 1];
     for (int i = pats.size() - 2; i >= 0; i--) {
       sptr<kore_composite_pattern> new_accum
-          = kore_composite_pattern::create(sym.get());
+          = kore_composite_pattern::create(sym.get(), arena_);
       new_accum->add_argument(pats[i]);
       new_accum->add_argument(accum);
       accum = new_accum;
@@ -373,7 +392,7 @@ sptr<kore_pattern> kore_parser::application_pattern(std::string const &name) {
   auto result = application_pattern_internal(name);
   if (name == "\\or") {
     if (result->get_arguments().empty()) {
-      auto pat = kore_composite_pattern::create("\\bottom");
+      auto pat = kore_composite_pattern::create("\\bottom", arena_);
       pat->get_constructor()->add_argument(
           result->get_constructor()->get_formal_arguments()[0]);
       pat->get_constructor()->init_pattern_arguments();
@@ -384,7 +403,7 @@ sptr<kore_pattern> kore_parser::application_pattern(std::string const &name) {
     }
   } else if (name == "\\and") {
     if (result->get_arguments().empty()) {
-      auto pat = kore_composite_pattern::create("\\top");
+      auto pat = kore_composite_pattern::create("\\top", arena_);
       pat->get_constructor()->add_argument(
           result->get_constructor()->get_formal_arguments()[0]);
       pat->get_constructor()->init_pattern_arguments();
@@ -407,10 +426,10 @@ ptr<kore_symbol> kore_parser::symbol() {
   return std::make_unique<kore_symbol>(*pat->get_constructor());
 }
 
-ptr<kore_composite_pattern>
+sptr<kore_composite_pattern>
 kore_parser::application_pattern_internal(std::string const &name) {
   consume(token::LeftBrace);
-  auto pat = kore_composite_pattern::create(name);
+  auto pat = kore_composite_pattern::create(name, arena_);
   sorts(pat->get_constructor());
   pat->get_constructor()->init_pattern_arguments();
   consume(token::RightBrace);
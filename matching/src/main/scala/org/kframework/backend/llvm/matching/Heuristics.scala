@@ -427,6 +427,29 @@ object OHeuristic extends Heuristic {
     if (BHeuristic.bf(c, key) == 1) 1 else 0
 }
 
+/**
+ * Indexing heuristic. Prefers the columns on the path from the top cell to the head of the `<k>`
+ * cell, and the child of an injection at that head. Used first, it makes the top-level decision
+ * tree decompose the configuration straight down to the term being evaluated and switch on its
+ * tag before testing anything else, so that each case of that switch is a sub-tree containing
+ * only the rules that can apply to such a term. The switch is lowered to a jump table indexed by
+ * the tag.
+ */
+@NamedHeuristic(name = 'k')
+object KHeuristic extends Heuristic {
+  val needsMatrix: Boolean = false
+
+  def computeScoreForKey(c: AbstractColumn, key: Option[Pattern[Option[Occurrence]]]): Double = {
+    val fringe = c.column.fringe
+    val symlib = fringe.symlib
+    fringe.occurrence match {
+      case o if symlib.dispatchSpine.get(o).contains(fringe.sort)          => 1.0
+      case Num(0, o) if fringe.isExact && symlib.dispatchHead.contains(o) => 1.0
+      case _                                                                => 0.0
+    }
+  }
+}
+
 sealed trait PseudoHeuristic extends Heuristic {
   val needsMatrix: Boolean = false
 
@@ -3,10 +3,10 @@ package org.kframework.backend.llvm.matching
 import com.runtimeverification.k.kore._
 import com.runtimeverification.k.kore.parser.TextToKore
 import java.io.File
-import java.io.FileWriter
 import java.util.Optional
 import org.kframework.backend.llvm.matching.dt._
 import scala.collection.immutable
+import scala.collection.mutable
 import scala.collection.parallel.CollectionConverters._
 
 object Matching {
@@ -20,95 +20,168 @@ object Matching {
       genSearch: Boolean,
       kem: MatchingException => Unit
   ): Unit = {
-    val defn = new TextToKore().parse(filename)
+    val timer = new PhaseTimer
+    val defn  = timer.time("parse definition")(new TextToKore().parse(filename))
     outputFolder.mkdirs()
-    val allAxioms    = Parser.getAxioms(defn)
-    val axioms       = Parser.parseTopAxioms(allAxioms, search = false)
-    val searchAxioms = Parser.parseTopAxioms(allAxioms, search = true)
-    val symlib       = Parser.parseSymbols(defn, heuristic)
-    val (dt, dtSearch, matrix) = if (axioms.isEmpty) {
-      (Failure(), Failure(), null)
-    } else {
-      val matrix =
-        Generator.genClauseMatrix(symlib, defn, axioms, immutable.Seq(axioms.head.rewrite.sort))
-      val searchMatrix =
-        Generator.genClauseMatrix(
-          symlib,
-          defn,
-          searchAxioms,
-          immutable.Seq(searchAxioms.head.rewrite.sort)
-        )
-      if (warn) {
-        searchMatrix.checkUsefulness(kem)
-      }
-      if (genSearch) {
-        (matrix.compile, searchMatrix.compileSearch, matrix)
-      } else {
-        (matrix.compile, Failure(), matrix)
-      }
+    val (axioms, searchAxioms, funcAxioms, symlib) = timer.time("parse axioms") {
+      val allAxioms = Parser.getAxioms(defn)
+      (
+        Parser.parseTopAxioms(allAxioms, search = false),
+        Parser.parseTopAxioms(allAxioms, search = true),
+        Parser.parseFunctionAxioms(allAxioms, simplification = false),
+        Parser.parseSymbols(defn, heuristic)
+      )
     }
-    if (genSingleRuleTrees) {
-      for (axiom <- axioms.par) {
+    val stepSymlib = indexedSymlib(symlib, axioms.size, heuristic)
+    if (stepSymlib ne symlib) {
+      timer.note("indexing top-level rules on the head of the <k> cell")
+    }
+    val (dt, dtSearch, matrix) = timer.time("compile step trees") {
+      if (axioms.isEmpty) {
+        (Failure(), Failure(), null)
+      } else {
         val matrix =
           Generator.genClauseMatrix(
-            symlib,
+            stepSymlib,
             defn,
-            immutable.IndexedSeq(axiom),
-            immutable.Seq(axiom.rewrite.sort)
+            axioms,
+            immutable.Seq(axioms.head.rewrite.sort)
           )
-        val dt       = matrix.compile
-        val filename = "match_" + axiom.ordinal + ".yaml"
-        dt.serializeToYaml(new File(outputFolder, filename))
+        val searchMatrix =
+          Generator.genClauseMatrix(
+            stepSymlib,
+            defn,
+            searchAxioms,
+            immutable.Seq(searchAxioms.head.rewrite.sort)
+          )
+        if (warn) {
+          searchMatrix.checkUsefulness(kem)
+        }
+        Matrix.withCache {
+          if (genSearch) {
+            (matrix.compile, searchMatrix.compileSearch, matrix)
+          } else {
+            (matrix.compile, Failure(), matrix)
+          }
+        }
       }
     }
-    val funcAxioms = Parser.parseFunctionAxioms(allAxioms, simplification = false)
-    val dts = symlib.functions.map { f =>
-      if (logging) {
-        System.out.println("Compiling " + f)
-      }
-      if (symlib.isHooked(f)) {
-        Failure()
-      } else {
-        Generator.mkDecisionTree(
-          symlib,
-          defn,
-          funcAxioms.getOrElse(f, immutable.IndexedSeq()),
-          symlib.signatures(f)._1,
-          f,
-          kem
-        )
+    // Every tree is written to a single indexed file, in a deterministic
+    // order; trees that are compiled in parallel are collected first.
+    val trees = new DecisionTreeFile()
+    trees.add("dt", dt)
+    trees.add("dt-search", dtSearch)
+    if (genSingleRuleTrees) {
+      val matchTrees = timer.time("compile single-rule trees") {
+        axioms.par.map { axiom =>
+          val matrix =
+            Generator.genClauseMatrix(
+              symlib,
+              defn,
+              immutable.IndexedSeq(axiom),
+              immutable.Seq(axiom.rewrite.sort)
+            )
+          (axiom.ordinal, Matrix.withCache(matrix.compile))
+        }.seq
       }
+      for ((ordinal, dt) <- matchTrees)
+        trees.add("match_" + ordinal, dt)
     }
-    val path       = new File(outputFolder, "dt.yaml")
-    val pathSearch = new File(outputFolder, "dt-search.yaml")
-    dt.serializeToYaml(path)
-    dtSearch.serializeToYaml(pathSearch)
     if (threshold.isPresent) {
-      axioms.par.foreach { a =>
+      val specialTrees = timer.time("compile specialized trees") {
+        axioms.par.map { a =>
+          if (logging) {
+            System.out.println("Compiling decision tree for axiom " + a.ordinal)
+          }
+          val special = Matrix.withCache {
+            Generator.mkSpecialDecisionTree(symlib, defn, matrix, a, threshold.get)
+          }
+          (a.ordinal, special)
+        }.seq
+      }
+      for ((ordinal, special) <- specialTrees; (dt, residuals) <- special)
+        trees.add("dt_" + ordinal, dt, residuals)
+    }
+    // Warnings from each function are buffered and reported in order once
+    // every tree has been compiled, so that the output does not depend on
+    // scheduling.
+    val dts = timer.time("compile function trees") {
+      symlib.functions.par.map { f =>
         if (logging) {
-          System.out.println("Compiling decision tree for axiom " + a.ordinal)
+          System.out.println("Compiling " + f)
         }
-        Matrix.clearCache()
-        val dt       = Generator.mkSpecialDecisionTree(symlib, defn, matrix, a, threshold.get)
-        val ordinal  = a.ordinal
-        val filename = "dt_" + ordinal + ".yaml"
-        if (dt.isDefined) {
-          dt.get._1.serializeToYaml(new File(outputFolder, filename), dt.get._2)
+        val warnings = mutable.ArrayBuffer[MatchingException]()
+        val dt = if (symlib.isHooked(f)) {
+          Failure()
+        } else {
+          Matrix.withCache {
+            Generator.mkDecisionTree(
+              symlib,
+              defn,
+              funcAxioms.getOrElse(f, immutable.IndexedSeq()),
+              symlib.signatures(f)._1,
+              f,
+              warnings += _
+            )
+          }
         }
-      }
+        (f, dt, warnings)
+      }.seq
+    }
+    for ((f, dt, warnings) <- dts) {
+      warnings.foreach(kem)
+      trees.add(f.ctr, dt)
     }
-    val files  = symlib.functions.lazyZip(dts).toSeq
-    val index  = new File(outputFolder, "index.txt")
-    val writer = new FileWriter(index)
-    var idx    = 0
-    for (pair <- files.par) {
-      val sym      = pair._1.ctr
-      val filename = (if (sym.length > 240) sym.substring(0, 240) + idx else sym) + ".yaml"
-      pair._2.serializeToYaml(new File(outputFolder, filename))
-      writer.write(pair._1.ctr + "\t" + filename + "\n")
-      idx += 1
+    timer.time("write decision trees") {
+      trees.write(new File(outputFolder, "decision_trees.bin"))
     }
-    writer.close()
+  }
+
+  /**
+   * Definitions with at least this many top-level rules have their step trees indexed on the head
+   * of the `<k>` cell even if the `k` heuristic was not requested. Below this, the default
+   * heuristics reach the head of the `<k>` cell quickly enough.
+   */
+  val indexingThreshold = 512
+
+  /**
+   * The symbol library to compile the top-level rules with: the `k` heuristic is put in front of
+   * the others for large definitions with a `<k>` cell.
+   */
+  private def indexedSymlib(
+      symlib: Parser.SymLib,
+      numAxioms: Int,
+      heuristic: String
+  ): Parser.SymLib =
+    if (
+      numAxioms >= indexingThreshold && !heuristic.contains('k') && symlib.dispatchSpine.nonEmpty
+    ) {
+      symlib.withHeuristics(KHeuristic +: symlib.heuristics)
+    } else {
+      symlib
+    }
+
+  /**
+   * Reports the wall-clock time taken by each phase of decision tree compilation to stderr when
+   * KLLVM_MATCHING_TIMING is set in the environment.
+   */
+  private class PhaseTimer {
+    private val enabled = sys.env.contains("KLLVM_MATCHING_TIMING")
+
+    def time[T](phase: String)(body: => T): T = {
+      val start  = System.nanoTime()
+      val result = body
+      if (enabled) {
+        val elapsed = (System.nanoTime() - start) / 1e9
+        System.err.println(f"[matching] $phase%s: $elapsed%.3fs")
+      }
+      result
+    }
+
+    def note(message: String): Unit =
+      if (enabled) {
+        System.err.println(s"[matching] $message")
+      }
   }
 
   var logging = false
@@ -6,7 +6,7 @@ import com.runtimeverification.k.kore.Sort
 import com.runtimeverification.k.kore.SymbolOrAlias
 import com.runtimeverification.k.kore.Variable
 import java.util
-import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.atomic.AtomicInteger
 import java.util.Optional
 import org.kframework.backend.llvm.matching.dt._
 import org.kframework.backend.llvm.matching.pattern._
@@ -554,25 +554,20 @@ class Matrix private (
       )
     )
 
-  private var specializing: Option[immutable.IndexedSeq[Pattern[String]]] = None
-
   // compute the column with the best score, choosing the first such column if they are equal
-  lazy val bestColIx: Int =
-    if (specializing.isDefined) {
-      columns.indices.find(i => !isWildcardOrResidual(specializing.get(i))).get
+  lazy val bestColIx: Int = {
+    val allBest = if (validCols.nonEmpty) {
+      Heuristic.getBest(validCols, matrixColumns)
     } else {
-      val allBest = if (validCols.nonEmpty) {
-        Heuristic.getBest(validCols, matrixColumns)
-      } else {
-        Heuristic.getBest(matrixColumns, matrixColumns)
-      }
-      import Ordering.Implicits._
-      val best = symlib.heuristics.last.breakTies(allBest)
-      if (Matching.logging) {
-        System.out.println("Chose column " + best.colIx)
-      }
-      best.colIx
+      Heuristic.getBest(matrixColumns, matrixColumns)
+    }
+    import Ordering.Implicits._
+    val best = symlib.heuristics.last.breakTies(allBest)
+    if (Matching.logging) {
+      System.out.println("Chose column " + best.colIx)
     }
+    best.colIx
+  }
 
   lazy val bestCol: Column = columns(bestColIx)
 
@@ -604,7 +599,7 @@ class Matrix private (
     sigma.map(specialize(_, bestColIx, None))
 
   lazy val compiledCases: immutable.Seq[(String, immutable.Seq[String], DecisionTree)] = {
-    Matrix.remaining += sigma.length
+    Matrix.remaining.addAndGet(sigma.length)
     if (Matching.logging) {
       System.out.println("Signature:")
       System.out.println(sigma.map(_.toString).mkString("\n"))
@@ -615,7 +610,7 @@ class Matrix private (
       }
       (l._1, l._2, l._3.compile)
     }
-    Matrix.remaining -= sigma.length
+    Matrix.remaining.addAndGet(-sigma.length)
     result
   }
 
@@ -686,9 +681,9 @@ class Matrix private (
     }
 
   lazy val compiledDefault: Option[DecisionTree] = {
-    Matrix.remaining += 1
+    Matrix.remaining.incrementAndGet()
     val result = default(bestColIx, sigma).map(_.compile)
-    Matrix.remaining -= 1
+    Matrix.remaining.decrementAndGet()
     result
   }
 
@@ -863,10 +858,11 @@ class Matrix private (
   lazy val bestRow: Row = rows(bestRowIx)
 
   def compile: DecisionTree = {
-    val result = Matrix.cache.get(this)
+    val cache  = Matrix.cache.get
+    val result = cache.get(this)
     if (result == null) {
       val computed = compileInternal
-      Matrix.cache.put(this, computed)
+      cache.put(this, computed)
       computed
     } else {
       result
@@ -1005,12 +1001,12 @@ class Matrix private (
         if (matrixDefault.isEmpty) {
           None
         } else {
-          val id = Matrix.id
+          val id = Matrix.id.get
           if (Matching.logging) {
             System.out.println("-- Exhaustive --")
             System.out.println("Matrix " + id + ": ")
             System.out.println(this)
-            Matrix.id += 1
+            Matrix.id.incrementAndGet()
           }
           val child = matrixDefault.get.nonExhaustive
           if (child.isEmpty) {
@@ -1039,13 +1035,13 @@ class Matrix private (
         }
       } else {
         for (con <- sigma) {
-          val id = Matrix.id
+          val id = Matrix.id.get
           if (Matching.logging) {
             System.out.println("Testing constructor " + con)
             System.out.println("-- Exhaustive --")
             System.out.println("Matrix " + id + ": ")
             System.out.println(this)
-            Matrix.id += 1
+            Matrix.id.incrementAndGet()
           }
           val child = specialize(con, 0, None)._3.nonExhaustive
           if (child.isDefined) {
@@ -1081,13 +1077,13 @@ class Matrix private (
       }
 
   def checkExhaustiveness(name: SymbolOrAlias, kem: MatchingException => Unit): Unit = {
-    Matrix.id = 0
-    val id = Matrix.id
+    Matrix.id.set(0)
+    val id = Matrix.id.get
     if (Matching.logging) {
       System.out.println("-- Exhaustive --")
       System.out.println("Matrix " + id + ": ")
       System.out.println(this)
-      Matrix.id += 1
+      Matrix.id.incrementAndGet()
     }
     val counterexample = nonExhaustive
     if (counterexample.isDefined) {
@@ -1132,7 +1128,6 @@ class Matrix private (
         case LiteralP(lit, _) => LiteralC(lit)
         case _                => ???
       }
-    specializing = Some(ps)
     if (Matching.logging) {
       System.out.println(
         "Specializing by:\n" + ps
@@ -1145,14 +1140,17 @@ class Matrix private (
     if (clauses.isEmpty || columns.indices.forall(i => isWildcardOrResidual(ps(i)))) {
       (this, ps)
     } else {
-      val residual = ps(bestColIx)
+      // The same matrix is specialized by many axioms in parallel, so the
+      // column is chosen here rather than stored on the matrix.
+      val colIx    = columns.indices.find(i => !isWildcardOrResidual(ps(i))).get
+      val residual = ps(colIx)
       if (Matching.logging) {
-        System.out.println("Chose column " + bestColIx)
+        System.out.println("Chose column " + colIx)
       }
       val constructor = getConstructor(residual)
-      val specialized = specialize(constructor, bestColIx, Some(residual))
+      val specialized = specialize(constructor, colIx, Some(residual))
       val args        = expandChildren(residual)
-      specialized._3.specializeBy(args ++ ps.patch(bestColIx, Nil, 1))
+      specialized._3.specializeBy(args ++ ps.patch(colIx, Nil, 1))
     }
   }
 
@@ -1213,8 +1211,6 @@ class Matrix private (
 }
 
 object Matrix {
-  var remaining = 0
-
   def fromRows(
       symlib: Parser.SymLib,
       rows: immutable.IndexedSeq[Row],
@@ -1231,10 +1227,22 @@ object Matrix {
   ): Matrix =
     new Matrix(symlib, cols, null, clauses, null, search)
 
-  private val cache = new ConcurrentHashMap[Matrix, DecisionTree]()
-
-  def clearCache(): Unit =
-    cache.clear()
+  // Decision trees are compiled in parallel, one tree per thread at a time,
+  // so each thread memoizes the matrices it has compiled separately.
+  private val cache = ThreadLocal.withInitial(() => new util.HashMap[Matrix, DecisionTree]())
+
+  /**
+   * Compiles one or more decision trees on the calling thread, starting from an empty cache. The
+   * cache is emptied again afterwards, so that a pooled thread does not keep the matrices of a task
+   * that has finished alive, and so that the next task on that thread does not see them.
+   */
+  def withCache[T](task: => T): T = {
+    val c = cache.get
+    c.clear()
+    try task
+    finally c.clear()
+  }
 
-  var id = 0
+  val remaining = new AtomicInteger()
+  val id        = new AtomicInteger()
 }
@@ -2,7 +2,7 @@ package org.kframework.backend.llvm.matching
 
 import com.runtimeverification.k.kore._
 import com.runtimeverification.k.kore.implementation.{ DefaultBuilders => B }
-import java.util
+import java.util.concurrent.ConcurrentHashMap
 import java.util.Optional
 import scala.collection.immutable
 
@@ -54,7 +54,7 @@ object Parser {
       overloadSeq: immutable.Seq[(SymbolOrAlias, SymbolOrAlias)],
       val heuristics: immutable.Seq[Heuristic]
   ) {
-    val sortCache = new util.HashMap[Sort, SortInfo]()
+    val sortCache = new ConcurrentHashMap[Sort, SortInfo]()
 
     private val symbolDecls = mod.modules
       .flatMap(_.decls)
@@ -150,6 +150,49 @@ object Parser {
     def isSubsorted(less: Sort, greater: Sort): Boolean =
       signatures.contains(B.SymbolOrAlias("inj", immutable.Seq(less, greater)))
 
+    /**
+     * The occurrences on the path from the top cell down to the head of the `<k>` cell, with the
+     * sort of the term at each one. Empty if the configuration has no `<k>` cell.
+     */
+    lazy val dispatchSpine: Map[Occurrence, Sort] = {
+      def isCell(symbol: SymbolOrAlias): Boolean = symbol.ctr.startsWith("Lbl'-LT-'")
+
+      def find(sort: Sort, occ: Occurrence, seen: Set[Sort]): Option[Map[Occurrence, Sort]] =
+        if (seen.contains(sort)) {
+          None
+        } else {
+          constructorsForSort
+            .getOrElse(sort, immutable.Seq())
+            .filter(isCell)
+            .view
+            .flatMap { symbol =>
+              val args = signatures(symbol)._1
+              if (symbol.ctr == "Lbl'-LT-'k'-GT-'" && args.size == 1) {
+                val k = Num(0, occ)
+                Some(Map(k -> args.head, Num(0, k) -> kItem))
+              } else {
+                args.zipWithIndex.view.flatMap { case (arg, i) =>
+                  find(arg, Num(i, occ), seen + sort)
+                }.headOption
+              }
+            }
+            .headOption
+            .map(_ + (occ -> sort))
+        }
+
+      find(B.CompoundSort("SortGeneratedTopCell", immutable.Seq()), Base(), Set())
+        .getOrElse(Map())
+    }
+
+    /** The occurrence of the head of the `<k>` cell, if there is one. */
+    lazy val dispatchHead: Option[Occurrence] =
+      dispatchSpine.collectFirst { case (occ, sort) if sort == kItem => occ }
+
+    def kItem: Sort = B.CompoundSort("SortKItem", immutable.Seq())
+
+    def withHeuristics(newHeuristics: immutable.Seq[Heuristic]): SymLib =
+      new SymLib(symbols, sorts, mod, overloadSeq, newHeuristics)
+
     private val hookAtts: Map[String, String] =
       sortAttData.map(t => (t._1.substring(4), getStringAtt(t._2, "hook").getOrElse("")))
   }
@@ -0,0 +1,307 @@
+package org.kframework.backend.llvm.matching.dt
+
+import java.io.BufferedOutputStream
+import java.io.ByteArrayOutputStream
+import java.io.File
+import java.io.FileOutputStream
+import java.io.OutputStream
+import java.nio.charset.StandardCharsets
+import java.nio.ByteBuffer
+import java.util
+import org.kframework.backend.llvm.matching.pattern._
+import org.kframework.backend.llvm.matching.Occurrence
+import scala.collection.immutable
+
+/**
+ * Collects every decision tree for a definition into a single file, in the binary format read by
+ * `decision_tree_file` in lib/codegen/DecisionParser.cpp (see include/kllvm/codegen/DecisionParser.h
+ * for the layout).
+ *
+ * Decision tree nodes are hash-consed by their constructors, so a node that is shared within or
+ * between trees is written once and referred to by its index. Strings are likewise stored once in
+ * a table and referred to by index. Trees should be added in a deterministic order so that the
+ * output is stable between runs on the same definition.
+ */
+class DecisionTreeFile {
+  private val strings      = new util.HashMap[ByteBuffer, Integer]()
+  private val stringData   = new DecisionTreeFile.Buffer
+  private val nodeIndices  = new util.IdentityHashMap[DecisionTree, Integer]()
+  private val nodeOffsets  = new util.ArrayList[Integer]()
+  private val nodeData     = new DecisionTreeFile.Buffer
+  private val residualData = new DecisionTreeFile.Buffer
+  private val trees        = new DecisionTreeFile.Buffer
+  private var numTrees     = 0
+
+  def add(name: String, dt: DecisionTree): Unit = {
+    val root = node(dt)
+    trees.u32(string(name))
+    trees.u32(root)
+    trees.u32(0)
+    numTrees += 1
+  }
+
+  def add(
+      name: String,
+      dt: DecisionTree,
+      residuals: immutable.Seq[(Pattern[String], Occurrence)]
+  ): Unit = {
+    val root   = node(dt)
+    val offset = residualData.size
+    residualData.u32(residuals.size)
+    for ((pat, occurrence) <- residuals) {
+      residual(residualData, pat)
+      this.occurrence(residualData, occurrence)
+    }
+    trees.u32(string(name))
+    trees.u32(root)
+    trees.u32(offset + 1)
+    numTrees += 1
+  }
+
+  def write(file: File): Unit = {
+    val out    = new BufferedOutputStream(new FileOutputStream(file))
+    val header = new DecisionTreeFile.Buffer
+    header.bytes.write(DecisionTreeFile.magic)
+    header.u32(DecisionTreeFile.version)
+    header.u32(strings.size)
+    header.u32(nodeOffsets.size)
+    header.u32(numTrees)
+    header.writeTo(out)
+
+    stringData.writeTo(out)
+
+    val offsets = new DecisionTreeFile.Buffer
+    offsets.u32(nodeData.size)
+    nodeOffsets.forEach(offset => offsets.u32(offset))
+    offsets.writeTo(out)
+    nodeData.writeTo(out)
+
+    val residualSize = new DecisionTreeFile.Buffer
+    residualSize.u32(residualData.size)
+    residualSize.writeTo(out)
+    residualData.writeTo(out)
+
+    trees.writeTo(out)
+    out.close()
+  }
+
+  private def bytes(b: Array[Byte]): Int = {
+    val key      = ByteBuffer.wrap(b)
+    val existing = strings.get(key)
+    if (existing != null) {
+      return existing
+    }
+    val idx = strings.size
+    strings.put(key, idx)
+    stringData.u32(b.length)
+    stringData.bytes.write(b)
+    idx
+  }
+
+  private def string(s: String): Int = bytes(s.getBytes(StandardCharsets.UTF_8))
+
+  private def occurrence(out: DecisionTreeFile.Buffer, o: Occurrence): Unit = {
+    val rep = o.representation
+    out.u32(rep.size)
+    rep.forEach(part => out.u32(string(part.toString)))
+  }
+
+  private def vars(out: DecisionTreeFile.Buffer, vs: immutable.Seq[(Occurrence, String)]): Unit = {
+    out.u32(vs.size)
+    for ((o, hook) <- vs) {
+      occurrence(out, o)
+      out.u32(string(hook))
+    }
+  }
+
+  private def cases(
+      out: DecisionTreeFile.Buffer,
+      cs: immutable.Seq[(String, immutable.Seq[String], DecisionTree)],
+      children: immutable.Seq[Int],
+      default: Option[Int]
+  ): Unit = {
+    out.u32(cs.size)
+    for (((c, bindings, _), child) <- cs.zip(children)) {
+      out.u32(string(c))
+      out.u32(child)
+      out.u32(bindings.size)
+      for (binding <- bindings)
+        out.u32(string(binding))
+    }
+    out.u32(default.getOrElse(DecisionTreeFile.none))
+  }
+
+  private def pattern(out: DecisionTreeFile.Buffer, pat: Pattern[Option[Occurrence]]): Unit =
+    pat match {
+      case OrP(_) | WildcardP() | VariableP(None, _) => ???
+      case VariableP(Some(o), h) =>
+        out.u8(DecisionTreeFile.variablePattern)
+        occurrence(out, o)
+        out.u32(string(h.hookAtt))
+      case AsP(_, _, p)            => pattern(out, p)
+      case MapP(_, _, _, _, o)     => pattern(out, o)
+      case SetP(_, _, _, o)        => pattern(out, o)
+      case ListP(_, _, _, _, o)    => pattern(out, o)
+      case ListGetP(_, _, _, _, o) => pattern(out, o)
+      case LiteralP(s, h) =>
+        out.u8(DecisionTreeFile.literalPattern)
+        out.u32(string(h.hookAtt))
+        if (h.hookAtt == "BYTES.Bytes") {
+          out.u32(bytes(s.getBytes(StandardCharsets.ISO_8859_1)))
+        } else {
+          out.u32(string(s))
+        }
+      case SymbolP(s, ps) =>
+        out.u8(DecisionTreeFile.symbolPattern)
+        out.u32(string(s.toString))
+        out.u32(ps.size)
+        for (p <- ps)
+          pattern(out, p)
+    }
+
+  private def residual(out: DecisionTreeFile.Buffer, pat: Pattern[String]): Unit =
+    pat match {
+      case OrP(_) | WildcardP() => ???
+      case VariableP(o, h) =>
+        out.u8(DecisionTreeFile.residualVariablePattern)
+        out.u32(string(o))
+        out.u32(string(h.hookAtt))
+      case AsP(_, _, p)            => residual(out, p)
+      case MapP(_, _, _, _, o)     => residual(out, o)
+      case SetP(_, _, _, o)        => residual(out, o)
+      case ListP(_, _, _, _, o)    => residual(out, o)
+      case ListGetP(_, _, _, _, o) => residual(out, o)
+      case LiteralP(s, h) =>
+        out.u8(DecisionTreeFile.literalPattern)
+        out.u32(string(h.hookAtt))
+        out.u32(string(s))
+      case SymbolP(s, ps) =>
+        out.u8(DecisionTreeFile.symbolPattern)
+        out.u32(string(s.toString))
+        out.u32(ps.size)
+        for (p <- ps)
+          residual(out, p)
+    }
+
+  private def node(dt: DecisionTree): Int = {
+    val existing = nodeIndices.get(dt)
+    if (existing != null) {
+      return existing
+    }
+
+    // Children are written before their parents, so that every reference to
+    // a node is to one that has already been assigned an index.
+    val out = new DecisionTreeFile.Buffer
+    dt match {
+      case _: Failure =>
+        out.u8(DecisionTreeFile.failNode)
+      case l: Leaf =>
+        out.u8(DecisionTreeFile.leafNode)
+        out.u32(l.ordinal)
+        vars(out, l.occurrences)
+      case l: SearchLeaf =>
+        val next = node(l.child)
+        out.u8(DecisionTreeFile.searchLeafNode)
+        out.u32(l.ordinal)
+        vars(out, l.occurrences)
+        out.u32(next)
+      case s: Switch =>
+        val children = s.cases.map(c => node(c._3))
+        val default  = s.default.map(node)
+        out.u8(DecisionTreeFile.switchNode)
+        occurrence(out, s.occurrence)
+        out.u32(string(s.hook))
+        cases(out, s.cases, children, default)
+      case s: SwitchLit =>
+        val children = s.cases.map(c => node(c._3))
+        val default  = s.default.map(node)
+        out.u8(DecisionTreeFile.switchLitNode)
+        occurrence(out, s.occurrence)
+        out.u32(string(s.hook))
+        out.u32(s.bitwidth)
+        cases(out, s.cases, children, default)
+      case s: CheckNull =>
+        val children = s.cases.map(c => node(c._3))
+        val default  = s.default.map(node)
+        out.u8(DecisionTreeFile.checkNullNode)
+        occurrence(out, s.occurrence)
+        out.u32(string(s.hook))
+        cases(out, s.cases, children, default)
+      case f: Function =>
+        val next = node(f.child)
+        out.u8(DecisionTreeFile.functionNode)
+        out.u32(string(f.name))
+        out.u32(string(f.hook))
+        occurrence(out, f.occurrence)
+        vars(out, f.vars)
+        out.u32(next)
+      case m: MakePattern =>
+        val next = node(m.child)
+        out.u8(DecisionTreeFile.makePatternNode)
+        occurrence(out, m.occurrence)
+        out.u32(string(m.hook))
+        pattern(out, m.pattern)
+        out.u32(next)
+      case m: MakeIterator =>
+        val next = node(m.child)
+        out.u8(DecisionTreeFile.makeIteratorNode)
+        out.u32(string(m.hookName))
+        occurrence(out, m.occurrence)
+        out.u32(string(if (m.hookName == "set_iterator") "SET.Set" else "MAP.Map"))
+        out.u32(next)
+      case i: IterNext =>
+        val next = node(i.child)
+        out.u8(DecisionTreeFile.iterNextNode)
+        out.u32(string(i.hookName))
+        occurrence(out, i.iterator)
+        out.u32(string("STRING.String"))
+        occurrence(out, i.binding)
+        out.u32(next)
+    }
+
+    val idx = nodeOffsets.size
+    nodeOffsets.add(nodeData.size)
+    out.writeTo(nodeData.bytes)
+    nodeIndices.put(dt, idx)
+    idx
+  }
+}
+
+object DecisionTreeFile {
+  val magic: Array[Byte] = Array(0x7f.toByte, 'K'.toByte, 'D'.toByte, 'T'.toByte)
+  val version            = 1
+  val none               = -1
+
+  val failNode         = 0
+  val leafNode         = 1
+  val searchLeafNode   = 2
+  val switchNode       = 3
+  val switchLitNode    = 4
+  val checkNullNode    = 5
+  val functionNode     = 6
+  val makePatternNode  = 7
+  val makeIteratorNode = 8
+  val iterNextNode     = 9
+
+  val variablePattern         = 0
+  val residualVariablePattern = 1
+  val literalPattern          = 2
+  val symbolPattern           = 3
+
+  class Buffer {
+    val bytes = new ByteArrayOutputStream()
+
+    def size: Int = bytes.size
+
+    def u8(v: Int): Unit = bytes.write(v)
+
+    def u32(v: Int): Unit = {
+      bytes.write(v & 0xff)
+      bytes.write((v >>> 8) & 0xff)
+      bytes.write((v >>> 16) & 0xff)
+      bytes.write((v >>> 24) & 0xff)
+    }
+
+    def writeTo(out: OutputStream): Unit = bytes.writeTo(out)
+  }
+}
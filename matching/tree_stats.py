@@ -1,76 +1,185 @@
 #!/usr/bin/python3
 
-import yaml
+# Prints statistics about a decision tree in the decision_trees.bin file
+# written by the matching compiler. The layout of the file is described in
+# include/kllvm/codegen/DecisionParser.h.
+#
+# Usage: tree_stats.py decision_trees.bin [tree name (default: dt)]
+
+import struct
 import sys
-from yaml import CLoader as Loader
 from decimal import Decimal
 
 blank_result  = {"count": 0, "shared_count": 0, "max_depth": 0, "max_choices": 0, "num_actions": 0, "sum_depth": 0, "sum_choices": 0}
 leaf_result   = {"count": 0, "shared_count": 0, "max_depth": 1, "max_choices": 0, "num_actions": 0, "sum_depth": 0, "sum_choices": 0}
 action_result = {"count": 1, "shared_count": 1, "max_depth": 1, "max_choices": 0, "num_actions": 1, "sum_depth": 1, "sum_choices": 0}
 
-def count_nodes_shared(data):
-    if isinstance(data, dict):
-      if "result" in data:
-        result = dict(data["result"])
-        result["shared_count"] = 0
-        return result
-      if "next" in data:
-        result = dict(count_nodes_shared(data["next"]))
-        result["count"] += 1
-        result["shared_count"] += 1
-        result["max_depth"] += 1
-        result["sum_depth"] += result["num_actions"]
-        if "collection" in data:
-          result["sum_choices"] += result["num_actions"]
-          result["max_choices"] += 1
-        data["result"] = result
-        return result
-      elif "specializations" in data:
-        result = dict(blank_result)
-        for case in data["specializations"]:
-          case_result = count_nodes_shared(case[1])
-          result["count"] += case_result["count"]
-          result["shared_count"] += case_result["shared_count"]
-          result["max_depth"] = max(case_result["max_depth"] + 1, result["max_depth"])
-          result["max_choices"] = max(case_result["max_choices"], result["max_choices"])
-          result["num_actions"] += case_result["num_actions"]
-          result["sum_depth"] += case_result["sum_depth"] + case_result["num_actions"]
-          result["sum_choices"] += case_result["sum_choices"]
-        case_result = count_nodes_shared(data["default"])
-        result["count"] += case_result["count"] + 1
-        result["shared_count"] += case_result["shared_count"] + 1
-        result["max_depth"] = max(case_result["max_depth"] + 1, result["max_depth"])
-        result["max_choices"] = max(case_result["max_choices"], result["max_choices"])
-        result["num_actions"] += case_result["num_actions"]
-        result["sum_depth"] += case_result["sum_depth"] + case_result["num_actions"]
-        result["sum_choices"] += case_result["sum_choices"]
-        data["result"] = result
-        return result
-      elif "action" in data:
-        data["result"] = action_result
-        return action_result
-    elif data == "fail":
-      return leaf_result
-    elif data == None:
-      return blank_result
+FAIL, LEAF, SEARCH_LEAF, SWITCH, SWITCH_LIT, CHECK_NULL, FUNCTION, MAKE_PATTERN, MAKE_ITERATOR, ITER_NEXT = range(10)
+VARIABLE_PATTERN, RESIDUAL_VARIABLE_PATTERN, LITERAL_PATTERN, SYMBOL_PATTERN = range(4)
+NONE = 0xffffffff
+
+class Cursor:
+  def __init__(self, data, offset):
+    self.data = data
+    self.offset = offset
+
+  def u8(self):
+    self.offset += 1
+    return self.data[self.offset - 1]
+
+  def u32(self):
+    self.offset += 4
+    return struct.unpack_from("<I", self.data, self.offset - 4)[0]
+
+  def skip_occurrence(self):
+    length = self.u32()
+    self.offset += 4 * length
+
+  def skip_vars(self):
+    for _ in range(self.u32()):
+      self.skip_occurrence()
+      self.u32()
+
+  def skip_pattern(self):
+    kind = self.u8()
+    if kind == VARIABLE_PATTERN:
+      self.skip_occurrence()
+      self.u32()
+    elif kind == RESIDUAL_VARIABLE_PATTERN or kind == LITERAL_PATTERN:
+      self.offset += 8
+    elif kind == SYMBOL_PATTERN:
+      self.u32()
+      for _ in range(self.u32()):
+        self.skip_pattern()
     else:
-      print(type(data))
-      raise AssertionError
-
-with open(sys.argv[1], 'r') as stream:
-  try:
-    doc = yaml.load(stream, Loader=Loader)
-    if (isinstance(doc, list)):
-      result = count_nodes_shared(doc[0])
+      raise AssertionError("bad pattern kind " + str(kind))
+
+class DecisionTreeFile:
+  def __init__(self, filename):
+    with open(filename, 'rb') as f:
+      self.data = f.read()
+    if self.data[:4] != b"\x7fKDT":
+      raise ValueError(filename + " is not a decision tree file")
+    c = Cursor(self.data, 4)
+    version = c.u32()
+    if version != 1:
+      raise ValueError("unsupported decision tree file version " + str(version))
+    num_strings = c.u32()
+    num_nodes = c.u32()
+    num_trees = c.u32()
+
+    self.strings = []
+    for _ in range(num_strings):
+      length = c.u32()
+      self.strings.append(self.data[c.offset:c.offset + length])
+      c.offset += length
+
+    node_data_size = c.u32()
+    self.node_offsets = [c.u32() for _ in range(num_nodes)]
+    self.node_data = c.offset
+    c.offset += node_data_size
+    residual_data_size = c.u32()
+    c.offset += residual_data_size
+
+    self.trees = {}
+    for _ in range(num_trees):
+      name = self.strings[c.u32()].decode()
+      root = c.u32()
+      c.u32()
+      self.trees[name] = root
+
+  # Returns the kind of a node, its children in the order they appear in the
+  # YAML encoding of the tree, and whether it is a switch.
+  def node(self, idx):
+    c = Cursor(self.data, self.node_data + self.node_offsets[idx])
+    kind = c.u8()
+    if kind == FAIL or kind == LEAF:
+      return kind, [], False
+    if kind == SEARCH_LEAF:
+      c.u32()
+      c.skip_vars()
+      return kind, [c.u32()], False
+    if kind in (SWITCH, SWITCH_LIT, CHECK_NULL):
+      c.skip_occurrence()
+      c.u32()
+      if kind == SWITCH_LIT:
+        c.u32()
+      children = []
+      for _ in range(c.u32()):
+        c.u32()
+        children.append(c.u32())
+        num_bindings = c.u32()
+        c.offset += 4 * num_bindings
+      children.append(c.u32())
+      return kind, children, True
+    if kind == FUNCTION:
+      c.offset += 8
+      c.skip_occurrence()
+      c.skip_vars()
+    elif kind == MAKE_PATTERN:
+      c.skip_occurrence()
+      c.u32()
+      c.skip_pattern()
+    elif kind == MAKE_ITERATOR:
+      c.u32()
+      c.skip_occurrence()
+      c.u32()
+    elif kind == ITER_NEXT:
+      c.u32()
+      c.skip_occurrence()
+      c.u32()
+      c.skip_occurrence()
     else:
-      result = count_nodes_shared(doc)
-    
-    print("Size: " + "{:,}".format(result["count"]))
-    print("Shared size: " + "{:,}".format(result["shared_count"]))
-    print("Max path length: " + str(result["max_depth"]))
-    print("Average path length: " + str(Decimal(result["sum_depth"]) / Decimal(result["num_actions"])))
-    print("Average number of choices: " + str(Decimal(result["sum_choices"]) / Decimal(result["num_actions"])))
-    print("Max number of choices: " + str(result["max_choices"]))
-  except yaml.YAMLError as exc:
-    print(exc)
+      raise AssertionError("bad node kind " + str(kind))
+    return kind, [c.u32()], False
+
+def count_nodes_shared(dt, idx, results):
+  if idx == NONE:
+    return blank_result
+  if idx in results:
+    result = dict(results[idx])
+    result["shared_count"] = 0
+    return result
+  kind, children, is_switch = dt.node(idx)
+  if kind == FAIL:
+    return leaf_result
+  if kind == LEAF:
+    results[idx] = action_result
+    return action_result
+  if not is_switch:
+    result = dict(count_nodes_shared(dt, children[0], results))
+    result["count"] += 1
+    result["shared_count"] += 1
+    result["max_depth"] += 1
+    result["sum_depth"] += result["num_actions"]
+    if kind == MAKE_ITERATOR:
+      result["sum_choices"] += result["num_actions"]
+      result["max_choices"] += 1
+    results[idx] = result
+    return result
+  result = dict(blank_result)
+  for child in children:
+    case_result = count_nodes_shared(dt, child, results)
+    result["count"] += case_result["count"]
+    result["shared_count"] += case_result["shared_count"]
+    result["max_depth"] = max(case_result["max_depth"] + 1, result["max_depth"])
+    result["max_choices"] = max(case_result["max_choices"], result["max_choices"])
+    result["num_actions"] += case_result["num_actions"]
+    result["sum_depth"] += case_result["sum_depth"] + case_result["num_actions"]
+    result["sum_choices"] += case_result["sum_choices"]
+  result["count"] += 1
+  result["shared_count"] += 1
+  results[idx] = result
+  return result
+
+dt = DecisionTreeFile(sys.argv[1])
+name = sys.argv[2] if len(sys.argv) > 2 else "dt"
+sys.setrecursionlimit(max(sys.getrecursionlimit(), 100000))
+result = count_nodes_shared(dt, dt.trees[name], {})
+
+print("Size: " + "{:,}".format(result["count"]))
+print("Shared size: " + "{:,}".format(result["shared_count"]))
+print("Max path length: " + str(result["max_depth"]))
+print("Average path length: " + str(Decimal(result["sum_depth"]) / Decimal(result["num_actions"])))
+print("Average number of choices: " + str(Decimal(result["sum_choices"]) / Decimal(result["num_actions"])))
+print("Max number of choices: " + str(result["max_choices"]))
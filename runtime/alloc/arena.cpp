@@ -3,6 +3,8 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
+#include <sys/mman.h>
 
 #include "runtime/alloc.h"
 #include "runtime/arena.h"
@@ -52,7 +54,52 @@ static void *superblock_ptr = nullptr;
 static char **next_superblock_ptr = nullptr;
 static unsigned blocks_left = 0;
 
+// With a contiguous heap, blocks are taken in order from a single region of
+// address space, which is mapped at the first allocation and only backed by
+// memory as it is used. Once the region is full, blocks come from superblocks
+// as usual.
+static char *reserved_start = nullptr;
+static char *reserved_ptr = nullptr;
+static char *reserved_end = nullptr;
+
+static void reserve_heap() {
+  // Map one more block than requested, so that the region can be aligned to
+  // BLOCK_SIZE as MEM_BLOCK_START requires.
+  size_t reserved = contiguous_heap_size & ~(BLOCK_SIZE - 1);
+  size_t size = reserved + BLOCK_SIZE;
+  void *region = mmap(
+      nullptr, size, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (region == MAP_FAILED) {
+    perror("mmap");
+    contiguous_heap_size = 0;
+    return;
+  }
+
+  reserved_start = (char *)(((uintptr_t)region + BLOCK_SIZE - 1)
+                            & ~(BLOCK_SIZE - 1));
+  reserved_ptr = reserved_start;
+  reserved_end = reserved_start + reserved;
+#ifdef MADV_HUGEPAGE
+  // The heap is dense with pointers, so huge pages save many TLB misses.
+  madvise(reserved_start, reserved_end - reserved_start, MADV_HUGEPAGE);
+#endif
+}
+
+// Threads running parallel tasks take blocks from the same superblocks.
+static std::mutex superblock_mutex;
+
 static void *megabyte_malloc() {
+  std::lock_guard<std::mutex> lock(superblock_mutex);
+  if (contiguous_heap_size && !reserved_start) {
+    reserve_heap();
+  }
+  if (reserved_ptr != reserved_end) {
+    void *result = reserved_ptr;
+    reserved_ptr += BLOCK_SIZE;
+    return result;
+  }
+
   if (blocks_left == 0) {
     blocks_left = 15;
     if (int result
@@ -76,7 +123,21 @@ static void *megabyte_malloc() {
   return result;
 }
 
-bool time_for_collection;
+constinit KORE_THREAD_LOCAL bool time_for_collection = false;
+
+// Marks the unused end of the current block, if any, so that the block can be
+// scanned up to its end.
+static void seal_block(struct arena *arena) {
+  if (arena->block != arena->block_end) {
+    if (arena->block_end - arena->block == 8) {
+      // 8 bit sentinel value
+      *(uint64_t *)arena->block = NOT_YOUNG_OBJECT_BIT;
+    } else {
+      // 16-bit or more sentinel value
+      *(uint64_t *)arena->block = arena->block_end - arena->block - 8;
+    }
+  }
+}
 
 static void fresh_block(struct arena *arena) {
   char *next_block = nullptr;
@@ -89,15 +150,7 @@ static void fresh_block(struct arena *arena) {
     arena->num_blocks++;
   } else {
     next_block = *(char **)arena->block_start;
-    if (arena->block != arena->block_end) {
-      if (arena->block_end - arena->block == 8) {
-        *(uint64_t *)arena->block
-            = NOT_YOUNG_OBJECT_BIT; // 8 bit sentinel value
-      } else {
-        *(uint64_t *)arena->block = arena->block_end - arena->block
-                                    - 8; // 16-bit or more sentinel value
-      }
-    }
+    seal_block(arena);
     if (!next_block) {
       MEM_LOG(
           "Allocating new block for the first time in arena %d\n",
@@ -122,7 +175,7 @@ static void fresh_block(struct arena *arena) {
       BLOCK_SIZE - sizeof(memory_block_header));
 }
 
-bool gc_enabled = true;
+constinit KORE_THREAD_LOCAL bool gc_enabled = true;
 
 __attribute__((noinline)) void *
 do_alloc_slow(size_t requested, struct arena *arena) {
@@ -170,6 +223,27 @@ __attribute__((always_inline)) void arena_clear(struct arena *arena) {
       = arena->first_block ? arena->first_block + BLOCK_SIZE : nullptr;
 }
 
+void arena_merge(struct arena *arena, struct arena *other) {
+  if (!other->first_block) {
+    return;
+  }
+
+  // The blocks that the first arena has not used yet stay after those of the
+  // second, to be used once its last block is full.
+  if (arena->block_start) {
+    seal_block(arena);
+    *(char **)other->block_start = *(char **)arena->block_start;
+    *(char **)arena->block_start = other->first_block;
+  } else {
+    arena->first_block = other->first_block;
+  }
+  arena->block = other->block;
+  arena->block_start = other->block_start;
+  arena->block_end = other->block_end;
+  arena->num_blocks += other->num_blocks;
+  arena_reset(other);
+}
+
 __attribute__((always_inline)) char *
 arena_start_ptr(const struct arena *arena) {
   return arena->first_block ? arena->first_block + sizeof(memory_block_header)
@@ -241,4 +315,11 @@ void free_all_memory() {
   superblock_ptr = nullptr;
   next_superblock_ptr = nullptr;
   blocks_left = 0;
+
+  // The reservation is kept, so that the region stays contiguous, but the
+  // memory behind it is returned to the system.
+  if (reserved_start) {
+    madvise(reserved_start, reserved_ptr - reserved_start, MADV_DONTNEED);
+    reserved_ptr = reserved_start;
+  }
 }
@@ -0,0 +1,174 @@
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "runtime/alloc.h"
+#include "runtime/arena.h"
+
+namespace {
+
+struct task {
+  void (*fn)(void *);
+  void *env;
+  task_arenas arenas{};
+  std::exception_ptr error;
+  std::atomic<bool> done = false;
+};
+
+// Each thread pushes the tasks it spawns onto its own queue, and takes tasks
+// back from the same end, so that a thread waiting in kore_join usually finds
+// the task it waits for still queued. Other threads steal from the other end.
+class task_queue {
+public:
+  void push(task *t) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(t);
+  }
+
+  task *pop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tasks_.empty()) {
+      return nullptr;
+    }
+    auto *t = tasks_.back();
+    tasks_.pop_back();
+    return t;
+  }
+
+  task *steal() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tasks_.empty()) {
+      return nullptr;
+    }
+    auto *t = tasks_.front();
+    tasks_.pop_front();
+    return t;
+  }
+
+private:
+  std::mutex mutex_;
+  std::deque<task *> tasks_;
+};
+
+// The queue of the calling thread; threads outside the pool share queue 0.
+thread_local size_t queue_index = 0;
+
+class task_pool {
+public:
+  task_pool()
+      : queues_(num_workers() + 1) {
+    for (auto &queue : queues_) {
+      queue = std::make_unique<task_queue>();
+    }
+    for (size_t i = 1; i < queues_.size(); ++i) {
+      std::thread([this, i] { work(i); }).detach();
+    }
+  }
+
+  // The pool is never destroyed, as its threads outlive main.
+  static task_pool &get() {
+    static auto *pool = new task_pool();
+    return *pool;
+  }
+
+  void spawn(task *t) {
+    queues_[queue_index]->push(t);
+    {
+      std::lock_guard<std::mutex> lock(idle_mutex_);
+      ++queued_;
+    }
+    idle_.notify_one();
+  }
+
+  void join(task *t) {
+    while (!t->done.load(std::memory_order_acquire)) {
+      if (auto *next = take()) {
+        run(next);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+private:
+  static size_t num_workers() {
+    if (char const *threads = getenv("KLLVM_THREADS")) {
+      return strtoul(threads, nullptr, 10);
+    }
+    auto hardware = std::thread::hardware_concurrency();
+    return hardware > 1 ? hardware - 1 : 1;
+  }
+
+  task *take() {
+    auto *t = queues_[queue_index]->pop();
+    for (size_t i = 1; !t && i < queues_.size(); ++i) {
+      t = queues_[(queue_index + i) % queues_.size()]->steal();
+    }
+    if (t) {
+      std::lock_guard<std::mutex> lock(idle_mutex_);
+      --queued_;
+    }
+    return t;
+  }
+
+  // The task allocates into its own arenas, whichever thread runs it, so that
+  // the thread that joins it can take over exactly the memory it allocated.
+  static void run(task *t) {
+    kore_alloc_task_swap(&t->arenas);
+    try {
+      t->fn(t->env);
+    } catch (...) {
+      t->error = std::current_exception();
+    }
+    kore_alloc_task_swap(&t->arenas);
+    t->done.store(true, std::memory_order_release);
+  }
+
+  void work(size_t index) {
+    queue_index = index;
+    while (true) {
+      auto *t = take();
+      if (!t) {
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        idle_.wait(lock, [this] { return queued_ > 0; });
+        continue;
+      }
+      run(t);
+      // No task is running on this thread any more, so none of the
+      // temporaries in its always-gc arena are live.
+      kore_clear();
+    }
+  }
+
+  std::vector<std::unique_ptr<task_queue>> queues_;
+  std::mutex idle_mutex_;
+  std::condition_variable idle_;
+  size_t queued_ = 0;
+};
+
+} // namespace
+
+extern "C" {
+
+void *kore_spawn(void (*fn)(void *), void *env) {
+  auto *t = new task{fn, env};
+  kore_alloc_task_init(&t->arenas);
+  task_pool::get().spawn(t);
+  return t;
+}
+
+void kore_join(void *handle) {
+  auto task_ptr = std::unique_ptr<task>((task *)handle);
+  task_pool::get().join(task_ptr.get());
+  kore_alloc_task_merge(&task_ptr->arenas);
+  if (task_ptr->error) {
+    std::rethrow_exception(task_ptr->error);
+  }
+}
+}
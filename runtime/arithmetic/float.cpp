@@ -1,5 +1,9 @@
 #include <gmp.h>
 #include <mpfr.h>
+
+#include <cfloat>
+#include <cmath>
+#include <limits>
 #include <stdexcept>
 
 #include "runtime/header.h"
@@ -51,9 +55,81 @@ static void mpfr_leave(int t, floating *result) {
   mpfr_set_emax(default_emax);
 }
 
-extern "C" {
+extern "C" floating *move_float(floating *);
+
+/* Floats with the precision and exponent range of IEEE 754 binary64 or binary32
+ * are what almost every semantics uses. For the operations that IEEE 754
+ * requires to be correctly rounded, the hardware computes exactly the value
+ * that MPFR would after mpfr_leave, so these are done natively on such floats
+ * without changing MPFR's exponent range or calling into it beyond converting
+ * the arguments and result, which is exact. */
+template <typename T>
+struct native_format;
+
+template <>
+struct native_format<double> {
+  static constexpr mpfr_prec_t prec = 53;
+  static constexpr uint64_t exp = 11;
+};
+
+template <>
+struct native_format<float> {
+  static constexpr mpfr_prec_t prec = 24;
+  static constexpr uint64_t exp = 8;
+};
+
+// Excess precision in intermediate results, as with x87 arithmetic, would
+// round twice.
+static constexpr bool has_native_arithmetic
+    = std::numeric_limits<double>::is_iec559
+      && std::numeric_limits<float>::is_iec559 && FLT_EVAL_METHOD == 0;
+
+template <typename T>
+static bool is_native(floating const *a) {
+  return has_native_arithmetic && a->exp == native_format<T>::exp
+         && mpfr_get_prec(a->f) == native_format<T>::prec;
+}
+
+template <typename T>
+static T get_native(floating const *a) {
+  return static_cast<T>(mpfr_get_d(a->f, MPFR_RNDN));
+}
 
-floating *move_float(floating *);
+template <typename T>
+static SortFloat move_native(T value) {
+  floating result[1];
+  mpfr_init2(result->f, native_format<T>::prec);
+  result->exp = native_format<T>::exp;
+  mpfr_set_d(result->f, value, MPFR_RNDN);
+  return move_float(result);
+}
+
+/* Apply op natively to a if it is a binary64 or binary32 float, or return
+ * nullptr so that the caller falls back to MPFR. */
+template <typename Op>
+static SortFloat native_unary(SortFloat a, Op op) {
+  if (is_native<double>(a)) {
+    return move_native<double>(op(get_native<double>(a)));
+  }
+  if (is_native<float>(a)) {
+    return move_native<float>(op(get_native<float>(a)));
+  }
+  return nullptr;
+}
+
+template <typename Op>
+static SortFloat native_binary(SortFloat a, SortFloat b, Op op) {
+  if (is_native<double>(a) && is_native<double>(b)) {
+    return move_native<double>(
+        op(get_native<double>(a), get_native<double>(b)));
+  }
+  if (is_native<float>(a) && is_native<float>(b)) {
+    return move_native<float>(op(get_native<float>(a), get_native<float>(b)));
+  }
+  return nullptr;
+}
+
+extern "C" {
 
 void add_hash64(void *, uint64_t);
 void *move_mint(mpz_t, uint64_t) {
@@ -61,6 +137,9 @@ void *move_mint(mpz_t, uint64_t) {
 }
 
 SortFloat hook_FLOAT_ceil(SortFloat a) {
+  if (auto *native = native_unary(a, [](auto x) { return std::ceil(x); })) {
+    return native;
+  }
   floating result[1];
   mpfr_enter(a, result);
   int t = mpfr_ceil(result->f, a->f);
@@ -69,6 +148,9 @@ SortFloat hook_FLOAT_ceil(SortFloat a) {
 }
 
 SortFloat hook_FLOAT_floor(SortFloat a) {
+  if (auto *native = native_unary(a, [](auto x) { return std::floor(x); })) {
+    return native;
+  }
   floating result[1];
   mpfr_enter(a, result);
   int t = mpfr_floor(result->f, a->f);
@@ -77,6 +159,9 @@ SortFloat hook_FLOAT_floor(SortFloat a) {
 }
 
 SortFloat hook_FLOAT_trunc(SortFloat a) {
+  if (auto *native = native_unary(a, [](auto x) { return std::trunc(x); })) {
+    return native;
+  }
   floating result[1];
   mpfr_enter(a, result);
   int t = mpfr_trunc(result->f, a->f);
@@ -352,6 +437,9 @@ bool hook_FLOAT_trueeq(SortFloat a, SortFloat b) {
 }
 
 SortFloat hook_FLOAT_abs(SortFloat a) {
+  if (auto *native = native_unary(a, [](auto x) { return std::fabs(x); })) {
+    return native;
+  }
   floating result[1];
   mpfr_enter(a, result);
   int t = mpfr_abs(result->f, a->f, MPFR_RNDN);
@@ -360,6 +448,9 @@ SortFloat hook_FLOAT_abs(SortFloat a) {
 }
 
 SortFloat hook_FLOAT_neg(SortFloat a) {
+  if (auto *native = native_unary(a, [](auto x) { return -x; })) {
+    return native;
+  }
   floating result[1];
   mpfr_enter(a, result);
   int t = mpfr_neg(result->f, a->f, MPFR_RNDN);
@@ -384,6 +475,10 @@ SortFloat hook_FLOAT_max(SortFloat a, SortFloat b) {
 }
 
 SortFloat hook_FLOAT_add(SortFloat a, SortFloat b) {
+  if (auto *native = native_binary(
+          a, b, [](auto x, auto y) { return x + y; })) {
+    return native;
+  }
   floating result[1];
   mpfr_enter(a, result);
   int t = mpfr_add(result->f, a->f, b->f, MPFR_RNDN);
@@ -392,6 +487,10 @@ SortFloat hook_FLOAT_add(SortFloat a, SortFloat b) {
 }
 
 SortFloat hook_FLOAT_sub(SortFloat a, SortFloat b) {
+  if (auto *native = native_binary(
+          a, b, [](auto x, auto y) { return x - y; })) {
+    return native;
+  }
   floating result[1];
   mpfr_enter(a, result);
   int t = mpfr_sub(result->f, a->f, b->f, MPFR_RNDN);
@@ -400,6 +499,10 @@ SortFloat hook_FLOAT_sub(SortFloat a, SortFloat b) {
 }
 
 SortFloat hook_FLOAT_mul(SortFloat a, SortFloat b) {
+  if (auto *native = native_binary(
+          a, b, [](auto x, auto y) { return x * y; })) {
+    return native;
+  }
   floating result[1];
   mpfr_enter(a, result);
   int t = mpfr_mul(result->f, a->f, b->f, MPFR_RNDN);
@@ -408,6 +511,10 @@ SortFloat hook_FLOAT_mul(SortFloat a, SortFloat b) {
 }
 
 SortFloat hook_FLOAT_div(SortFloat a, SortFloat b) {
+  if (auto *native = native_binary(
+          a, b, [](auto x, auto y) { return x / y; })) {
+    return native;
+  }
   floating result[1];
   mpfr_enter(a, result);
   int t = mpfr_div(result->f, a->f, b->f, MPFR_RNDN);
@@ -416,6 +523,10 @@ SortFloat hook_FLOAT_div(SortFloat a, SortFloat b) {
 }
 
 SortFloat hook_FLOAT_rem(SortFloat a, SortFloat b) {
+  if (auto *native = native_binary(
+          a, b, [](auto x, auto y) { return std::remainder(x, y); })) {
+    return native;
+  }
   floating result[1];
   mpfr_enter(a, result);
   int t = mpfr_remainder(result->f, a->f, b->f, MPFR_RNDN);
@@ -436,6 +547,11 @@ SortFloat hook_FLOAT_root(SortFloat a, SortInt b) {
     KLLVM_HOOK_INVALID_ARGUMENT("Root out of range: {}", int_to_string(b));
   }
   unsigned long root = mpz_get_ui(b);
+  if (root == 2) {
+    if (auto *native = native_unary(a, [](auto x) { return std::sqrt(x); })) {
+      return native;
+    }
+  }
   floating result[1];
   mpfr_enter(a, result);
   int t = mpfr_rootn_ui(result->f, a->f, root, MPFR_RNDN);
@@ -3,6 +3,7 @@
 #include "runtime/arena.h"
 #include "runtime/header.h"
 #include <cassert>
+#include <chrono>
 #include <cstdbool>
 #include <cstdint>
 #include <cstdio>
@@ -26,6 +27,25 @@ static char *last_alloc_ptr;
 
 size_t numBytesLiveAtCollection[1 << AGE_WIDTH];
 
+static uint64_t num_collections = 0;
+static std::chrono::steady_clock::duration collection_time{};
+
+// Written at exit when KLLVM_GC_STATS_FILE is set, for the benchmarks in
+// scripts/benchmark.
+static void write_gc_statistics() {
+  FILE *file = fopen(getenv("KLLVM_GC_STATS_FILE"), "w");
+  if (!file) {
+    perror("Could not open GC statistics file");
+    return;
+  }
+
+  auto seconds = std::chrono::duration<double>(collection_time).count();
+  fprintf(
+      file, "{\"collections\": %llu, \"seconds\": %.9f}\n",
+      (unsigned long long)num_collections, seconds);
+  fclose(file);
+}
+
 bool during_gc() {
   return is_gc;
 }
@@ -274,18 +294,30 @@ static bool should_collect_old_gen() {
 }
 
 void init_static_objects(void) {
+  // The empty collections are shared by every collection, including the ground
+  // terms in the static arena, and so must never move.
+  kore_static_alloc_begin();
   map m = map();
   list l = list();
   set s = set();
+  rangemap r = rangemap();
+  kore_static_alloc_end();
   set_kore_memory_functions_for_gmp();
+
+  static bool gc_statistics = false;
+  if (!gc_statistics && getenv("KLLVM_GC_STATS_FILE")) {
+    gc_statistics = true;
+    atexit(write_gc_statistics);
+  }
 }
 
 void kore_collect(
-    void **roots, uint8_t nroots, layoutitem *type_info, bool force) {
+    void **roots, uint32_t nroots, layoutitem *type_info, bool force) {
   if (!force && !gc_enabled) {
     return;
   }
   is_gc = true;
+  auto start = std::chrono::steady_clock::now();
   time_for_collection = false;
   collect_old = should_collect_old_gen();
   MEM_LOG("Starting garbage collection\n");
@@ -302,7 +334,7 @@ void kore_collect(
   }
 #endif
   char *previous_oldspace_alloc_ptr = *old_alloc_ptr();
-  for (int i = 0; i < nroots; i++) {
+  for (uint32_t i = 0; i < nroots; i++) {
     migrate_root(roots, type_info, i);
   }
   migrate_static_roots();
@@ -350,6 +382,8 @@ void kore_collect(
       stderr);
 #endif
   MEM_LOG("Finishing garbage collection\n");
+  num_collections++;
+  collection_time += std::chrono::steady_clock::now() - start;
   is_gc = false;
 }
 
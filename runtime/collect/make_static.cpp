@@ -0,0 +1,123 @@
+#include "runtime/collect.h"
+#include "runtime/header.h"
+
+#include <vector>
+
+namespace {
+
+// An object is static when it is not in the young generation and has no age,
+// like the constants emitted by the compiler; migrate and INITIALIZE_MIGRATE
+// skip such objects, so they are never copied and never forwarded.
+template <typename T>
+bool mark_static(T *s) {
+  if (!is_heap_block(s)) {
+    return false;
+  }
+  s->h.hdr = (s->h.hdr & ~(AGE_MASK | FWD_PTR_BIT)) | NOT_YOUNG_OBJECT_BIT;
+  return true;
+}
+
+class static_marker {
+public:
+  void push(block *b) {
+    if (!is_leaf_block(b)) {
+      stack_.push_back(b);
+    }
+  }
+
+  void push_collection(void *field, uint16_t cat) {
+    switch (cat) {
+    case MAP_LAYOUT:
+      for (auto const &[key, value] : *(map *)field) {
+        push(key.elem);
+        push(value.elem);
+      }
+      break;
+    case RANGEMAP_LAYOUT:
+      for (auto iter = rng_map::ConstRangeMapIterator(*(rangemap *)field);
+           iter.has_next(); ++iter) {
+        push(iter->first.start().elem);
+        push(iter->first.end().elem);
+        push(iter->second.elem);
+      }
+      break;
+    case LIST_LAYOUT:
+      for (auto const &elem : *(list *)field) {
+        push(elem.elem);
+      }
+      break;
+    case SET_LAYOUT:
+      for (auto const &elem : *(set *)field) {
+        push(elem.elem);
+      }
+      break;
+    default: break;
+    }
+  }
+
+  void run() {
+    while (!stack_.empty()) {
+      block *curr_block = stack_.back();
+      stack_.pop_back();
+      if (!mark_static(curr_block)) {
+        continue;
+      }
+
+      uint16_t layout_int = get_layout(curr_block);
+      if (!layout_int) {
+        continue;
+      }
+
+      layout *layout_data = get_layout_data(layout_int);
+      for (unsigned i = 0; i < layout_data->nargs; i++) {
+        layoutitem *arg_data = layout_data->args + i;
+        void *arg = ((char *)curr_block) + arg_data->offset;
+        switch (arg_data->cat) {
+        case MAP_LAYOUT:
+        case RANGEMAP_LAYOUT:
+        case LIST_LAYOUT:
+        case SET_LAYOUT: push_collection(arg, arg_data->cat); break;
+        case STRINGBUFFER_LAYOUT: mark_static(*(stringbuffer **)arg); break;
+        case SYMBOL_LAYOUT:
+        case VARIABLE_LAYOUT: push(*(block **)arg); break;
+        case INT_LAYOUT:
+          mark_static(STRUCT_BASE(mpz_hdr, i, *(mpz_ptr *)arg));
+          break;
+        case FLOAT_LAYOUT:
+          mark_static(STRUCT_BASE(floating_hdr, f, *(floating **)arg));
+          break;
+        default: break;
+        }
+      }
+    }
+  }
+
+private:
+  std::vector<block *> stack_;
+};
+
+} // namespace
+
+extern "C" {
+
+void make_static(void *term, uint16_t layout) {
+  auto marker = static_marker{};
+  switch (layout) {
+  case MAP_LAYOUT:
+  case RANGEMAP_LAYOUT:
+  case LIST_LAYOUT:
+  case SET_LAYOUT: {
+    // A collection is returned by its hook inside a block allocated by
+    // kore_alloc_collection, as in migrate_root.
+    auto offset = *(uint64_t *)((char *)term - sizeof(uint64_t));
+    mark_static((block *)((char *)term - offset));
+    marker.push_collection(term, layout);
+    break;
+  }
+  case SYMBOL_LAYOUT:
+  case VARIABLE_LAYOUT: marker.push((block *)term); break;
+  default: break;
+  }
+  marker.run();
+}
+}
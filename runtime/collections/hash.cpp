@@ -68,6 +68,11 @@ void hash_exit() {
   hash_depth = hash_depth - 1;
 }
 
+void reset_hash_state() {
+  hash_length = 0;
+  hash_depth = 0;
+}
+
 void k_hash(block *arg, void *h) {
   if (hash_enter()) {
     auto argintptr = (uint64_t)arg;
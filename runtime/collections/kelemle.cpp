@@ -11,6 +11,11 @@ bool hook_STRING_lt(SortString, SortString);
 
 // NOLINTNEXTLINE(*-cognitive-complexity)
 bool hook_KEQUAL_eq(block *arg1, block *arg2) {
+  // Terms are immutable, so a term is equal to itself; this also stops the
+  // comparison at every subterm that the two terms share.
+  if (arg1 == arg2) {
+    return true;
+  }
   auto arg1intptr = (uint64_t)arg1;
   auto arg2intptr = (uint64_t)arg2;
   bool arg1lb = is_leaf_block(arg1);
@@ -1,7 +1,9 @@
+#include <algorithm>
 #include <cstdio>
 
 #include "runtime/header.h"
 
+#include "immer/algorithm.hpp"
 #include "immer/flex_vector_transient.hpp"
 
 extern "C" {
@@ -29,12 +31,14 @@ list hook_LIST_push(SortKItem value, SortList l) {
 }
 
 bool hook_LIST_in(SortKItem value, SortList list) {
-  for (auto iter = list->begin(); iter != list->end(); ++iter) {
-    if (hook_KEQUAL_eq(*iter, value)) {
-      return true;
-    }
-  }
-  return false;
+  // Scanning a leaf at a time avoids the tree walk that the list iterator does
+  // for every element.
+  return !immer::for_each_chunk_p(
+      *list, [value](k_elem const *first, k_elem const *last) {
+        return std::none_of(first, last, [value](k_elem const &elem) {
+          return hook_KEQUAL_eq(elem, value);
+        });
+      });
 }
 
 bool hook_LIST_in_keys(SortInt index, SortList list) {
@@ -88,10 +92,11 @@ list hook_LIST_range_long(SortList list, size_t front, size_t back) {
         front, back);
   }
 
-  auto tmp = list->transient();
-  tmp.drop(front);
-  tmp.take(size - back - front);
-  return tmp.persistent();
+  if (front == 0 && back == 0) {
+    return *list;
+  }
+
+  return list->drop(front).take(size - back - front);
 }
 
 list hook_LIST_range(SortList list, SortInt from_front, SortInt from_back) {
@@ -224,14 +229,35 @@ list hook_LIST_fill(SortList l, SortInt index, SortInt len, SortKItem val) {
 }
 
 bool hook_LIST_eq(SortList l1, SortList l2) {
+  auto const &impl1 = l1->impl();
+  auto const &impl2 = l2->impl();
+  if (impl1.size != impl2.size) {
+    return false;
+  }
+  if (impl1.root == impl2.root && impl1.tail == impl2.tail) {
+    return true;
+  }
+
+  // Compares the trees node by node, skipping the subtrees they share.
   return (*l1) == (*l2);
 }
 
 void list_hash(list *l, void *hasher) {
   if (hash_enter()) {
-    for (auto iter = l->begin(); iter != l->end(); ++iter) {
-      k_hash(*iter, hasher);
-    }
+    immer::for_each_chunk_p(
+        *l, [hasher](k_elem const *first, k_elem const *last) {
+          // k_hash adds nothing once the hash has reached its length limit,
+          // so stop there rather than visiting the rest of the list.
+          bool saturated = !hash_enter();
+          hash_exit();
+          if (saturated) {
+            return false;
+          }
+          for (auto const *iter = first; iter != last; ++iter) {
+            k_hash(*iter, hasher);
+          }
+          return true;
+        });
   }
   hash_exit();
 }
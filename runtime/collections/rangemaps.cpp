@@ -115,7 +115,7 @@ static struct blockheader inj_range2kitem_header() {
 }
 set hook_RANGEMAP_keys(SortRangeMap m) {
   auto tmp = hook_SET_unit();
-  for (auto iter = rng_map::ConstRangeMapIterator<k_elem, k_elem>(*m);
+  for (auto iter = rng_map::ConstRangeMapIterator(*m);
        iter.has_next(); ++iter) {
     auto *ptr = (range *)kore_alloc(sizeof(range));
     ptr->h = range_header();
@@ -132,7 +132,7 @@ set hook_RANGEMAP_keys(SortRangeMap m) {
 
 list hook_RANGEMAP_keys_list(SortRangeMap m) {
   auto tmp = list().transient();
-  for (auto iter = rng_map::ConstRangeMapIterator<k_elem, k_elem>(*m);
+  for (auto iter = rng_map::ConstRangeMapIterator(*m);
        iter.has_next(); ++iter) {
     auto *ptr = (range *)kore_alloc(sizeof(range));
     ptr->h = range_header();
@@ -152,7 +152,7 @@ bool hook_RANGEMAP_in_keys(SortKItem key, SortRangeMap m) {
 
 list hook_RANGEMAP_values(SortRangeMap m) {
   auto tmp = list().transient();
-  for (auto iter = rng_map::ConstRangeMapIterator<k_elem, k_elem>(*m);
+  for (auto iter = rng_map::ConstRangeMapIterator(*m);
        iter.has_next(); ++iter) {
     tmp.push_back(iter->second);
   }
@@ -197,7 +197,7 @@ bool hook_RANGEMAP_inclusion(SortRangeMap m1, SortRangeMap m2) {
 rangemap hook_RANGEMAP_updateAll(SortRangeMap m1, SortRangeMap m2) {
   auto *from = m2;
   auto to = *m1;
-  for (auto iter = rng_map::ConstRangeMapIterator<k_elem, k_elem>(*from);
+  for (auto iter = rng_map::ConstRangeMapIterator(*from);
        iter.has_next(); ++iter) {
     to = to.inserted(iter->first, iter->second);
   }
@@ -215,8 +215,14 @@ rangemap hook_RANGEMAP_removeAll(SortRangeMap map, SortSet set) {
 }
 
 bool hook_RANGEMAP_eq(SortRangeMap m1, SortRangeMap m2) {
-  auto it1 = rng_map::ConstRangeMapIterator<k_elem, k_elem>(*m1);
-  auto it2 = rng_map::ConstRangeMapIterator<k_elem, k_elem>(*m2);
+  if (m1->shares_tree(*m2)) {
+    return true;
+  }
+  if (m1->size() != m2->size()) {
+    return false;
+  }
+  auto it1 = rng_map::ConstRangeMapIterator(*m1);
+  auto it2 = rng_map::ConstRangeMapIterator(*m2);
   for (; it1.has_next() && it2.has_next(); ++it1, ++it2) {
     std::pair<rng_map::Range<k_elem>, k_elem> const &r1 = *it1;
     std::pair<rng_map::Range<k_elem>, k_elem> const &r2 = *it2;
@@ -229,7 +235,7 @@ bool hook_RANGEMAP_eq(SortRangeMap m1, SortRangeMap m2) {
 
 void rangemap_hash(rangemap *m, void *hasher) {
   if (hash_enter()) {
-    for (auto iter = rng_map::ConstRangeMapIterator<k_elem, k_elem>(*m);
+    for (auto iter = rng_map::ConstRangeMapIterator(*m);
          iter.has_next(); ++iter) {
       auto entry = *iter;
       k_hash(entry.first.start(), hasher);
@@ -242,7 +248,7 @@ void rangemap_hash(rangemap *m, void *hasher) {
 
 rangemap rangemap_map(rangemap *map, block *(process)(block *)) {
   auto tmp = *map;
-  for (auto iter = rng_map::ConstRangeMapIterator<k_elem, k_elem>(*map);
+  for (auto iter = rng_map::ConstRangeMapIterator(*map);
        iter.has_next(); ++iter) {
     auto entry = *iter;
     tmp = tmp.inserted(entry.first, process(entry.second));
@@ -265,7 +271,7 @@ void print_range_map(
   sfprintf(file, "\\left-assoc{}(%s(", concat);
 
   bool once = true;
-  for (auto iter = rng_map::ConstRangeMapIterator<k_elem, k_elem>(*map);
+  for (auto iter = rng_map::ConstRangeMapIterator(*map);
        iter.has_next(); ++iter) {
     if (once) {
       once = false;
@@ -1,19 +1,19 @@
 #include "runtime/header.h"
 
+#include "rapidjson/encodedstream.h"
 #include "rapidjson/filereadstream.h"
 #include "rapidjson/filewritestream.h"
+#include "rapidjson/memorystream.h"
 #include "rapidjson/reader.h"
 #include "rapidjson/writer.h"
 
+#include <cstring>
 #include <vector>
 
 using namespace rapidjson;
 
 extern "C" {
 floating *move_float(floating *);
-string *hook_STRING_int2string(mpz_t);
-string *make_string(char const *input, ssize_t len = -1);
-char *get_terminated_string(string *);
 }
 
 std::string float_to_string(floating const *f, char const *suffix);
@@ -191,6 +191,24 @@ struct kore_handler : BaseReaderHandler<UTF8<>, kore_handler> {
   }
 };
 
+// A rapidjson output stream that writes directly into a K string buffer, so
+// that printing does not build the text in a separate buffer first.
+struct kore_buffer_stream {
+  using Ch = char;
+
+  stringbuffer *buffer = hook_BUFFER_empty();
+
+  void Put(Ch c) {
+    if (buffer->strlen < len(buffer->contents)) {
+      buffer->contents->data[buffer->strlen++] = c;
+    } else {
+      hook_BUFFER_concat_raw(buffer, &c, 1);
+    }
+  }
+
+  static void Flush() { }
+};
+
 template <typename Stream>
 struct kore_writer : Writer<Stream> {
   bool raw_number(
@@ -216,8 +234,9 @@ static bool write_json(kore_writer<Stream> &writer, block *data) {
       writer.Bool(inj->data);
     } else if (tag_hdr(data->h.hdr) == tag_hdr(intHdr().hdr)) {
       zinj *inj = (zinj *)data;
-      string *str = hook_STRING_int2string(inj->data);
-      writer.raw_number(str->data, len(str), false);
+      auto digits = std::vector<char>(mpz_sizeinbase(inj->data, 10) + 2);
+      mpz_get_str(digits.data(), 10, inj->data);
+      writer.raw_number(digits.data(), strlen(digits.data()), false);
     } else if (tag_hdr(data->h.hdr) == tag_hdr(floatHdr().hdr)) {
       auto *inj = (floatinj *)data;
       std::string str = float_to_string(inj->data, "");
@@ -236,9 +255,16 @@ static bool write_json(kore_writer<Stream> &writer, block *data) {
       return_value = write_json(writer, (block *)obj->data);
       writer.EndArray();
     } else if (tag_hdr(data->h.hdr) == tag_hdr(listHdr().hdr)) {
-      auto *list = (jsonlist *)data;
-      return_value = write_json(writer, list->hd)
-                     && write_json(writer, (block *)list->tl);
+      // Follow the tail of the list in a loop rather than by recursion, so
+      // that long arrays and objects do not exhaust the stack.
+      block *elems = data;
+      while (return_value && !is_leaf_block(elems)
+             && tag_hdr(elems->h.hdr) == tag_hdr(listHdr().hdr)) {
+        auto *list = (jsonlist *)elems;
+        return_value = write_json(writer, list->hd);
+        elems = (block *)list->tl;
+      }
+      return_value = return_value && write_json(writer, elems);
     } else if (tag_hdr(data->h.hdr) == tag_hdr(membHdr().hdr)) {
       auto *memb = (jsonmember *)data;
       auto *inj = (stringinj *)memb->key;
@@ -254,17 +280,19 @@ static bool write_json(kore_writer<Stream> &writer, block *data) {
 extern "C" {
 
 SortString hook_JSON_json2string(SortJSON json) {
-  StringBuffer buffer;
-  kore_writer<StringBuffer> writer(buffer);
+  kore_buffer_stream stream;
+  kore_writer<kore_buffer_stream> writer(stream);
   if (!write_json(writer, json)) {
     abort();
   }
-  return make_string(buffer.GetString());
+  return hook_BUFFER_toString(stream.buffer);
 }
 
 SortJSON hook_JSON_string2json(SortString str) {
-  char *cstr = get_terminated_string(str);
-  StringStream s(cstr);
+  // The parser reads the string in place; a memory stream ends the input at
+  // the length of the string, so it need not be copied to terminate it.
+  MemoryStream bytes(str->data, len(str));
+  EncodedInputStream<UTF8<>, MemoryStream> s(bytes);
   kore_handler handler;
   Reader reader;
   bool result = reader.Parse<kParseNumbersAsStringsFlag>(s, handler);
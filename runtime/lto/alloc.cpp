@@ -4,6 +4,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <utility>
 
 #include "runtime/alloc.h"
 #include "runtime/arena.h"
@@ -11,9 +12,10 @@
 
 extern "C" {
 
-REGISTER_ARENA(youngspace, YOUNGSPACE_ID);
-REGISTER_ARENA(oldspace, OLDSPACE_ID);
-REGISTER_ARENA(alwaysgcspace, ALWAYSGCSPACE_ID);
+REGISTER_THREAD_LOCAL_ARENA(youngspace, YOUNGSPACE_ID);
+REGISTER_THREAD_LOCAL_ARENA(oldspace, OLDSPACE_ID);
+REGISTER_THREAD_LOCAL_ARENA(alwaysgcspace, ALWAYSGCSPACE_ID);
+REGISTER_THREAD_LOCAL_ARENA(staticspace, STATICSPACE_ID);
 
 char *youngspace_ptr() {
   return arena_start_ptr(&youngspace);
@@ -55,10 +57,42 @@ void kore_alloc_swap(bool swap_old) {
   }
 }
 
+// Swapping the arenas rather than switching on a flag in kore_alloc means that
+// the hooks, which inline kore_alloc, allocate into the static arena without
+// any cost to the common case.
+void kore_static_alloc_begin() {
+  std::swap(youngspace, staticspace);
+}
+
+void kore_static_alloc_end() {
+  std::swap(youngspace, staticspace);
+}
+
 void kore_clear() {
   arena_clear(&alwaysgcspace);
 }
 
+void kore_alloc_task_init(struct task_arenas *task) {
+  task->young = {.allocation_semispace_id = youngspace.allocation_semispace_id};
+  task->old = {.allocation_semispace_id = oldspace.allocation_semispace_id};
+  task->time_for_collection = false;
+}
+
+// As in kore_static_alloc_begin, swapping the arenas leaves kore_alloc as it
+// is. The always-gc arena is not swapped: a task's temporaries stay in that of
+// the thread that runs it.
+void kore_alloc_task_swap(struct task_arenas *task) {
+  std::swap(youngspace, task->young);
+  std::swap(oldspace, task->old);
+  std::swap(time_for_collection, task->time_for_collection);
+}
+
+void kore_alloc_task_merge(struct task_arenas *task) {
+  arena_merge(&youngspace, &task->young);
+  arena_merge(&oldspace, &task->old);
+  time_for_collection = time_for_collection || task->time_for_collection;
+}
+
 void set_kore_memory_functions_for_gmp() {
   mp_set_memory_functions(kore_alloc_mp, kore_realloc_mp, kore_free);
 }
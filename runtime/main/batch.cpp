@@ -0,0 +1,182 @@
+#include <kllvm/binary/deserializer.h>
+#include <kllvm/binary/serializer.h>
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "runtime/header.h"
+
+using namespace kllvm;
+
+extern "C" {
+void init_static_objects(void);
+void init_outputs(char const *output_filename);
+void free_all_kore_mem(void);
+uint64_t get_steps(void);
+void set_steps(uint64_t steps);
+block *take_steps(int64_t depth, block *subject);
+int32_t get_exit_code(block *);
+
+extern FILE *output_file;
+extern bool batch_rewriting;
+}
+
+static bool hasStatistics = false;
+static bool binaryOutput = false;
+static char const *exitCodes = nullptr;
+
+void parse_flags(int argc, char **argv) {
+  for (int i = 4; i < argc; ++i) {
+    if (strcmp(argv[i], "--statistics") == 0) {
+      hasStatistics = true;
+    }
+    if (strcmp(argv[i], "--binary-output") == 0) {
+      binaryOutput = true;
+    }
+    if (strcmp(argv[i], "--exit-codes") == 0) {
+      exitCodes = argv[i + 1];
+      ++i;
+    }
+  }
+}
+
+// Reads the next pattern of a binary KORE stream into buffer, including its
+// header, and returns false at the end of the stream. Every pattern must carry
+// its size so that it can be read without reading past it; this is the case
+// for streams written by serialize_configuration_to_stream and for the output
+// of kore-convert -s.
+static bool read_pattern(FILE *in, std::vector<char> &buffer) {
+  constexpr auto header_size = serializer::magic_header.size()
+                               + (3 * sizeof(int16_t)) + sizeof(uint64_t);
+
+  buffer.resize(header_size);
+  auto read = fread(buffer.data(), 1, header_size, in);
+  if (read == 0 && feof(in)) {
+    return false;
+  }
+
+  if (read != header_size
+      || !std::equal(
+          serializer::magic_header.begin(), serializer::magic_header.end(),
+          buffer.begin())) {
+    throw std::runtime_error("Malformed pattern in binary KORE stream");
+  }
+
+  auto *ptr = buffer.data() + serializer::magic_header.size();
+  auto *end = buffer.data() + header_size;
+  auto version = detail::read_version(ptr, end);
+  auto size = detail::read_pattern_size(ptr, end, version);
+  if (size == 0) {
+    throw std::runtime_error(
+        "Batch input patterns must be binary KORE with size bytes");
+  }
+
+  buffer.resize(header_size + size);
+  if (fread(buffer.data() + header_size, 1, size, in) != size) {
+    throw std::runtime_error("Truncated pattern in binary KORE stream");
+  }
+
+  return true;
+}
+
+// A job that throws may do so part-way through a hook or while building a
+// term, with garbage collection disabled or a hash in progress. Restore the
+// per-run state of the interpreter so that later jobs start from scratch.
+static void reset_run_state() {
+  gc_enabled = true;
+  set_steps(0);
+  reset_hash_state();
+}
+
+// Runs one configuration to completion and returns its exit code. The result
+// is written to the output as soon as it is known, so that a client reading it
+// through a pipe does not wait for the rest of the batch.
+static int32_t run_job(
+    int64_t depth, std::vector<char> &buffer, stream_dictionary &in,
+    stream_dictionary &out) {
+  auto *data = buffer.data();
+  auto *subject = deserialize_configuration_from_stream(
+      &data, buffer.data() + buffer.size(), &in);
+
+  set_steps(0);
+  auto *result = take_steps(depth, subject);
+
+  if (hasStatistics) {
+    print_statistics(output_file, get_steps());
+  }
+
+  if (binaryOutput) {
+    serialize_configuration_to_stream(output_file, result, nullptr, &out);
+  } else {
+    print_configuration(output_file, result);
+    fputc('\n', output_file);
+  }
+
+  return get_exit_code(result);
+}
+
+int main(int argc, char **argv) {
+  char *filename = argv[1];
+  int64_t depth = atol(argv[2]);
+  char *output = argv[3];
+
+  parse_flags(argc, argv);
+
+  init_static_objects();
+  init_outputs(output);
+
+  FILE *in = strcmp(filename, "-") == 0 ? stdin : fopen(filename, "rb");
+  FILE *codes = exitCodes ? fopen(exitCodes, "w") : nullptr;
+  if (!in || !output_file || (exitCodes && !codes)) {
+    std::cerr << "Could not open batch input or output files\n";
+    return 1;
+  }
+
+  batch_rewriting = true;
+  in_place_rewrite = true;
+
+  // Names are shared by all the patterns of a stream, both in the input and in
+  // the binary output, so the dictionaries outlive the jobs.
+  auto input_dictionary = stream_dictionary{};
+  auto output_dictionary = stream_dictionary{};
+  auto buffer = std::vector<char>{};
+  int status = 0;
+
+  try {
+    for (uint64_t job = 0; read_pattern(in, buffer); ++job) {
+      int32_t exit_code = 113;
+      try {
+        exit_code = run_job(depth, buffer, input_dictionary, output_dictionary);
+      } catch (std::exception const &e) {
+        std::cerr << "Job " << job << ": " << e.what() << '\n';
+        status = 1;
+        reset_run_state();
+        // Keep one line of text output per job.
+        if (!binaryOutput) {
+          fputc('\n', output_file);
+        }
+      }
+
+      fflush(output_file);
+      if (codes) {
+        fprintf(codes, "%d\n", exit_code);
+        fflush(codes);
+      }
+
+      free_all_kore_mem();
+    }
+  } catch (std::exception const &e) {
+    std::cerr << e.what() << '\n';
+    status = 1;
+  }
+
+  if (codes) {
+    fclose(codes);
+  }
+  fclose(output_file);
+  return status;
+}
@@ -5,6 +5,7 @@ target triple = "@BACKEND_TARGET_TRIPLE@"
 %block = type { %blockheader, [0 x ptr] } ; 16-bit layout, 8-bit length, 32-bit tag, children
 
 declare ptr @parse_configuration(ptr)
+declare ptr @read_checkpoint(ptr)
 declare i64 @atol(ptr)
 
 declare ptr @take_steps(i64, ptr)
@@ -14,18 +15,27 @@ declare void @init_static_objects()
 
 declare void @init_outputs(ptr)
 
+declare void @init_checkpoint()
+
 declare void @print_proof_hint_header(ptr)
 
 @statistics.flag = private constant [13 x i8] c"--statistics\00"
 @binary_out.flag = private constant [16 x i8] c"--binary-output\00"
 @proof_out.flag = private constant [15 x i8] c"--proof-output\00"
 @proof_chunk.flag = private constant [19 x i8] c"--proof-chunk-size\00"
+@checkpoint.flag = private constant [13 x i8] c"--checkpoint\00"
+@checkpoint_interval.flag = private constant [22 x i8] c"--checkpoint-interval\00"
+@resume.flag = private constant [9 x i8] c"--resume\00"
 
 @proof_writer = external global ptr
 @statistics = external global i1
 @binary_output = external global i1
 @proof_output = external global i1
 @proof_chunk_size = external global i64
+@checkpoint_file = external global ptr
+@checkpoint_interval = external global i64
+@resume_from_checkpoint = external global i1
+@in_place_rewrite = external global i1
 
 declare i32 @strcmp(ptr %a, ptr %b)
 
@@ -74,7 +84,7 @@ proof.set:
 chunk.body:
   %chunk.cmp = call i32 @strcmp(ptr %arg, ptr getelementptr inbounds ([19 x i8], ptr @proof_chunk.flag, i64 0, i64 0))
   %chunk.eq = icmp eq i32 %chunk.cmp, 0
-  br i1 %chunk.eq, label %chunk.set, label %body.tail
+  br i1 %chunk.eq, label %chunk.set, label %checkpoint.body
 
 chunk.set:
   %idx.next = add i32 %idx, 1
@@ -84,8 +94,42 @@ chunk.set:
   store i64 %chunk_size, ptr @proof_chunk_size
   br label %body.tail
 
+checkpoint.body:
+  %checkpoint.cmp = call i32 @strcmp(ptr %arg, ptr getelementptr inbounds ([13 x i8], ptr @checkpoint.flag, i64 0, i64 0))
+  %checkpoint.eq = icmp eq i32 %checkpoint.cmp, 0
+  br i1 %checkpoint.eq, label %checkpoint.set, label %interval.body
+
+checkpoint.set:
+  %idx.checkpoint = add i32 %idx, 1
+  %checkpoint_file_ptr = getelementptr inbounds ptr, ptr %argv, i32 %idx.checkpoint
+  %checkpoint_file = load ptr, ptr %checkpoint_file_ptr
+  store ptr %checkpoint_file, ptr @checkpoint_file
+  br label %body.tail
+
+interval.body:
+  %interval.cmp = call i32 @strcmp(ptr %arg, ptr getelementptr inbounds ([22 x i8], ptr @checkpoint_interval.flag, i64 0, i64 0))
+  %interval.eq = icmp eq i32 %interval.cmp, 0
+  br i1 %interval.eq, label %interval.set, label %resume.body
+
+interval.set:
+  %idx.interval = add i32 %idx, 1
+  %interval_ptr = getelementptr inbounds ptr, ptr %argv, i32 %idx.interval
+  %interval_str = load ptr, ptr %interval_ptr
+  %interval = call i64 @atol(ptr %interval_str)
+  store i64 %interval, ptr @checkpoint_interval
+  br label %body.tail
+
+resume.body:
+  %resume.cmp = call i32 @strcmp(ptr %arg, ptr getelementptr inbounds ([9 x i8], ptr @resume.flag, i64 0, i64 0))
+  %resume.eq = icmp eq i32 %resume.cmp, 0
+  br i1 %resume.eq, label %resume.set, label %body.tail
+
+resume.set:
+  store i1 1, ptr @resume_from_checkpoint
+  br label %body.tail
+
 body.tail:
-  %idx.updated = phi i32 [ %idx, %chunk.body ], [ %idx.next, %chunk.set ]
+  %idx.updated = phi i32 [ %idx, %resume.body ], [ %idx, %resume.set ], [ %idx.next, %chunk.set ], [ %idx.checkpoint, %checkpoint.set ], [ %idx.interval, %interval.set ]
   br label %inc
 
 inc:
@@ -119,7 +163,18 @@ if:
   call void @print_proof_hint_header(ptr %proof_writer)
   br label %else
 else:
-  %ret = call ptr @parse_configuration(ptr %filename)
+  %resume = load i1, ptr @resume_from_checkpoint
+  br i1 %resume, label %restore, label %parse
+restore:
+  %restored = call ptr @read_checkpoint(ptr %filename)
+  br label %run
+parse:
+  %parsed = call ptr @parse_configuration(ptr %filename)
+  br label %run
+run:
+  %ret = phi ptr [ %restored, %restore ], [ %parsed, %parse ]
+  call void @init_checkpoint()
+  store i1 1, ptr @in_place_rewrite
   %result = call ptr @take_steps(i64 %depth, ptr %ret)
   call void @finish_rewriting(ptr %result, i1 0)
   unreachable
@@ -1,6 +1,7 @@
 #include <runtime/header.h>
 
 extern "C" bool enable_mutable_bytes;
+extern "C" bool linear_bytes;
 
 namespace {
 
@@ -19,7 +20,16 @@ extern "C" bool hook_BYTES_mutableBytesEnabled() {
 }
 
 void copy_if_needed(SortBytes &b) {
-  if (!hook_BYTES_mutableBytesEnabled()) {
-    b = copy_bytes(b);
+  if (hook_BYTES_mutableBytesEnabled()) {
+    return;
   }
+
+  // The compiler sets linear_bytes when no rule can duplicate a Bytes value,
+  // so the argument of a hook is its only reference; constants emitted by the
+  // compiler are shared by every use of the rule and are still copied.
+  if (linear_bytes && in_place_rewrite && is_heap_block(b)) {
+    return;
+  }
+
+  b = copy_bytes(b);
 }
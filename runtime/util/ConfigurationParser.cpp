@@ -164,8 +164,9 @@ extern "C" void *construct_initial_configuration(kore_pattern const *initial) {
 
 // NOLINTBEGIN(*-cognitive-complexity)
 template <typename It>
-static void *
-deserialize_initial_configuration(It ptr, It end, binary_version version) {
+static void *deserialize_initial_configuration(
+    It ptr, It end, binary_version version,
+    stream_dictionary *dictionary = nullptr) {
   bool enabled = gc_enabled;
   gc_enabled = false;
   using namespace kllvm::detail;
@@ -229,25 +230,26 @@ deserialize_initial_configuration(It ptr, It end, binary_version version) {
 
     case header_byte<kore_string_pattern>:
       ++ptr;
-      token_stack.push_back(read_string(ptr, end, version));
+      token_stack.push_back(read_string(ptr, end, version, dictionary));
       break;
 
     case header_byte<kore_symbol>: {
       ++ptr;
-      symbol = read_symbol(ptr, end, sort_stack, version);
+      symbol = read_symbol(ptr, end, sort_stack, version, dictionary);
       break;
     }
 
     case header_byte<kore_sort_variable>: {
       ++ptr;
-      sort_stack.push_back(
-          kore_sort_variable::create(read_string(ptr, end, version)));
+      sort_stack.push_back(kore_sort_variable::create(
+          read_string(ptr, end, version, dictionary)));
       break;
     }
 
     case header_byte<kore_composite_sort>: {
       ++ptr;
-      sort_stack.push_back(read_composite_sort(ptr, end, sort_stack, version));
+      sort_stack.push_back(read_composite_sort(
+          ptr, end, sort_stack, version, nullptr, dictionary));
       break;
     }
 
@@ -297,3 +299,25 @@ block *deserialize_configuration(char *data, size_t size) {
   return static_cast<block *>(
       deserialize_initial_configuration(ptr, end, version));
 }
+
+block *deserialize_configuration_from_stream(
+    char **data, char *end, stream_dictionary *dictionary) {
+  auto *ptr = *data;
+
+  for (auto i = 0; i < serializer::magic_header.size(); ++i) {
+    detail::read<char>(ptr, end);
+  }
+
+  auto version = detail::read_version(ptr, end);
+  auto total_size = detail::read_pattern_size(ptr, end, version);
+
+  if (total_size == 0 || std::distance(ptr, end) < total_size) {
+    throw std::runtime_error("Malformed pattern in binary KORE stream");
+  }
+
+  auto *pattern_end = std::next(ptr, total_size);
+  *data = pattern_end;
+
+  return static_cast<block *>(
+      deserialize_initial_configuration(ptr, pattern_end, version, dictionary));
+}
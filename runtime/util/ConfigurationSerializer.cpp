@@ -1,7 +1,6 @@
 #include <kllvm/ast/AST.h>
 #include <kllvm/binary/deserializer.h>
 #include <kllvm/binary/serializer.h>
-#include <kllvm/parser/KOREParser.h>
 
 #include "runtime/header.h"
 #include "runtime/proof_trace_writer.h"
@@ -10,12 +9,14 @@
 
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <limits>
 #include <set>
+#include <string_view>
+#include <unordered_map>
 
 using namespace kllvm;
-using namespace kllvm::parser;
 
 struct string_hash {
   size_t operator()(string *const &k) const {
@@ -33,6 +34,8 @@ struct serialization_state {
   serialization_state() = default;
   serialization_state(serializer::flags flags)
       : instance(flags) { }
+  serialization_state(serializer::flags flags, stream_dictionary *dictionary)
+      : instance(flags, dictionary) { }
 
   // We never want to copy the state; it should only ever get passed around by
   // reference.
@@ -51,8 +54,8 @@ struct serialization_state {
   uint64_t var_counter{0};
 };
 
-static std::string drop_back(std::string const &s, int n) {
-  return s.substr(0, s.size() - n);
+static std::string_view drop_back(char const *s, size_t n) {
+  return {s, strlen(s) - n};
 }
 
 void serialize_configuration_internal(
@@ -69,12 +72,63 @@ static void emit_symbol(
     uint64_t symbol_arity = 0) {
   instance.emit(header_byte<kore_symbol>);
   instance.emit_length(symbol_arity);
-  instance.emit_string(drop_back(name, 2));
+  instance.emit_name(drop_back(name, 2));
 
   instance.emit(header_byte<kore_composite_pattern>);
   instance.emit_length(arity);
 }
 
+static void emit_constant_sort(serializer &instance, std::string_view name);
+
+/**
+ * Emit the symbol with this tag applied to its arguments, which should already
+ * have been emitted, by copying the fragment of binary KORE generated for it at
+ * kompile time. The names of any formal sorts are re-emitted so that they are
+ * interned along with the rest of the configuration. For injections, the sort
+ * being injected into is contextual, and so is taken from the sort argument
+ * rather than the definition.
+ */
+static void
+emit_symbol_fragment(serializer &instance, uint32_t tag, char const *sort) {
+  auto const *fragment = get_binary_fragment_for_tag(tag);
+  auto bytes = std::string_view(fragment->data, fragment->size);
+
+  if (fragment->symbol_begin == 0) {
+    instance.emit_fragment(
+        tag, bytes, fragment->name_begin, fragment->name_end);
+    return;
+  }
+
+  instance.emit_sorts(bytes.substr(0, fragment->symbol_begin));
+
+  if (fragment->is_injection) {
+    assert(sort && "No contextual sort when serializing injection");
+    emit_constant_sort(instance, drop_back(sort, 2));
+  }
+
+  instance.emit_fragment(
+      tag, bytes.substr(fragment->symbol_begin),
+      fragment->name_begin - fragment->symbol_begin,
+      fragment->name_end - fragment->symbol_begin);
+}
+
+/**
+ * The names of collection symbols passed to the visitor callbacks point to
+ * constants generated at kompile time, so their tags can be cached by address
+ * rather than looked up by name every time.
+ */
+static uint32_t get_tag_for_collection_symbol(char const *name) {
+  static thread_local auto cache = std::unordered_map<char const *, uint32_t>{};
+
+  if (auto it = cache.find(name); it != cache.end()) {
+    return it->second;
+  }
+
+  auto tag = get_tag_for_symbol_name(name);
+  cache.emplace(name, tag);
+  return tag;
+}
+
 const uint8_t COMPOSITE = 0x01;
 const uint8_t STRING = 0x00;
 const uint8_t NULL_BYTE = 0x00;
@@ -87,10 +141,10 @@ static void emit_symbol_to_proof_trace(FILE *file, int32_t tag) {
 /**
  * Emit a 0-argument sort of the form Sort{}
  */
-static void emit_constant_sort(serializer &instance, char const *name) {
+static void emit_constant_sort(serializer &instance, std::string_view name) {
   instance.emit(header_byte<kore_composite_sort>);
   instance.emit_length(0);
-  instance.emit_string(name);
+  instance.emit_name(name);
 }
 
 /**
@@ -107,14 +161,14 @@ static void emit_token(
   if (len < 0) {
     instance.emit_string(string);
   } else {
-    instance.emit_string(std::string(string, len));
+    instance.emit_string(std::string_view(string, len));
   }
 
-  emit_constant_sort(instance, drop_back(sort, 2).c_str());
+  emit_constant_sort(instance, drop_back(sort, 2));
 
   instance.emit(header_byte<kore_symbol>);
   instance.emit_length(1);
-  instance.emit_string("\\dv");
+  instance.emit_name("\\dv");
 
   instance.emit(header_byte<kore_composite_pattern>);
   instance.emit_length(1);
@@ -137,11 +191,13 @@ void serialize_map(
 
   size_t size = map->size();
   if (size == 0) {
-    emit_symbol(instance, unit);
+    auto unit_tag = get_tag_for_collection_symbol(unit);
+    emit_symbol_fragment(instance, unit_tag, nullptr);
     return;
   }
 
-  auto tag = get_tag_for_symbol_name(element);
+  auto tag = get_tag_for_collection_symbol(element);
+  auto concat_tag = get_tag_for_collection_symbol(concat);
   auto *arg_sorts = get_argument_sorts_for_tag(tag);
 
   for (auto iter = map->begin(); iter != map->end(); ++iter) {
@@ -149,10 +205,10 @@ void serialize_map(
         file, iter->first, arg_sorts[0], false, state);
     serialize_configuration_internal(
         file, iter->second, arg_sorts[1], false, state);
-    emit_symbol(instance, element, 2);
+    emit_symbol_fragment(instance, tag, nullptr);
 
     if (iter != map->begin()) {
-      emit_symbol(instance, concat, 2);
+      emit_symbol_fragment(instance, concat_tag, nullptr);
     }
   }
 }
@@ -188,29 +244,32 @@ void serialize_range_map(
 
   size_t size = map->size();
   if (size == 0) {
-    emit_symbol(instance, unit);
+    auto unit_tag = get_tag_for_collection_symbol(unit);
+    emit_symbol_fragment(instance, unit_tag, nullptr);
     return;
   }
 
-  auto tag = get_tag_for_symbol_name(element);
+  auto tag = get_tag_for_collection_symbol(element);
+  auto concat_tag = get_tag_for_collection_symbol(concat);
+  auto range_tag = get_tag_for_collection_symbol("LblRangeMap'Coln'Range{}");
   auto *arg_sorts = get_argument_sorts_for_tag(tag);
 
   bool once = true;
-  for (auto iter = rng_map::ConstRangeMapIterator<k_elem, k_elem>(*map);
+  for (auto iter = rng_map::ConstRangeMapIterator(*map);
        iter.has_next(); ++iter) {
     serialize_configuration_internal(
         file, iter->first.start(), "SortKItem{}", false, state);
     serialize_configuration_internal(
         file, iter->first.end(), "SortKItem{}", false, state);
-    emit_symbol(instance, "LblRangeMap'Coln'Range{}", 2);
+    emit_symbol_fragment(instance, range_tag, nullptr);
     serialize_configuration_internal(
         file, iter->second, arg_sorts[1], false, state);
-    emit_symbol(instance, element, 2);
+    emit_symbol_fragment(instance, tag, nullptr);
 
     if (once) {
       once = false;
     } else {
-      emit_symbol(instance, concat, 2);
+      emit_symbol_fragment(instance, concat_tag, nullptr);
     }
   }
 }
@@ -235,7 +294,7 @@ void serialize_range_map_to_proof_trace(
     emit_symbol_to_proof_trace(file, concat);
   }
 
-  for (auto iter = rng_map::ConstRangeMapIterator<k_elem, k_elem>(*map);
+  for (auto iter = rng_map::ConstRangeMapIterator(*map);
        iter.has_next(); ++iter) {
     emit_symbol_to_proof_trace(file, element);
     emit_symbol_to_proof_trace(file, range_tag);
@@ -255,19 +314,21 @@ void serialize_list(
 
   size_t size = list->size();
   if (size == 0) {
-    emit_symbol(instance, unit);
+    auto unit_tag = get_tag_for_collection_symbol(unit);
+    emit_symbol_fragment(instance, unit_tag, nullptr);
     return;
   }
 
-  auto tag = get_tag_for_symbol_name(element);
+  auto tag = get_tag_for_collection_symbol(element);
+  auto concat_tag = get_tag_for_collection_symbol(concat);
   auto *arg_sorts = get_argument_sorts_for_tag(tag);
 
   for (auto iter = list->begin(); iter != list->end(); ++iter) {
     serialize_configuration_internal(file, *iter, arg_sorts[0], false, state);
-    emit_symbol(instance, element, 1);
+    emit_symbol_fragment(instance, tag, nullptr);
 
     if (iter != list->begin()) {
-      emit_symbol(instance, concat, 2);
+      emit_symbol_fragment(instance, concat_tag, nullptr);
     }
   }
 }
@@ -301,19 +362,21 @@ void serialize_set(
 
   size_t size = set->size();
   if (size == 0) {
-    emit_symbol(instance, unit);
+    auto unit_tag = get_tag_for_collection_symbol(unit);
+    emit_symbol_fragment(instance, unit_tag, nullptr);
     return;
   }
 
-  auto tag = get_tag_for_symbol_name(element);
+  auto tag = get_tag_for_collection_symbol(element);
+  auto concat_tag = get_tag_for_collection_symbol(concat);
   auto *arg_sorts = get_argument_sorts_for_tag(tag);
 
   for (auto iter = set->begin(); iter != set->end(); ++iter) {
     serialize_configuration_internal(file, *iter, arg_sorts[0], false, state);
-    emit_symbol(instance, element, 1);
+    emit_symbol_fragment(instance, tag, nullptr);
 
     if (iter != set->begin()) {
-      emit_symbol(instance, concat, 2);
+      emit_symbol_fragment(instance, concat_tag, nullptr);
     }
   }
 }
@@ -410,27 +473,6 @@ void serialize_m_int_to_proof_trace(
 
 void serialize_comma(writer *file, void *state) { }
 
-static std::pair<std::string, std::vector<sptr<kore_sort>>>
-cached_symbol_sort_list(std::string const &symbol) {
-  static auto cache = std::unordered_map<
-      std::string, std::pair<std::string, std::vector<sptr<kore_sort>>>>{};
-
-  if (cache.find(symbol) == cache.end()) {
-    auto [id, sorts] = kore_parser::from_string(symbol)->symbol_sort_list();
-
-    // The parser returns the actual name of the symbol separately to its formal
-    // sort parameters. However, the interface of emitSymbol is compatible with
-    // the values stored in the interpreter's table of symbol names, which
-    // include the fully-instantiated symbol. For constant symbols, we know to
-    // drop the last two characters when emitting them. We therefore tack on an
-    // extra "{}" at the end of what comes back from the parser to keep it
-    // compatible with the same interface.
-    cache[symbol] = {fmt::format("{}{{}}", id), sorts};
-  }
-
-  return cache.at(symbol);
-}
-
 void serialize_configuration_internal(
     writer *file, block *subject, char const *sort, bool is_var,
     void *state_ptr) {
@@ -449,7 +491,7 @@ void serialize_configuration_internal(
       return;
     }
 
-    emit_symbol(state.instance, get_symbol_name_for_tag(tag));
+    emit_symbol_fragment(state.instance, tag, sort);
     return;
   }
 
@@ -499,31 +541,7 @@ void serialize_configuration_internal(
 
   visit_children(subject, file, &callbacks, state_ptr);
 
-  auto const *symbol = get_symbol_name_for_tag(tag);
-
-  if (symbol_is_instantiation(tag)) {
-    auto [name, sorts] = cached_symbol_sort_list(symbol);
-
-    if (name == "inj{}") {
-      // Injections need to be special cased; the sort being injected _into_
-      // will be different at runtime to what's in the definition. We therefore
-      // use the contextual sort from the serialization process instead of the
-      // second formal argument.
-      assert(sorts.size() == 2 && "Malformed injection when serializing");
-
-      sorts[0]->serialize_to(state.instance);
-      emit_constant_sort(state.instance, drop_back(sort, 2).c_str());
-    } else {
-      for (auto const &s : sorts) {
-        s->serialize_to(state.instance);
-      }
-    }
-
-    emit_symbol(
-        state.instance, name.c_str(), get_symbol_arity(tag), sorts.size());
-  } else {
-    emit_symbol(state.instance, symbol, get_symbol_arity(tag));
-  }
+  emit_symbol_fragment(state.instance, tag, sort);
 
   if (is_binder) {
     state.bound_variables.pop_back();
@@ -634,6 +652,19 @@ void serialize_configuration(
   *size_out = size;
 }
 
+void serialize_configuration_to_stream(
+    FILE *file, block *subject, char const *sort,
+    stream_dictionary *dictionary) {
+  auto state = serialization_state(serializer::flags::NONE, dictionary);
+
+  writer w = {nullptr, nullptr};
+  serialize_configuration_internal(&w, subject, sort, false, &state);
+  state.instance.correct_emitted_size();
+
+  auto const &data = state.instance.data();
+  fwrite(data.data(), 1, data.size(), file);
+}
+
 void serialize_configuration_to_proof_trace(
     FILE *file, block *subject, uint32_t sort) {
   fputs("\x7FKR2", file);
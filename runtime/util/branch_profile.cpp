@@ -0,0 +1,62 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/*
+ * An entry in the table of branch counters emitted by llvm-kompile-codegen
+ * --pgo-instrument; see kllvm::branch_profile for the meaning of each key and
+ * the format of the profile file.
+ */
+struct profile_counters {
+  char const *key;
+  uint64_t *counts;
+  uint64_t size;
+};
+
+// Counters are registered from a global constructor in the generated code,
+// which may run before the static initializers in this file.
+static std::vector<std::pair<profile_counters const *, uint64_t>> &
+get_tables() {
+  static std::vector<std::pair<profile_counters const *, uint64_t>> tables;
+  return tables;
+}
+
+static void write_branch_profile() {
+  char const *path = getenv("KLLVM_PROFILE_FILE");
+  if (!path) {
+    path = "default.kprof";
+  }
+
+  // Append rather than overwrite, so that the counts from several runs of the
+  // interpreter are summed when the profile is read.
+  FILE *file = fopen(path, "a");
+  if (!file) {
+    perror("Could not open branch profile");
+    return;
+  }
+
+  for (auto [table, size] : get_tables()) {
+    for (uint64_t i = 0; i < size; ++i) {
+      fprintf(file, "%s\t", table[i].key);
+      for (uint64_t j = 0; j < table[i].size; ++j) {
+        fprintf(
+            file, j == 0 ? "%llu" : " %llu",
+            (unsigned long long)table[i].counts[j]);
+      }
+      fprintf(file, "\n");
+    }
+  }
+
+  fclose(file);
+}
+
+extern "C" {
+void register_branch_profile(profile_counters const *table, uint64_t size) {
+  auto &tables = get_tables();
+  if (tables.empty()) {
+    atexit(write_branch_profile);
+  }
+  tables.emplace_back(table, size);
+}
+}
@@ -0,0 +1,576 @@
+#include "kllvm/binary/deserializer.h"
+#include "runtime/alloc.h"
+
+#include "runtime/header.h"
+
+#include <fmt/format.h>
+
+#include <gmp.h>
+#include <mpfr.h>
+
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A checkpoint is a snapshot of the configuration at the top of k_step, from
+// which the rewrite can be resumed by passing --resume to the interpreter.
+//
+// The configuration is written by a traversal of the live heap from the
+// configuration root, in the same way as the garbage collector evacuates it;
+// each object reachable from the root is written once, after every object it
+// refers to, and references between objects are written as indices into the
+// sequence of objects rather than as addresses. Sharing between subterms is
+// therefore preserved, and the checkpoint can be read back by allocating each
+// object in turn without having to look up symbols or rebuild injections as
+// when parsing KORE. Collections are written as their elements, and rebuilt
+// when the checkpoint is read.
+//
+// Symbol tags and layouts are written as they are in memory, and so a
+// checkpoint can only be resumed by the interpreter that wrote it.
+//
+// A checkpoint file has the layout:
+//
+//   "\x7fKCP" version:u32 steps:u64 objects:u64 object* root:ref
+//
+// where every integer is in native byte order, and a reference (ref) is a u64
+// that is either a constant symbol or variable, with the low bit set, or the
+// index of an object shifted left by one bit. Each object begins with a u8
+// kind, followed by:
+//
+//   symbol:        hdr:u64 body (one field per argument in the layout)
+//   string:        len:u64 bytes
+//   integer:       size:i64 limbs
+//   floating:      exp:u64 prec:i64 kind:i32 exponent:i64 significand
+//   string buffer: len:u64 bytes
+//
+// The body of a symbol is the raw contents of its block, followed by each of
+// its arguments other than booleans and machine integers, which are stored in
+// the raw contents.
+
+// Set by the SIGUSR1 handler, and read and written by generated code with
+// relaxed atomic loads and stores of a single byte.
+static_assert(std::atomic<bool>::is_always_lock_free);
+static_assert(sizeof(std::atomic<bool>) == 1);
+
+extern "C" {
+
+std::atomic<bool> time_for_checkpoint = false;
+uint64_t next_checkpoint = std::numeric_limits<uint64_t>::max();
+
+char const *checkpoint_file = nullptr;
+uint64_t checkpoint_interval = 0;
+bool resume_from_checkpoint = false;
+
+uint64_t get_steps();
+void set_steps(uint64_t);
+floating *move_float(floating *);
+}
+
+namespace {
+
+constexpr char magic[] = "\x7fKCP";
+constexpr uint32_t version = 1;
+
+enum class object_kind : uint8_t {
+  Symbol,
+  String,
+  Integer,
+  Floating,
+  StringBuffer,
+};
+
+struct object {
+  void *ptr;
+  object_kind kind;
+};
+
+size_t field_size(uint16_t cat) {
+  switch (cat) {
+  case MAP_LAYOUT: return sizeof(map);
+  case RANGEMAP_LAYOUT: return sizeof(rangemap);
+  case LIST_LAYOUT: return sizeof(list);
+  case SET_LAYOUT: return sizeof(set);
+  case STRINGBUFFER_LAYOUT:
+  case SYMBOL_LAYOUT:
+  case VARIABLE_LAYOUT:
+  case INT_LAYOUT:
+  case FLOAT_LAYOUT: return sizeof(void *);
+  default: return 0;
+  }
+}
+
+// Call f on every object referred to directly by one argument of a symbol.
+template <typename F>
+void for_each_child(block *subject, layoutitem const &arg, F &&f) {
+  void *field = ((char *)subject) + arg.offset;
+  switch (arg.cat) {
+  case MAP_LAYOUT:
+    for (auto const &[key, value] : *(map *)field) {
+      f(object{key.elem, object_kind::Symbol});
+      f(object{value.elem, object_kind::Symbol});
+    }
+    break;
+  case RANGEMAP_LAYOUT:
+    for (auto iter = rng_map::ConstRangeMapIterator(*(rangemap *)field);
+         iter.has_next(); ++iter) {
+      f(object{iter->first.start().elem, object_kind::Symbol});
+      f(object{iter->first.end().elem, object_kind::Symbol});
+      f(object{iter->second.elem, object_kind::Symbol});
+    }
+    break;
+  case LIST_LAYOUT:
+    for (auto const &elem : *(list *)field) {
+      f(object{elem.elem, object_kind::Symbol});
+    }
+    break;
+  case SET_LAYOUT:
+    for (auto const &elem : *(set *)field) {
+      f(object{elem.elem, object_kind::Symbol});
+    }
+    break;
+  case STRINGBUFFER_LAYOUT:
+    f(object{*(stringbuffer **)field, object_kind::StringBuffer});
+    break;
+  case SYMBOL_LAYOUT:
+  case VARIABLE_LAYOUT: f(object{*(block **)field, object_kind::Symbol}); break;
+  case INT_LAYOUT: f(object{*(mpz_ptr *)field, object_kind::Integer}); break;
+  case FLOAT_LAYOUT:
+    f(object{*(floating **)field, object_kind::Floating});
+    break;
+  default: break;
+  }
+}
+
+class checkpoint_writer {
+public:
+  std::string write(block *root, uint64_t steps) {
+    // Objects are visited with an explicit stack, as the configuration may be
+    // far deeper than the C stack allows (e.g. a long K sequence). An object
+    // is pushed once to visit its children and again, beneath them, to be
+    // written after they have been.
+    auto stack = std::vector<std::pair<object, bool>>{};
+    push(stack, object{root, object_kind::Symbol});
+
+    while (!stack.empty()) {
+      auto [obj, children_done] = stack.back();
+      stack.pop_back();
+
+      if (indices_.count(obj.ptr)) {
+        continue;
+      }
+
+      if (children_done) {
+        emit(obj);
+        continue;
+      }
+
+      stack.emplace_back(obj, true);
+      if (obj.kind == object_kind::Symbol && get_layout((block *)obj.ptr)) {
+        auto *subject = (block *)obj.ptr;
+        auto *layout_data = get_layout_data(get_layout(subject));
+        for (unsigned i = 0; i < layout_data->nargs; ++i) {
+          for_each_child(subject, layout_data->args[i], [&](object child) {
+            push(stack, child);
+          });
+        }
+      }
+    }
+
+    auto header = std::string(magic, sizeof(magic) - 1);
+    append(header, version);
+    append(header, steps);
+    append(header, uint64_t{indices_.size()});
+    header += data_;
+    append(header, ref(root));
+    return header;
+  }
+
+private:
+  void push(std::vector<std::pair<object, bool>> &stack, object obj) {
+    if (!is_leaf_block((block *)obj.ptr) && !indices_.count(obj.ptr)) {
+      stack.emplace_back(obj, false);
+    }
+  }
+
+  template <typename T>
+  static void append(std::string &out, T value) {
+    out.append((char const *)&value, sizeof(T));
+  }
+
+  uint64_t ref(void *ptr) {
+    if (is_leaf_block((block *)ptr)) {
+      return (uintptr_t)ptr;
+    }
+    return indices_.at(ptr) << 1;
+  }
+
+  void emit(object obj) {
+    switch (obj.kind) {
+    case object_kind::Symbol:
+      if (get_layout((block *)obj.ptr)) {
+        emit_symbol((block *)obj.ptr);
+      } else {
+        emit_string((string *)obj.ptr);
+      }
+      break;
+    case object_kind::Integer: emit_integer((mpz_ptr)obj.ptr); break;
+    case object_kind::Floating: emit_floating((floating *)obj.ptr); break;
+    case object_kind::StringBuffer:
+      emit_string_buffer((stringbuffer *)obj.ptr);
+      break;
+    case object_kind::String: abort();
+    }
+
+    auto idx = indices_.size();
+    indices_[obj.ptr] = idx;
+  }
+
+  void emit_symbol(block *subject) {
+    constexpr auto gc_mask = NOT_YOUNG_OBJECT_BIT | AGE_MASK | FWD_PTR_BIT;
+    uint64_t hdr = subject->h.hdr & ~gc_mask;
+    auto *layout_data = get_layout_data(layout_hdr(hdr));
+
+    // Pointers and collections are cleared from the raw contents, so that a
+    // checkpoint does not depend on where the heap happened to be.
+    auto body = std::string(
+        (char const *)subject->children, size_hdr(hdr) - sizeof(blockheader));
+    for (unsigned i = 0; i < layout_data->nargs; ++i) {
+      auto const &arg = layout_data->args[i];
+      std::memset(
+          body.data() + arg.offset - sizeof(blockheader), 0,
+          field_size(arg.cat));
+    }
+
+    append(data_, object_kind::Symbol);
+    append(data_, hdr);
+    data_ += body;
+
+    for (unsigned i = 0; i < layout_data->nargs; ++i) {
+      auto const &arg = layout_data->args[i];
+      void *field = ((char *)subject) + arg.offset;
+      switch (arg.cat) {
+      case MAP_LAYOUT: append(data_, uint64_t{((map *)field)->size()}); break;
+      case RANGEMAP_LAYOUT:
+        append(data_, uint64_t{((rangemap *)field)->size()});
+        break;
+      case LIST_LAYOUT: append(data_, uint64_t{((list *)field)->size()}); break;
+      case SET_LAYOUT: append(data_, uint64_t{((set *)field)->size()}); break;
+      default: break;
+      }
+      for_each_child(
+          subject, arg, [&](object child) { append(data_, ref(child.ptr)); });
+    }
+  }
+
+  void emit_string(string *str) {
+    append(data_, object_kind::String);
+    append(data_, uint64_t{len(str)});
+    data_.append(str->data, len(str));
+  }
+
+  void emit_integer(mpz_ptr i) {
+    append(data_, object_kind::Integer);
+    append(data_, int64_t{i->_mp_size});
+    data_.append(
+        (char const *)mpz_limbs_read(i), mpz_size(i) * sizeof(mp_limb_t));
+  }
+
+  void emit_floating(floating *f) {
+    auto kind = mpfr_custom_get_kind(f->f);
+    auto regular = kind == MPFR_REGULAR_KIND || kind == -MPFR_REGULAR_KIND;
+    auto prec = mpfr_get_prec(f->f);
+
+    append(data_, object_kind::Floating);
+    append(data_, f->exp);
+    append(data_, int64_t{prec});
+    append(data_, int32_t{kind});
+    append(data_, int64_t{regular ? mpfr_custom_get_exp(f->f) : 0});
+    data_.append(
+        (char const *)mpfr_custom_get_significand(f->f),
+        mpfr_custom_get_size(prec));
+  }
+
+  void emit_string_buffer(stringbuffer *buffer) {
+    append(data_, object_kind::StringBuffer);
+    append(data_, buffer->strlen);
+    data_.append(buffer->contents->data, buffer->strlen);
+  }
+
+  std::unordered_map<void *, uint64_t> indices_;
+  std::string data_;
+};
+
+class checkpoint_reader {
+public:
+  checkpoint_reader(char const *filename, char const *ptr, char const *end)
+      : filename_(filename)
+      , ptr_(ptr)
+      , end_(end) { }
+
+  block *read() {
+    if (std::string(bytes(sizeof(magic) - 1), sizeof(magic) - 1) != magic) {
+      error("not a checkpoint");
+    }
+
+    if (auto v = read<uint32_t>(); v != version) {
+      error(fmt::format("unsupported version {}", v));
+    }
+
+    set_steps(read<uint64_t>());
+
+    auto count = read<uint64_t>();
+    objects_.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+      objects_.push_back(read_object());
+    }
+
+    auto *root = (block *)deref();
+    if (ptr_ != end_) {
+      error("trailing data");
+    }
+    return root;
+  }
+
+private:
+  [[noreturn]] void error(std::string const &message) const {
+    throw std::runtime_error(
+        fmt::format("Invalid checkpoint {}: {}", filename_, message));
+  }
+
+  char const *bytes(size_t n) {
+    if ((size_t)(end_ - ptr_) < n) {
+      error("unexpected end of file");
+    }
+    auto const *result = ptr_;
+    ptr_ += n;
+    return result;
+  }
+
+  template <typename T>
+  T read() {
+    T value;
+    std::memcpy(&value, bytes(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  void *deref() {
+    auto ref = read<uint64_t>();
+    if (is_leaf_block((block *)ref)) {
+      return (void *)ref;
+    }
+    if ((ref >> 1) >= objects_.size()) {
+      error(fmt::format("reference to undefined object {}", ref >> 1));
+    }
+    return objects_[ref >> 1];
+  }
+
+  k_elem elem() { return {(block *)deref()}; }
+
+  void *read_object() {
+    switch (auto kind = read<object_kind>()) {
+    case object_kind::Symbol: return read_symbol();
+    case object_kind::String: return read_string();
+    case object_kind::Integer: return read_integer();
+    case object_kind::Floating: return read_floating();
+    case object_kind::StringBuffer: return read_string_buffer();
+    default: error(fmt::format("unknown object kind {}", (int)kind));
+    }
+  }
+
+  block *read_symbol() {
+    auto hdr = read<uint64_t>();
+    auto size = size_hdr(hdr);
+    if (!layout_hdr(hdr) || size < sizeof(blockheader)) {
+      error("malformed symbol header");
+    }
+
+    auto *subject = (block *)kore_alloc(size);
+    subject->h.hdr = hdr;
+    std::memcpy(
+        subject->children, bytes(size - sizeof(blockheader)),
+        size - sizeof(blockheader));
+
+    auto *layout_data = get_layout_data(layout_hdr(hdr));
+    for (unsigned i = 0; i < layout_data->nargs; ++i) {
+      auto const &arg = layout_data->args[i];
+      void *field = ((char *)subject) + arg.offset;
+      switch (arg.cat) {
+      case MAP_LAYOUT: {
+        auto m = map();
+        for (auto n = read<uint64_t>(); n > 0; --n) {
+          auto key = elem();
+          m = m.insert({key, elem()});
+        }
+        new (field) map(std::move(m));
+        break;
+      }
+      case RANGEMAP_LAYOUT: {
+        auto m = rangemap();
+        for (auto n = read<uint64_t>(); n > 0; --n) {
+          auto start = elem();
+          auto end = elem();
+          m = m.inserted(rng_map::Range<k_elem>(start, end), elem());
+        }
+        new (field) rangemap(std::move(m));
+        break;
+      }
+      case LIST_LAYOUT: {
+        auto l = list().transient();
+        for (auto n = read<uint64_t>(); n > 0; --n) {
+          l.push_back(elem());
+        }
+        new (field) list(l.persistent());
+        break;
+      }
+      case SET_LAYOUT: {
+        auto s = set();
+        for (auto n = read<uint64_t>(); n > 0; --n) {
+          s = s.insert(elem());
+        }
+        new (field) set(std::move(s));
+        break;
+      }
+      case STRINGBUFFER_LAYOUT:
+      case SYMBOL_LAYOUT:
+      case VARIABLE_LAYOUT:
+      case INT_LAYOUT:
+      case FLOAT_LAYOUT: *(void **)field = deref(); break;
+      default: break;
+      }
+    }
+
+    return subject;
+  }
+
+  string *read_string() {
+    auto n = read<uint64_t>();
+    auto *str = (string *)kore_alloc_token(sizeof(string) + n);
+    init_with_len(str, n);
+    std::memcpy(str->data, bytes(n), n);
+    return str;
+  }
+
+  mpz_ptr read_integer() {
+    auto size = read<int64_t>();
+    auto n = size < 0 ? -size : size;
+
+    mpz_t result;
+    mpz_init(result);
+    if (n > 0) {
+      std::memcpy(
+          mpz_limbs_write(result, n), bytes(n * sizeof(mp_limb_t)),
+          n * sizeof(mp_limb_t));
+    }
+    mpz_limbs_finish(result, size);
+    return move_int(result);
+  }
+
+  floating *read_floating() {
+    floating result[1];
+    result->exp = read<uint64_t>();
+    auto prec = read<int64_t>();
+    auto kind = read<int32_t>();
+    auto exponent = read<int64_t>();
+    if (prec < MPFR_PREC_MIN || prec > MPFR_PREC_MAX) {
+      error("malformed floating point precision");
+    }
+
+    mpfr_init2(result->f, prec);
+    auto *significand = mpfr_custom_get_significand(result->f);
+    auto size = mpfr_custom_get_size(prec);
+    std::memcpy(significand, bytes(size), size);
+    mpfr_custom_init_set(result->f, kind, exponent, prec, significand);
+    return move_float(result);
+  }
+
+  stringbuffer *read_string_buffer() {
+    auto n = read<uint64_t>();
+    return hook_BUFFER_concat_raw(hook_BUFFER_empty(), bytes(n), n);
+  }
+
+  char const *filename_;
+  char const *ptr_;
+  char const *end_;
+  std::vector<void *> objects_;
+};
+
+void request_checkpoint(int) {
+  time_for_checkpoint.store(true, std::memory_order_relaxed);
+}
+
+} // namespace
+
+extern "C" {
+
+void write_checkpoint(char const *filename, block *subject) {
+  // The step counter has already been incremented for the step about to be
+  // taken from this configuration.
+  auto data = checkpoint_writer().write(subject, get_steps() - 1);
+
+  // Write to a temporary file first, so that a run that is killed while
+  // writing a checkpoint leaves the previous one intact.
+  auto tmp = std::string(filename) + ".tmp";
+  auto *file = fopen(tmp.c_str(), "wb");
+  if (!file) {
+    throw std::runtime_error(
+        fmt::format("Could not open checkpoint file {}", tmp));
+  }
+
+  auto written = fwrite(data.data(), 1, data.size(), file);
+  if (fclose(file) != 0 || written != data.size()) {
+    throw std::runtime_error(
+        fmt::format("Could not write checkpoint file {}", tmp));
+  }
+
+  if (std::rename(tmp.c_str(), filename) != 0) {
+    throw std::runtime_error(
+        fmt::format("Could not write checkpoint file {}", filename));
+  }
+}
+
+block *read_checkpoint(char const *filename) {
+  auto data = kllvm::file_contents(filename);
+
+  bool enabled = gc_enabled;
+  gc_enabled = false;
+  auto *result
+      = checkpoint_reader(filename, data.data(), data.data() + data.size())
+            .read();
+  gc_enabled = enabled;
+
+  return result;
+}
+
+void init_checkpoint() {
+  if (!checkpoint_file) {
+    return;
+  }
+
+  if (checkpoint_interval) {
+    next_checkpoint = get_steps() + checkpoint_interval;
+  }
+
+  std::signal(SIGUSR1, request_checkpoint);
+}
+
+void kore_checkpoint(block *subject) {
+  time_for_checkpoint.store(false, std::memory_order_relaxed);
+  if (!checkpoint_file) {
+    return;
+  }
+
+  write_checkpoint(checkpoint_file, subject);
+
+  if (checkpoint_interval) {
+    next_checkpoint = get_steps() + checkpoint_interval;
+  }
+}
+}
@@ -14,6 +14,8 @@ void *proof_writer = nullptr;
 bool statistics = false;
 bool binary_output = false;
 bool proof_output = false;
+bool in_place_rewrite = false;
+bool batch_rewriting = false;
 size_t proof_chunk_size = 0;
 
 uint64_t get_steps();
@@ -32,6 +34,13 @@ void init_outputs(char const *output_filename) {
 }
 
 [[noreturn]] void finish_rewriting(block *subject, bool error) {
+  // The batch driver reports the error and carries on with its next
+  // configuration, so the output file must stay open.
+  if (error && batch_rewriting) {
+    throw std::runtime_error(
+        "Attempted to evaluate partial function at an undefined input");
+  }
+
   // This function is responsible for closing output_file when rewriting
   // finishes; because it can exit in a few different ways (exceptions,
   // std::exit etc.) it's cleaner to set up a smart pointer to do this safely
@@ -49,6 +49,10 @@ struct kllvm_c_api load_c_api(char const *path) {
   API_FUNCTION(kore_simplify_bool);
   API_FUNCTION(kore_simplify);
   API_FUNCTION(kore_simplify_binary);
+  API_FUNCTION(kore_simplify_batch);
+  API_FUNCTION(kore_simplify_binary_batch);
+  API_FUNCTION(kore_evaluate_function_batch);
+  API_FUNCTION(kore_evaluate_function_binary_batch);
   API_FUNCTION(take_steps);
   API_FUNCTION(kore_sort_dump);
   API_FUNCTION(kore_sort_free);
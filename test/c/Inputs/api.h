@@ -38,6 +38,17 @@ struct kllvm_c_api {
       char **, size_t *);
   void (*kore_simplify_binary)(
       kore_error *, char *, size_t, kore_sort const *, char **, size_t *);
+  void (*kore_simplify_batch)(
+      kore_error *, kore_pattern const *const *, size_t, kore_sort const *,
+      char **, size_t *);
+  void (*kore_simplify_binary_batch)(
+      kore_error *, char *const *, size_t const *, size_t, kore_sort const *,
+      char **, size_t *);
+  void (*kore_evaluate_function_batch)(
+      kore_error *, kore_pattern const *const *, size_t, char **, size_t *);
+  void (*kore_evaluate_function_binary_batch)(
+      kore_error *, char const *, char *const *, size_t const *, size_t,
+      char **, size_t *);
   block *(*take_steps)(int64_t depth, block *term);
   char *(*kore_sort_dump)(kore_sort const *);
   void (*kore_sort_free)(kore_sort const *);
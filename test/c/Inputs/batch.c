@@ -0,0 +1,206 @@
+#include "api.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COUNT 3
+
+static struct kllvm_c_api api;
+
+static kore_pattern *foo(char const *x, char const *y) {
+  kore_sort *sort_int = api.kore_composite_sort_new("SortInt");
+  kore_pattern *call = api.kore_composite_pattern_new("Lblfoo");
+
+  kore_pattern *a = api.kore_pattern_new_token(x, sort_int);
+  api.kore_composite_pattern_add_argument(call, a);
+  api.kore_pattern_free(a);
+
+  kore_pattern *b = api.kore_pattern_new_token(y, sort_int);
+  api.kore_composite_pattern_add_argument(call, b);
+  api.kore_pattern_free(b);
+
+  api.kore_sort_free(sort_int);
+  return call;
+}
+
+static void write_file(
+    char const *prefix, char const *name, char const *data, size_t size) {
+  char path[4096];
+  snprintf(path, sizeof(path), "%s.%s.bin", prefix, name);
+
+  FILE *f = fopen(path, "wb");
+  assert(f && "Could not open output file");
+  fwrite(data, size, 1, f);
+  fclose(f);
+}
+
+static void check_error(kore_error *err, char **data_out) {
+  assert(!api.kore_error_is_success(err));
+  for (size_t i = 0; i < COUNT; ++i) {
+    assert(data_out[i] == NULL);
+  }
+
+  printf("%s\n", api.kore_error_message(err));
+  api.kore_error_free(err);
+}
+
+static void free_outputs(char **data_out) {
+  for (size_t i = 0; i < COUNT; ++i) {
+    free(data_out[i]);
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc <= 2) {
+    return 1;
+  }
+
+  api = load_c_api(argv[1]);
+
+  api.kllvm_init();
+
+  kore_sort *sort_int = api.kore_composite_sort_new("SortInt");
+
+  kore_pattern const *good[COUNT]
+      = {foo("2", "2"), foo("3", "3"), foo("2", "2")};
+  kore_pattern const *bad[COUNT]
+      = {foo("2", "2"), foo("2", "0"), foo("3", "3")};
+
+  char *data_out[COUNT];
+  size_t sizes_out[COUNT];
+
+  /* kore_simplify_batch agrees with kore_simplify on each element. */
+  kore_error *err = api.kore_error_new();
+  api.kore_simplify_batch(err, good, COUNT, sort_int, data_out, sizes_out);
+  assert(api.kore_error_is_success(err));
+  api.kore_error_free(err);
+
+  for (size_t i = 0; i < COUNT; ++i) {
+    char *single;
+    size_t single_size;
+
+    err = api.kore_error_new();
+    api.kore_simplify(err, good[i], sort_int, &single, &single_size);
+    assert(api.kore_error_is_success(err));
+    api.kore_error_free(err);
+
+    assert(single_size == sizes_out[i]);
+    assert(memcmp(single, data_out[i], single_size) == 0);
+    free(single);
+  }
+
+  write_file(argv[2], "simplify", data_out[1], sizes_out[1]);
+  free_outputs(data_out);
+
+  err = api.kore_error_new();
+  api.kore_simplify_batch(err, bad, COUNT, sort_int, data_out, sizes_out);
+  check_error(err, data_out);
+
+  /* kore_simplify_binary_batch agrees with kore_simplify_binary. */
+  char *good_data[COUNT], *bad_data[COUNT];
+  size_t good_sizes[COUNT], bad_sizes[COUNT];
+  for (size_t i = 0; i < COUNT; ++i) {
+    api.kore_pattern_serialize(good[i], &good_data[i], &good_sizes[i]);
+    api.kore_pattern_serialize(bad[i], &bad_data[i], &bad_sizes[i]);
+  }
+
+  err = api.kore_error_new();
+  api.kore_simplify_binary_batch(
+      err, good_data, good_sizes, COUNT, sort_int, data_out, sizes_out);
+  assert(api.kore_error_is_success(err));
+  api.kore_error_free(err);
+
+  for (size_t i = 0; i < COUNT; ++i) {
+    char *single;
+    size_t single_size;
+
+    err = api.kore_error_new();
+    api.kore_simplify_binary(
+        err, good_data[i], good_sizes[i], sort_int, &single, &single_size);
+    assert(api.kore_error_is_success(err));
+    api.kore_error_free(err);
+
+    assert(single_size == sizes_out[i]);
+    assert(memcmp(single, data_out[i], single_size) == 0);
+    free(single);
+  }
+
+  write_file(argv[2], "simplify-binary", data_out[1], sizes_out[1]);
+  free_outputs(data_out);
+
+  err = api.kore_error_new();
+  api.kore_simplify_binary_batch(
+      err, bad_data, bad_sizes, COUNT, sort_int, data_out, sizes_out);
+  check_error(err, data_out);
+
+  /* kore_evaluate_function_batch, including a call that is not a composite
+     pattern. */
+  err = api.kore_error_new();
+  api.kore_evaluate_function_batch(err, good, COUNT, data_out, sizes_out);
+  assert(api.kore_error_is_success(err));
+  api.kore_error_free(err);
+
+  write_file(argv[2], "evaluate", data_out[1], sizes_out[1]);
+  free_outputs(data_out);
+
+  err = api.kore_error_new();
+  api.kore_evaluate_function_batch(err, bad, COUNT, data_out, sizes_out);
+  check_error(err, data_out);
+
+  kore_pattern *token = api.kore_pattern_new_token("1", sort_int);
+  kore_pattern const *not_calls[COUNT] = {good[0], token, good[1]};
+
+  err = api.kore_error_new();
+  api.kore_evaluate_function_batch(err, not_calls, COUNT, data_out, sizes_out);
+  check_error(err, data_out);
+
+  /* kore_evaluate_function_binary_batch, with the arguments of each call laid
+     out one after another. */
+  char const *args[COUNT][2] = {{"2", "2"}, {"3", "3"}, {"2", "2"}};
+  char const *bad_args[COUNT][2] = {{"2", "2"}, {"2", "0"}, {"3", "3"}};
+  char *args_data[2 * COUNT], *bad_args_data[2 * COUNT];
+  size_t args_sizes[2 * COUNT], bad_args_sizes[2 * COUNT];
+
+  for (size_t i = 0; i < 2 * COUNT; ++i) {
+    kore_pattern *arg
+        = api.kore_pattern_new_token(args[i / 2][i % 2], sort_int);
+    api.kore_pattern_serialize(arg, &args_data[i], &args_sizes[i]);
+    api.kore_pattern_free(arg);
+
+    arg = api.kore_pattern_new_token(bad_args[i / 2][i % 2], sort_int);
+    api.kore_pattern_serialize(arg, &bad_args_data[i], &bad_args_sizes[i]);
+    api.kore_pattern_free(arg);
+  }
+
+  err = api.kore_error_new();
+  api.kore_evaluate_function_binary_batch(
+      err, "Lblfoo{}", args_data, args_sizes, COUNT, data_out, sizes_out);
+  assert(api.kore_error_is_success(err));
+  api.kore_error_free(err);
+
+  write_file(argv[2], "evaluate-binary", data_out[1], sizes_out[1]);
+  free_outputs(data_out);
+
+  err = api.kore_error_new();
+  api.kore_evaluate_function_binary_batch(
+      err, "Lblfoo{}", bad_args_data, bad_args_sizes, COUNT, data_out,
+      sizes_out);
+  check_error(err, data_out);
+
+  for (size_t i = 0; i < COUNT; ++i) {
+    free(good_data[i]);
+    free(bad_data[i]);
+    api.kore_pattern_free(good[i]);
+    api.kore_pattern_free(bad[i]);
+  }
+
+  for (size_t i = 0; i < 2 * COUNT; ++i) {
+    free(args_data[i]);
+    free(bad_args_data[i]);
+  }
+
+  api.kore_pattern_free(token);
+  api.kore_sort_free(sort_int);
+}
@@ -34,6 +34,12 @@ INCLUDE_INSTALL_PATH = os.environ.get(
 
 PYTHON_INTERPRETER = os.environ.get('PYTHON_INTERPRETER', 'python3')
 
+# The pattern matching compiler, as run by llvm-kompile-testing; tests that
+# inspect the decision trees it writes run it directly.
+MATCHING_JAR = os.path.join(
+    ROOT_PATH, 'matching', 'target',
+    'llvm-backend-matching-1.0-SNAPSHOT-jar-with-dependencies.jar')
+
 config.name = 'llvm-backend'
 config.test_source_root = os.path.join(ROOT_PATH, "test")
 
@@ -112,7 +118,25 @@ config.substitutions.extend([
             exit 1
         fi
     ''')),
+    ('%in-place-interpreter', one_line('''
+        output=$(%kompile %s main --in-place-rewrite -o %t.interpreter 2>&1)
+        if [[ -n "$output" ]]; then
+            echo "llvm-kompile error or warning: $output"
+            exit 1
+        fi
+    ''')),
+    ('%contiguous-heap-interpreter', one_line('''
+        output=$(%kompile %s main --contiguous-heap 1 -o %t.interpreter 2>&1)
+        if [[ -n "$output" ]]; then
+            echo "llvm-kompile error or warning: $output"
+            exit 1
+        fi
+    ''')),
     ('%search-interpreter', '%kompile %s search -o %t.interpreter'),
+    ('%batch-interpreter', '%kompile %s batch -o %t.batch-interpreter'),
+    ('%matching', 'java -jar ' + MATCHING_JAR),
+    ('%serial-matching', 'java -Dscala.concurrent.context.numThreads=1 -Dscala.concurrent.context.maxThreads=1 -jar ' + MATCHING_JAR),
+    ('%tree-stats', PYTHON_INTERPRETER + ' ' + os.path.join(ROOT_PATH, 'matching', 'tree_stats.py')),
     ('%convert-input', '%kore-convert %test-input -o %t.bin'),
     ('%strip-binary', 'kore-strip'),
     ('%arity', 'kore-arity'),
@@ -143,6 +167,19 @@ config.substitutions.extend([
     ('%check-statistics', one_line('''
         %run-statistics | diff - %test-diff-statistics-out
     ''')),
+    ('%check-batch-grep', one_line('''
+        %kore-convert %test-input -s -o %t.sized.bin
+        cat %t.sized.bin %t.sized.bin %t.sized.bin > %t.stream.bin
+        %t.batch-interpreter %t.stream.bin -1 /dev/stdout --exit-codes %t.codes | grep -c -f %test-grep-out | grep -qx 3
+        cat %t.stream.bin | %t.batch-interpreter - -1 /dev/stdout | grep -c -f %test-grep-out | grep -qx 3
+        test `wc -l < %t.codes` -eq 3
+    ''')),
+    ('%check-checkpoint-grep', one_line('''
+        %run-checkpoint | grep -f %test-grep-out -q
+    ''')),
+    ('%check-checkpoint-diff', one_line('''
+        %run-checkpoint | diff - %test-diff-out
+    ''')),
 
     ('%check-dir-grep', one_line('''
         for out in %test-dir-out/*.out.grep; do
@@ -278,6 +315,7 @@ config.substitutions.extend([
     ('%run-binary', 'rm -f %t.bin && %convert-input && %t.interpreter %t.bin -1 /dev/stdout'),
     ('%run-proof-out', 'rm -f %t.out.bin && %t.interpreter %test-input -1 %t.out.bin --proof-output'),
     ('%run-statistics', '%t.interpreter %test-input -1 /dev/stdout --statistics'),
+    ('%run-checkpoint', 'rm -f %t.ckpt && %t.interpreter %test-input -1 /dev/null --checkpoint %t.ckpt --checkpoint-interval 7 && %t.interpreter %t.ckpt -1 /dev/stdout --resume'),
     ('%run-proof-chunks-out', 'rm -f %t.out.bin.* && %t.interpreter %test-input -1 %t.out.bin --proof-output --proof-chunk-size 100'),
     ('%run', '%t.interpreter %test-input -1 /dev/stdout'),
 
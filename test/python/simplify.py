@@ -33,5 +33,27 @@ class TestSimplify(unittest.TestCase):
     def test_simplify_qux(self):
         self._check_bool_simplification('qux', False)
 
+    def test_simplify_batch(self):
+        patterns = [kllvm.parser.Parser.from_string(f'Lbl{label}{{}}()').pattern() for label in ['foo', 'bar', 'foo']]
+        s = kllvm.ast.CompositeSort('SortInt')
+
+        results = kllvm.runtime.simplify_pattern_batch(patterns, s)
+        self.assertEqual(len(results), len(patterns))
+
+        for pattern, result, value in zip(patterns, results, [328, 562, 328]):
+            single = kllvm.runtime.simplify_pattern(pattern, s)
+            self.assertEqual(str(kllvm.ast.Pattern.deserialize(result)), str(single))
+            self.assertEqual(str(single), f'\dv{{SortInt{{}}}}("{value}")')
+
+    def test_simplify_batch_error(self):
+        patterns = [kllvm.parser.Parser.from_string(f'Lbl{label}{{}}()').pattern() for label in ['foo', 'nosuchsymbol', 'bar']]
+        s = kllvm.ast.CompositeSort('SortInt')
+
+        with self.assertRaises(RuntimeError):
+            kllvm.runtime.simplify_pattern_batch(patterns, s)
+
+        results = kllvm.runtime.simplify_pattern_batch([patterns[0], patterns[2]], s)
+        self.assertEqual(len(results), 2)
+
 if __name__ == "__main__":
     unittest.main()
@@ -40,6 +40,54 @@ class TestEvaluate(unittest.TestCase):
         result_f = kllvm.runtime.evaluate_function(call)
         self.assertEqual(str(result_f), '\dv{SortBool{}}("false")')
 
+    def test_batch(self):
+        calls = [
+            kllvm.parser.Parser.from_string('Lblf{}(Lblfoo{}(\\dv{SortInt{}}("23")),Lblbar{}(\\dv{SortInt{}}("56")))').pattern(),
+            kllvm.ast.CompositePattern('Lblbaz'),
+            kllvm.parser.Parser.from_string('Lblqux{}(\\dv{SortInt{}}("34"))').pattern(),
+            kllvm.parser.Parser.from_string('Lblqux{}(\\dv{SortInt{}}("98"))').pattern(),
+        ]
+
+        results = kllvm.runtime.evaluate_function_batch(calls)
+        self.assertEqual(len(results), len(calls))
+
+        expected = [
+            'Lblfoo{}(\dv{SortInt{}}("79"))',
+            '\dv{SortInt{}}("78")',
+            '\dv{SortBool{}}("true")',
+            '\dv{SortBool{}}("false")',
+        ]
+
+        for result, exp in zip(results, expected):
+            self.assertEqual(str(kllvm.ast.Pattern.deserialize(result)), exp)
+
+        for call, result in zip(calls, results):
+            single = kllvm.runtime.evaluate_function(call)
+            self.assertEqual(str(kllvm.ast.Pattern.deserialize(result)), str(single))
+
+    def test_batch_error(self):
+        calls = [
+            kllvm.ast.CompositePattern('Lblbaz'),
+            kllvm.ast.CompositePattern('Lblnosuchfunction'),
+            kllvm.parser.Parser.from_string('Lblqux{}(\\dv{SortInt{}}("34"))').pattern(),
+        ]
+
+        with self.assertRaises(RuntimeError):
+            kllvm.runtime.evaluate_function_batch(calls)
+
+        results = kllvm.runtime.evaluate_function_batch([calls[0], calls[2]])
+        self.assertEqual(str(kllvm.ast.Pattern.deserialize(results[0])), '\dv{SortInt{}}("78")')
+        self.assertEqual(str(kllvm.ast.Pattern.deserialize(results[1])), '\dv{SortBool{}}("true")')
+
+    def test_batch_repeated_symbols(self):
+        calls = [kllvm.parser.Parser.from_string(f'Lblqux{{}}(\\dv{{SortInt{{}}}}("{n}"))').pattern() for n in [34, 98, 34, 98]]
+
+        results = kllvm.runtime.evaluate_function_batch(calls)
+
+        expected = ['true', 'false', 'true', 'false']
+        for result, exp in zip(results, expected):
+            self.assertEqual(str(kllvm.ast.Pattern.deserialize(result)), f'\\dv{{SortBool{{}}}}("{exp}")')
+
 
 if __name__ == "__main__":
     unittest.main()
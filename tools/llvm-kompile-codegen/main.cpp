@@ -1,11 +1,15 @@
 #include <kllvm/ast/AST.h>
+#include <kllvm/ast/definition_index.h>
 #include <kllvm/codegen/ApplyPasses.h>
+#include <kllvm/codegen/BranchProfile.h>
 #include <kllvm/codegen/CreateTerm.h>
 #include <kllvm/codegen/Debug.h>
 #include <kllvm/codegen/Decision.h>
 #include <kllvm/codegen/DecisionParser.h>
 #include <kllvm/codegen/EmitConfigParser.h>
+#include <kllvm/codegen/InPlace.h>
 #include <kllvm/codegen/Metadata.h>
+#include <kllvm/codegen/ObjectCache.h>
 #include <kllvm/codegen/Options.h>
 #include <kllvm/parser/KOREParser.h>
 #include <kllvm/parser/location.h>
@@ -30,6 +34,7 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -46,10 +51,6 @@ cl::opt<std::string> definition_path(
     cl::Positional, cl::desc("<definition.kore>"), cl::Required,
     cl::cat(codegen_tool_cat));
 
-cl::opt<std::string> decision_tree(
-    cl::Positional, cl::desc("<dt.yaml>"), cl::Required,
-    cl::cat(codegen_tool_cat));
-
 cl::opt<std::string> directory(
     cl::Positional, cl::desc("<dir>"), cl::Required, cl::cat(codegen_tool_cat));
 
@@ -78,12 +79,59 @@ cl::opt<bool> safe_partial(
              "exception."),
     cl::init(false), cl::cat(codegen_tool_cat));
 
+cl::opt<bool> use_ast_arena(
+    "ast-arena",
+    cl::desc("Allocate the parsed definition in a single arena, with "
+             "hash-consed sorts, rather than as individual heap objects"),
+    cl::init(false), cl::cat(codegen_tool_cat));
+
+cl::opt<std::string> definition_index_path(
+    "definition-index",
+    cl::desc("Write an index of rule labels and symbol tags for the "
+             "definition to this path"),
+    cl::cat(codegen_tool_cat));
+
 cl::opt<bool> profile_matching(
     "profile-matching",
     cl::desc("Instrument k_step functions with code to profile time spent "
              "matching when applying each rule."),
     cl::init(false), cl::cat(codegen_tool_cat));
 
+cl::opt<bool> in_place_rewrite(
+    "in-place-rewrite",
+    cl::desc("Update blocks of the configuration in place when applying a "
+             "rule, where they are known not to be shared, rather than "
+             "allocating a copy of every block on the path to a rewritten "
+             "cell"),
+    cl::init(false), cl::cat(codegen_tool_cat));
+
+cl::opt<unsigned> contiguous_heap_size(
+    "contiguous-heap",
+    cl::desc("Reserve a single contiguous region of this many GiB of address "
+             "space for the garbage-collected heap, rather than allocating it "
+             "in separate chunks as it grows. This does not compress "
+             "references between terms"),
+    cl::init(0), cl::cat(codegen_tool_cat));
+
+cl::opt<std::string> object_cache_dir(
+    "object-cache",
+    cl::desc("Split the generated code into partitions and reuse the object "
+             "file for each partition that is unchanged since a previous "
+             "build, using this directory as a cache. The output is a list of "
+             "the object files to link, one per line"),
+    cl::cat(codegen_tool_cat));
+
+cl::opt<unsigned> object_cache_partitions(
+    "object-cache-partitions",
+    cl::desc("Number of partitions to split the generated code into when "
+             "using --object-cache"),
+    cl::init(16), cl::cat(codegen_tool_cat));
+
+cl::opt<bool> object_cache_stats(
+    "object-cache-stats",
+    cl::desc("Print the number of object cache hits and misses to stderr"),
+    cl::init(false), cl::cat(codegen_tool_cat));
+
 namespace {
 
 fs::path dt_dir() {
@@ -109,6 +157,70 @@ std::map<std::string, std::string> read_index_file() {
   return index;
 }
 
+/*
+ * Decision trees are read from the single indexed file written by the matching
+ * compiler if it is present, and otherwise from the individual YAML files (and
+ * index.txt) written by older versions of it.
+ */
+class decision_trees {
+public:
+  decision_trees(kore_definition *definition, llvm::Module *mod)
+      : definition_(definition)
+      , mod_(mod) {
+    auto binary_path = dt_dir() / "decision_trees.bin";
+    if (fs::exists(binary_path)) {
+      file_ = std::make_unique<decision_tree_file>(binary_path);
+    } else {
+      index_ = read_index_file();
+    }
+  }
+
+  bool contains(std::string const &name) {
+    return file_ ? file_->contains(name) : fs::exists(yaml_path(name));
+  }
+
+  decision_node *parse(std::string const &name) {
+    if (file_) {
+      return file_->parse(
+          mod_, name, definition_->get_all_symbols(),
+          definition_->get_hooked_sorts());
+    }
+    return parse_yamldecision_tree(
+        mod_, yaml_path(name), definition_->get_all_symbols(),
+        definition_->get_hooked_sorts());
+  }
+
+  partial_step parse_special(std::string const &name) {
+    if (file_) {
+      return file_->parse_special(
+          mod_, name, definition_->get_all_symbols(),
+          definition_->get_hooked_sorts());
+    }
+    return parse_yaml_specialdecision_tree(
+        mod_, yaml_path(name), definition_->get_all_symbols(),
+        definition_->get_hooked_sorts());
+  }
+
+  decision_node *parse_function(kore_symbol_declaration *decl) {
+    if (file_) {
+      return parse(decl->get_symbol()->get_name());
+    }
+    return parse_yamldecision_tree(
+        mod_, get_indexed_filename(index_, decl),
+        definition_->get_all_symbols(), definition_->get_hooked_sorts());
+  }
+
+private:
+  kore_definition *definition_;
+  llvm::Module *mod_;
+  std::unique_ptr<decision_tree_file> file_;
+  std::map<std::string, std::string> index_;
+
+  static fs::path yaml_path(std::string const &name) {
+    return dt_dir() / (name + ".yaml");
+  }
+};
+
 template <typename F>
 void perform_output(F &&action) {
   if (output_file == "-") {
@@ -134,10 +246,13 @@ void initialize_llvm() {
   InitializeAllAsmPrinters();
 }
 
-void emit_metadata(llvm::Module &mod) {
+void emit_metadata(llvm::Module &mod, bool linear_bytes) {
   auto kompiled_dir = fs::absolute(definition_path.getValue()).parent_path();
   add_kompiled_dir_symbol(mod, kompiled_dir, debug);
   add_mutable_bytes_flag(mod, mutable_bytes, debug);
+  add_linear_bytes_flag(mod, linear_bytes, debug);
+  add_contiguous_heap_symbol(
+      mod, uint64_t(contiguous_heap_size.getValue()) << 30, debug);
   add_safe_partial_flag(mod, safe_partial, debug);
   add_proof_hint_instrumentation_slow_flag(
       mod, proof_hint_instrumentation_slow, debug);
@@ -154,10 +269,23 @@ int main(int argc, char **argv) {
 
   validate_codegen_args(output_file == "-");
 
+  if (!object_cache_dir.empty() && !emit_object) {
+    throw std::runtime_error("--object-cache requires --emit-object");
+  }
+
+  if (in_place_rewrite && proof_hint_instrumentation) {
+    throw std::runtime_error(
+        "Cannot specify --in-place-rewrite with --proof-hint-instrumentation");
+  }
+
   kore_parser parser(definition_path.getValue());
-  ptr<kore_definition> definition = parser.definition();
+  ptr<kore_definition> definition = parser.definition(use_ast_arena);
   definition->preprocess();
 
+  if (!definition_index_path.empty()) {
+    definition_index::build(*definition).write(definition_index_path);
+  }
+
   llvm::LLVMContext context;
   std::unique_ptr<llvm::Module> mod = new_module("definition", context);
 
@@ -165,33 +293,38 @@ int main(int argc, char **argv) {
     init_debug_info(mod.get(), definition_path);
   }
 
-  emit_metadata(*mod);
+  auto in_place = std::optional<in_place_analysis>{};
+  if (in_place_rewrite) {
+    in_place.emplace(definition.get());
+  }
+
+  // Bytes hooks update their argument in place rather than copying it when no
+  // rule can give a Bytes value a second reference.
+  emit_metadata(*mod, in_place && in_place->is_linear("SortBytes{}"));
+
+  auto trees = decision_trees(definition.get(), mod.get());
 
   for (auto *axiom : definition->get_axioms()) {
     make_side_condition_function(axiom, definition.get(), mod.get());
     if (!axiom->is_top_axiom()) {
       make_apply_rule_function(axiom, definition.get(), mod.get());
     } else {
-      auto dt_filename
-          = dt_dir() / fmt::format("dt_{}.yaml", axiom->get_ordinal());
-      if (fs::exists(dt_filename) && !proof_hint_instrumentation) {
-        auto residuals = parse_yaml_specialdecision_tree(
-            mod.get(), dt_filename, definition->get_all_symbols(),
-            definition->get_hooked_sorts());
+      auto dt_name = fmt::format("dt_{}", axiom->get_ordinal());
+      if (trees.contains(dt_name) && !proof_hint_instrumentation) {
+        auto residuals = trees.parse_special(dt_name);
         make_apply_rule_function(
             axiom, definition.get(), mod.get(), residuals.residuals);
         make_step_function(
             axiom, definition.get(), mod.get(), residuals, profile_matching);
       } else {
-        make_apply_rule_function(axiom, definition.get(), mod.get(), true);
+        make_apply_rule_function(
+            axiom, definition.get(), mod.get(), true,
+            in_place ? &*in_place : nullptr);
       }
 
-      auto match_filename
-          = dt_dir() / fmt::format("match_{}.yaml", axiom->get_ordinal());
-      if (fs::exists(match_filename)) {
-        auto *dt = parse_yamldecision_tree(
-            mod.get(), match_filename, definition->get_all_symbols(),
-            definition->get_hooked_sorts());
+      auto match_name = fmt::format("match_{}", axiom->get_ordinal());
+      if (trees.contains(match_name)) {
+        auto *dt = trees.parse(match_name);
         make_match_reason_function(definition.get(), mod.get(), axiom, dt);
       }
     }
@@ -199,32 +332,21 @@ int main(int argc, char **argv) {
 
   emit_config_parser_functions(definition.get(), mod.get());
 
-  auto *dt = parse_yamldecision_tree(
-      mod.get(), decision_tree, definition->get_all_symbols(),
-      definition->get_hooked_sorts());
+  auto *dt = trees.parse("dt");
   make_step_function(definition.get(), mod.get(), dt, false, profile_matching);
-  auto *dt_search = parse_yamldecision_tree(
-      mod.get(), dt_dir() / "dt-search.yaml", definition->get_all_symbols(),
-      definition->get_hooked_sorts());
+  auto *dt_search = trees.parse("dt-search");
   make_step_function(definition.get(), mod.get(), dt_search, true, false);
 
-  auto index = read_index_file();
   for (auto const &entry : definition->get_symbols()) {
     auto *symbol = entry.second;
     auto *decl = definition->get_symbol_declarations().at(symbol->get_name());
     if (decl->attributes().contains(attribute_set::key::Function)
         && !decl->is_hooked()) {
-      auto filename = get_indexed_filename(index, decl);
-      auto *func_dt = parse_yamldecision_tree(
-          mod.get(), filename, definition->get_all_symbols(),
-          definition->get_hooked_sorts());
+      auto *func_dt = trees.parse_function(decl);
       make_eval_function(
           decl->get_symbol(), definition.get(), mod.get(), func_dt);
     } else if (decl->is_anywhere()) {
-      auto filename = get_indexed_filename(index, decl);
-      auto *func_dt = parse_yamldecision_tree(
-          mod.get(), filename, definition->get_all_symbols(),
-          definition->get_hooked_sorts());
+      auto *func_dt = trees.parse_function(decl);
 
       make_anywhere_function(
           definition->get_all_symbols().at(ast_to_string(*decl->get_symbol())),
@@ -232,6 +354,10 @@ int main(int argc, char **argv) {
     }
   }
 
+  if (pgo_instrument) {
+    emit_profile_registration(mod.get());
+  }
+
   if (debug) {
     finalize_debug_info();
   }
@@ -242,6 +368,25 @@ int main(int argc, char **argv) {
     apply_kllvm_opt_passes(*mod, hidden_visibility);
   }
 
+  if (!object_cache_dir.empty()) {
+    auto cache = object_cache(object_cache_dir);
+    auto objects = cache.get_objects(std::move(mod), object_cache_partitions);
+
+    if (object_cache_stats) {
+      auto const &stats = cache.get_stats();
+      llvm::errs() << fmt::format(
+          "object cache: {} hits, {} misses\n", stats.hits, stats.misses);
+    }
+
+    perform_output([&](auto &os) {
+      for (auto const &object : objects) {
+        os << object << '\n';
+      }
+    });
+
+    return 0;
+  }
+
   perform_output([&](auto &os) {
     if (emit_object) {
       generate_object_file(*mod, os);
@@ -41,4 +41,35 @@ BOOST_AUTO_TEST_CASE(instantiate) {
   BOOST_CHECK_EQUAL(*sym->get_arguments()[1], *composite);
 }
 
+BOOST_AUTO_TEST_CASE(arena_hash_consing) {
+  auto arena = ast_arena{};
+  auto var = arena.sort_variable("foo");
+  auto composite = arena.composite_sort("bar", {});
+  BOOST_CHECK_EQUAL(arena.sort_variable("foo"), var);
+  BOOST_CHECK_EQUAL(arena.composite_sort("bar", {}), composite);
+
+  auto poly = arena.composite_sort("baz", {composite, var});
+  BOOST_CHECK_EQUAL(
+      arena.composite_sort("baz", {arena.composite_sort("bar", {}), var}),
+      poly);
+  BOOST_CHECK_NE(arena.composite_sort("baz", {var, composite}), poly);
+  BOOST_CHECK_EQUAL(arena.num_sorts(), 4);
+
+  auto expected = kore_composite_sort::create("baz");
+  expected->add_argument(kore_composite_sort::create("bar"));
+  expected->add_argument(kore_sort_variable::create("foo"));
+  BOOST_CHECK_EQUAL(*poly, *expected);
+}
+
+BOOST_AUTO_TEST_CASE(arena_patterns) {
+  auto arena = ast_arena{};
+  auto pat = kore_composite_pattern::create("sym", &arena);
+  pat->add_argument(kore_string_pattern::create("str", &arena));
+  pat->add_argument(kore_variable_pattern::create(
+      "X", arena.composite_sort("SortInt", {}), &arena));
+  BOOST_CHECK_EQUAL(ast_to_string(*pat), "sym{}(\"str\",X : SortInt{})");
+  BOOST_CHECK_EQUAL(pat->shared_from_this(), pat);
+  BOOST_CHECK_EQUAL(arena.intern("str").data(), arena.intern("str").data());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
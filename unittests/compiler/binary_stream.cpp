@@ -0,0 +1,93 @@
+#include <boost/test/unit_test.hpp>
+
+#include <kllvm/binary/deserializer.h>
+#include <kllvm/binary/serializer.h>
+#include <kllvm/parser/KOREParser.h>
+
+#include <string>
+
+using namespace kllvm;
+
+namespace {
+
+sptr<kore_pattern> parse_pattern(std::string const &text) {
+  return parser::kore_parser::from_string(text)->pattern();
+}
+
+std::string
+serialize_to_stream(kore_pattern const &pattern, stream_dictionary &dict) {
+  auto s = serializer(serializer::NONE, &dict);
+  pattern.serialize_to(s);
+  s.correct_emitted_size();
+  return s.byte_string();
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(BinaryStream)
+
+BOOST_AUTO_TEST_CASE(round_trip) {
+  auto first = parse_pattern(
+      R"(Lblfoo{}(Lblbar{}(\dv{SortInt{}}("1")), \dv{SortInt{}}("2")))");
+  auto second
+      = parse_pattern(R"(Lblbar{}(Lblfoo{}(X : SortInt{}, Y : SortInt{})))");
+
+  auto dict = stream_dictionary{};
+  auto stream = serialize_to_stream(*first, dict);
+  auto first_size = stream.size();
+  stream += serialize_to_stream(*second, dict);
+
+  // Every symbol and sort name in the second pattern has already been written
+  // once, so it should be smaller than if it were serialized on its own.
+  auto fresh = stream_dictionary{};
+  BOOST_CHECK_LT(
+      stream.size() - first_size, serialize_to_stream(*second, fresh).size());
+
+  auto patterns = deserialize_pattern_stream(stream.begin(), stream.end());
+  BOOST_REQUIRE_EQUAL(patterns.size(), 2);
+  BOOST_CHECK_EQUAL(ast_to_string(*patterns[0]), ast_to_string(*first));
+  BOOST_CHECK_EQUAL(ast_to_string(*patterns[1]), ast_to_string(*second));
+}
+
+BOOST_AUTO_TEST_CASE(keyed_names) {
+  auto dict = stream_dictionary{};
+
+  auto s = serializer(serializer::DropHeader, &dict);
+  s.emit_keyed_name(12, "Lblfoo");
+  s.emit_name("Lblfoo");
+  s.emit_keyed_name(12, "Lblfoo");
+
+  BOOST_CHECK_EQUAL(dict.size(), 1);
+  BOOST_CHECK_EQUAL(dict.find_key(12).value(), 0);
+  BOOST_CHECK(!dict.find_key(11));
+  BOOST_CHECK_EQUAL(dict.at(0), "Lblfoo");
+}
+
+BOOST_AUTO_TEST_CASE(reference_outside_stream) {
+  auto dict = stream_dictionary{};
+  auto first = parse_pattern("Lblfoo{}()");
+
+  serialize_to_stream(*first, dict);
+  auto second = serialize_to_stream(*first, dict);
+
+  BOOST_CHECK_THROW(
+      deserialize_pattern(second.begin(), second.end()), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(plain_patterns_unchanged) {
+  auto pattern = parse_pattern(R"(Lblfoo{}(\dv{SortInt{}}("1")))");
+
+  auto s = serializer();
+  pattern->serialize_to(s);
+
+  auto data = s.byte_string();
+  auto version = std::string(
+      data.begin() + serializer::magic_header.size(),
+      data.begin() + serializer::magic_header.size() + 6);
+  BOOST_CHECK_EQUAL(version, std::string("\x01\x00\x02\x00\x00\x00", 6));
+
+  auto result = deserialize_pattern(data.begin(), data.end());
+  BOOST_CHECK_EQUAL(ast_to_string(*result), ast_to_string(*pattern));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
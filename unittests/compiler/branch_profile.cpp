@@ -0,0 +1,262 @@
+#include <boost/test/unit_test.hpp>
+
+#include <kllvm/codegen/BranchProfile.h>
+#include <kllvm/codegen/CreateTerm.h>
+#include <kllvm/codegen/Decision.h>
+#include <kllvm/codegen/Options.h>
+#include <kllvm/parser/KOREParser.h>
+
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace kllvm;
+
+namespace {
+
+std::string write_profile(std::string const &contents) {
+  auto path = std::string(std::tmpnam(nullptr));
+  std::ofstream(path) << contents;
+  return path;
+}
+
+/*
+ * f(B1, B2) has one rule for each combination of its arguments, which its
+ * decision tree tells apart with a switch on B1 and a switch on B2 under
+ * each case of it.
+ */
+ptr<kore_definition> parse_nested_definition() {
+  auto parser = parser::kore_parser::from_string(R"(
+    []
+    module TEST
+      sort SortK{} []
+      sort SortKItem{} []
+      hooked-sort SortBool{} [hook{}("BOOL.Bool")]
+      symbol Lblf{}(SortBool{}, SortBool{}) : SortBool{}
+        [function{}(), total{}()]
+      axiom{R} \equals{SortBool{}, R}(
+        Lblf{}(\dv{SortBool{}}("true"), \dv{SortBool{}}("true")),
+        \dv{SortBool{}}("true")) []
+      axiom{R} \equals{SortBool{}, R}(
+        Lblf{}(\dv{SortBool{}}("true"), \dv{SortBool{}}("false")),
+        \dv{SortBool{}}("false")) []
+      axiom{R} \equals{SortBool{}, R}(
+        Lblf{}(\dv{SortBool{}}("false"), \dv{SortBool{}}("true")),
+        \dv{SortBool{}}("false")) []
+      axiom{R} \equals{SortBool{}, R}(
+        Lblf{}(\dv{SortBool{}}("false"), \dv{SortBool{}}("false")),
+        \dv{SortBool{}}("true")) []
+    endmodule []
+  )");
+
+  auto definition = parser->definition();
+  definition->preprocess();
+  return definition;
+}
+
+decision_node *
+nested_tree(kore_definition *definition, llvm::LLVMContext &ctx) {
+  auto axioms = std::vector<kore_axiom_declaration *>(
+      definition->get_axioms().begin(), definition->get_axioms().end());
+  auto *dv = kore_symbol::create("\\dv").release();
+  auto *bool_ty = llvm::Type::getInt1Ty(ctx);
+  auto leaf = [&](size_t rule) {
+    return leaf_node::create(
+        "apply_rule_" + std::to_string(axioms[rule]->get_ordinal()));
+  };
+
+  auto *outer = switch_node::create("_1", bool_ty, false);
+  for (size_t i = 0; i < 2; ++i) {
+    auto *inner = switch_node::create("_2", bool_ty, false);
+    inner->add_case(decision_case(dv, llvm::APInt(1, 1), leaf(2 * i)));
+    inner->add_case(decision_case(dv, llvm::APInt(1, 0), leaf(2 * i + 1)));
+    outer->add_case(decision_case(dv, llvm::APInt(1, i == 0 ? 1 : 0), inner));
+  }
+  return outer;
+}
+
+llvm::Function *
+compile_nested(kore_definition *definition, llvm::Module *module) {
+  auto *symbol = definition->get_all_symbols().at("Lblf{}");
+  make_eval_function(
+      symbol, definition, module,
+      nested_tree(definition, module->getContext()));
+  return module->getFunction("eval_Lblf{}");
+}
+
+/*
+ * The rule applied by a successor of a switch, and the first counter that the
+ * instrumented code increments on the way there, which is the switch's own.
+ */
+struct successor {
+  std::string rule;
+  std::string counters;
+  uint64_t index = 0;
+};
+
+successor describe(llvm::BasicBlock *block) {
+  auto result = successor{};
+  while (block && result.rule.empty()) {
+    for (auto &inst : *block) {
+      auto *gep = llvm::dyn_cast<llvm::GetElementPtrInst>(&inst);
+      if (gep && result.counters.empty()
+          && llvm::isa<llvm::GlobalVariable>(gep->getPointerOperand())) {
+        result.counters = gep->getPointerOperand()->getName().str();
+        result.index = llvm::cast<llvm::ConstantInt>(gep->getOperand(2))
+                           ->getZExtValue();
+      }
+      if (auto *call = llvm::dyn_cast<llvm::CallInst>(&inst)) {
+        if (auto *callee = call->getCalledFunction();
+            callee && callee->getName().startswith("apply_rule_")) {
+          result.rule = callee->getName().str();
+        }
+      }
+    }
+    block = block->getUniqueSuccessor();
+  }
+  return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(BranchProfile)
+
+BOOST_AUTO_TEST_CASE(load) {
+  auto path = write_profile(
+      "step:switch0\t1 0 4\n"
+      "rule:apply_rule_12\t7\n"
+      "step:switch0\t2 3 0\n");
+  auto profile = branch_profile::load(path);
+  std::remove(path.c_str());
+
+  BOOST_CHECK(!profile.empty());
+
+  auto counts = profile.get_counts("step:switch0", 3);
+  BOOST_REQUIRE(counts);
+  BOOST_CHECK_EQUAL((*counts)[0], 3);
+  BOOST_CHECK_EQUAL((*counts)[1], 3);
+  BOOST_CHECK_EQUAL((*counts)[2], 4);
+
+  BOOST_CHECK_EQUAL(profile.get_counts("rule:apply_rule_12", 1)->at(0), 7);
+
+  // Counters from a different decision tree don't apply.
+  BOOST_CHECK(!profile.get_counts("step:switch0", 2));
+  BOOST_CHECK(!profile.get_counts("step:switch1", 3));
+}
+
+BOOST_AUTO_TEST_CASE(malformed) {
+  auto path = write_profile("step:switch0\t1 2\nstep:switch0\t1\n");
+  BOOST_CHECK_THROW(branch_profile::load(path), std::runtime_error);
+  std::remove(path.c_str());
+
+  BOOST_CHECK_THROW(
+      branch_profile::load("/nonexistent/profile"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(nested_switches) {
+  auto definition = parse_nested_definition();
+  auto ctx = llvm::LLVMContext{};
+
+  // Instrument the function, and find the counter behind each rule.
+  pgo_instrument = true;
+  auto instrumented = new_module("instrumented", ctx);
+  auto *fn = compile_nested(definition.get(), instrumented.get());
+  pgo_instrument = false;
+
+  auto rule_counters = std::map<std::string, successor>{};
+  for (auto &block : *fn) {
+    if (auto info = describe(&block); !info.rule.empty()) {
+      rule_counters[info.rule] = info;
+    }
+  }
+  BOOST_REQUIRE_EQUAL(rule_counters.size(), 4);
+
+  // A profile in which the second case of the outer switch is the hotter one,
+  // so that its cases are reordered, and where each rule has its own count.
+  auto counts = std::map<std::string, std::vector<uint64_t>>{};
+  auto rule_counts = std::map<std::string, uint64_t>{};
+  uint64_t count = 10;
+  for (auto const &[rule, info] : rule_counters) {
+    auto key = info.counters.substr(info.counters.find('.') + 1);
+    counts[key].resize(2);
+    counts[key][info.index] = count;
+    rule_counts[rule] = count;
+    count *= 10;
+  }
+  auto outer_key = switch_profile_key(fn, 0);
+  BOOST_REQUIRE(!counts.contains(outer_key));
+  counts[outer_key] = {1, 1000000};
+
+  auto contents = std::string{};
+  for (auto const &[key, values] : counts) {
+    contents += key + "\t" + std::to_string(values[0]) + " "
+                + std::to_string(values[1]) + "\n";
+  }
+  auto path = write_profile(contents);
+
+  // Each switch in the optimized function must be weighted by its own
+  // counters: every case leading to a rule gets that rule's count.
+  pgo_profile = path;
+  auto optimized = new_module("optimized", ctx);
+  fn = compile_nested(definition.get(), optimized.get());
+  pgo_profile = "";
+  std::remove(path.c_str());
+
+  size_t checked = 0;
+  for (auto &block : *fn) {
+    auto *switch_inst
+        = llvm::dyn_cast_or_null<llvm::SwitchInst>(block.getTerminator());
+    if (!switch_inst) {
+      continue;
+    }
+    auto *weights = switch_inst->getMetadata(llvm::LLVMContext::MD_prof);
+    BOOST_REQUIRE(weights);
+    for (unsigned i = 0; i < switch_inst->getNumSuccessors(); ++i) {
+      auto rule = describe(switch_inst->getSuccessor(i)).rule;
+      if (rule.empty()) {
+        continue;
+      }
+      auto weight = llvm::mdconst::extract<llvm::ConstantInt>(
+                        weights->getOperand(i + 1))
+                        ->getZExtValue();
+      BOOST_CHECK_EQUAL(weight, rule_counts[rule]);
+      ++checked;
+    }
+  }
+  BOOST_CHECK_EQUAL(checked, 4);
+}
+
+BOOST_AUTO_TEST_CASE(atomic_increment) {
+  auto ctx = llvm::LLVMContext{};
+  auto mod = new_module("counters", ctx);
+  auto *fn = llvm::Function::Create(
+      llvm::FunctionType::get(llvm::Type::getVoidTy(ctx), false),
+      llvm::GlobalValue::ExternalLinkage, "f", mod.get());
+  auto *block = llvm::BasicBlock::Create(ctx, "entry", fn);
+
+  auto *counters = get_profile_counters(mod.get(), "f:switch0", 2);
+  emit_profile_increment(counters, 1, block);
+
+  // Counters may be incremented from several threads at once, so each
+  // increment must be a single atomic add rather than a load and a store.
+  auto increments = 0;
+  for (auto &inst : *block) {
+    BOOST_CHECK(!llvm::isa<llvm::LoadInst>(inst));
+    BOOST_CHECK(!llvm::isa<llvm::StoreInst>(inst));
+    if (auto *rmw = llvm::dyn_cast<llvm::AtomicRMWInst>(&inst)) {
+      BOOST_CHECK(rmw->getOperation() == llvm::AtomicRMWInst::Add);
+      BOOST_CHECK(rmw->getOrdering() == llvm::AtomicOrdering::Monotonic);
+      ++increments;
+    }
+  }
+  BOOST_CHECK_EQUAL(increments, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
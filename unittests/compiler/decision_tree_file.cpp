@@ -0,0 +1,184 @@
+#include <boost/test/unit_test.hpp>
+
+#include <kllvm/codegen/Decision.h>
+#include <kllvm/codegen/DecisionParser.h>
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace kllvm;
+
+namespace {
+
+/*
+ * A minimal encoder for the decision tree file format, mirroring
+ * DecisionTreeFile.scala in the matching compiler.
+ */
+class dt_writer {
+public:
+  uint32_t string(std::string const &s) {
+    for (uint32_t i = 0; i < strings_.size(); ++i) {
+      if (strings_[i] == s) {
+        return i;
+      }
+    }
+    strings_.push_back(s);
+    return strings_.size() - 1;
+  }
+
+  uint32_t node(std::string const &data) {
+    offsets_.push_back(nodes_.size());
+    nodes_ += data;
+    return offsets_.size() - 1;
+  }
+
+  void tree(std::string const &name, uint32_t root) {
+    trees_ += u32(string(name)) + u32(root) + u32(0);
+    ++num_trees_;
+  }
+
+  [[nodiscard]] std::string str() const {
+    auto out = std::string("\x7fKDT") + u32(decision_tree_file::version)
+               + u32(strings_.size()) + u32(offsets_.size())
+               + u32(num_trees_);
+    for (auto const &s : strings_) {
+      out += u32(s.size()) + s;
+    }
+    out += u32(nodes_.size());
+    for (auto offset : offsets_) {
+      out += u32(offset);
+    }
+    out += nodes_ + u32(0) + trees_;
+    return out;
+  }
+
+  static std::string u32(uint32_t v) {
+    auto out = std::string{};
+    for (int i = 0; i < 4; ++i) {
+      out.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+    }
+    return out;
+  }
+
+private:
+  std::vector<std::string> strings_;
+  std::vector<uint32_t> offsets_;
+  std::string nodes_;
+  std::string trees_;
+  uint32_t num_trees_ = 0;
+};
+
+std::string write_file(std::string const &contents) {
+  auto path = std::string(std::tmpnam(nullptr));
+  std::ofstream(path, std::ios::binary) << contents;
+  return path;
+}
+
+/*
+ * "dt" switches on a boolean, with both cases leading to the same leaf; "fn"
+ * always fails.
+ */
+std::string example() {
+  auto w = dt_writer{};
+
+  auto fail = w.node(std::string(1, '\0'));
+  auto leaf = w.node(
+      std::string(1, '\1') + dt_writer::u32(7) + dt_writer::u32(1)
+      + dt_writer::u32(1) + dt_writer::u32(w.string("1"))
+      + dt_writer::u32(w.string("BOOL.Bool")));
+
+  auto switch_lit = std::string(1, '\4') + dt_writer::u32(1)
+                    + dt_writer::u32(w.string("1"))
+                    + dt_writer::u32(w.string("BOOL.Bool")) + dt_writer::u32(1)
+                    + dt_writer::u32(2);
+  for (auto const *value : {"1", "0"}) {
+    switch_lit += dt_writer::u32(w.string(value)) + dt_writer::u32(leaf)
+                  + dt_writer::u32(0);
+  }
+  switch_lit += dt_writer::u32(0xffffffff);
+
+  w.tree("dt", w.node(switch_lit));
+  w.tree("fn", fail);
+  return w.str();
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(DecisionTreeFile)
+
+BOOST_AUTO_TEST_CASE(parse) {
+  auto path = write_file(example());
+  auto file = decision_tree_file(path);
+  std::remove(path.c_str());
+
+  auto ctx = llvm::LLVMContext{};
+  auto mod = llvm::Module("test", ctx);
+
+  BOOST_CHECK(file.contains("dt"));
+  BOOST_CHECK(file.contains("fn"));
+  BOOST_CHECK(!file.contains("dt-search"));
+
+  BOOST_CHECK_EQUAL(file.parse(&mod, "fn", {}, {}), fail_node::get());
+
+  auto *root = dynamic_cast<switch_node *>(file.parse(&mod, "dt", {}, {}));
+  BOOST_REQUIRE(root);
+
+  auto const &cases = root->get_cases();
+  BOOST_REQUIRE_EQUAL(cases.size(), 2);
+  BOOST_CHECK_EQUAL(cases[0].get_literal().getZExtValue(), 1);
+  BOOST_CHECK_EQUAL(cases[1].get_literal().getZExtValue(), 0);
+  BOOST_CHECK_EQUAL(cases[0].get_child(), cases[1].get_child());
+
+  auto *leaf = dynamic_cast<leaf_node *>(cases[0].get_child());
+  BOOST_REQUIRE(leaf);
+  BOOST_CHECK_EQUAL(leaf->get_bindings().size(), 1);
+
+  // Each parse creates a fresh tree.
+  auto *again = dynamic_cast<switch_node *>(file.parse(&mod, "dt", {}, {}));
+  BOOST_REQUIRE(again);
+  BOOST_CHECK_NE(again->get_cases()[0].get_child(), cases[0].get_child());
+}
+
+BOOST_AUTO_TEST_CASE(missing_tree) {
+  auto path = write_file(example());
+  auto file = decision_tree_file(path);
+  std::remove(path.c_str());
+
+  auto ctx = llvm::LLVMContext{};
+  auto mod = llvm::Module("test", ctx);
+
+  BOOST_CHECK_THROW(file.parse(&mod, "dt_12", {}, {}), std::runtime_error);
+  BOOST_CHECK_THROW(
+      file.parse_special(&mod, "dt", {}, {}), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(malformed) {
+  auto contents = example();
+
+  auto bad_magic = contents;
+  bad_magic[1] = 'X';
+
+  auto bad_version = contents;
+  bad_version[4] = 2;
+
+  for (auto const &bad :
+       {bad_magic, bad_version, contents.substr(0, contents.size() - 1),
+        std::string{}}) {
+    auto path = write_file(bad);
+    BOOST_CHECK_THROW(decision_tree_file{path}, std::runtime_error);
+    std::remove(path.c_str());
+  }
+
+  BOOST_CHECK_THROW(
+      decision_tree_file{"/nonexistent/decision_trees.bin"},
+      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,78 @@
+#include <boost/test/unit_test.hpp>
+
+#include <kllvm/ast/definition_index.h>
+#include <kllvm/parser/KOREParser.h>
+
+#include <cstdio>
+#include <fstream>
+
+using namespace kllvm;
+
+namespace {
+
+ptr<kore_definition> parse_definition() {
+  auto parser = parser::kore_parser::from_string(R"(
+    []
+    module TEST
+      sort SortK{} []
+      sort SortKItem{} []
+      sort SortFoo{} []
+      symbol Lblfoo{}() : SortFoo{} [constructor{}()]
+      symbol Lblbar{}(SortFoo{}) : SortFoo{} [function{}()]
+      axiom{R} \equals{SortFoo{}, R}(Lblbar{}(X : SortFoo{}), Lblfoo{}())
+        [label{}("bar-rule")]
+      axiom{R} \equals{SortFoo{}, R}(Lblbar{}(Lblfoo{}()), Lblfoo{}())
+        [label{}("bar-foo-rule")]
+    endmodule []
+  )");
+
+  auto definition = parser->definition();
+  definition->preprocess();
+  return definition;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(DefinitionIndex)
+
+BOOST_AUTO_TEST_CASE(build) {
+  auto definition = parse_definition();
+  auto index = definition_index::build(*definition);
+
+  for (auto *axiom : definition->get_axioms()) {
+    auto label = axiom->attributes().get_string(attribute_set::key::Label);
+    BOOST_CHECK_EQUAL(
+        *index.get_ordinal_for_label(label), axiom->get_ordinal());
+  }
+  BOOST_CHECK(!index.get_ordinal_for_label("missing-rule"));
+
+  for (auto const &[tag, symbol] : definition->get_symbols()) {
+    BOOST_CHECK_EQUAL(*index.get_tag_for_symbol(ast_to_string(*symbol)), tag);
+  }
+  BOOST_CHECK(!index.get_tag_for_symbol("Lblbaz{}"));
+}
+
+BOOST_AUTO_TEST_CASE(round_trip) {
+  auto definition = parse_definition();
+  auto index = definition_index::build(*definition);
+
+  auto path = std::string("definition_index_test.index");
+  index.write(path);
+  auto loaded = definition_index::load(path);
+  std::remove(path.c_str());
+
+  BOOST_CHECK(loaded.get_label_ordinals() == index.get_label_ordinals());
+  BOOST_CHECK(loaded.get_symbol_tags() == index.get_symbol_tags());
+}
+
+BOOST_AUTO_TEST_CASE(bad_magic) {
+  auto path = std::string("definition_index_bad.index");
+  {
+    auto os = std::ofstream(path, std::ios::binary);
+    os << "not an index";
+  }
+  BOOST_CHECK_THROW(definition_index::load(path), std::runtime_error);
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
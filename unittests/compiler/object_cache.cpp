@@ -0,0 +1,99 @@
+#include <boost/test/unit_test.hpp>
+
+#include <kllvm/codegen/ObjectCache.h>
+
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/TargetSelect.h>
+
+#include <memory>
+#include <string>
+
+using namespace kllvm;
+
+namespace {
+
+/*
+ * A module with a number of small functions; the function named by `changed`
+ * (if any) returns a different constant to the others.
+ */
+std::unique_ptr<llvm::Module>
+make_module(llvm::LLVMContext &ctx, std::string const &changed = "") {
+  auto mod = std::make_unique<llvm::Module>("definition", ctx);
+  auto *i64_ty = llvm::Type::getInt64Ty(ctx);
+  auto *fn_ty = llvm::FunctionType::get(i64_ty, {i64_ty}, false);
+
+  for (int i = 0; i < 32; ++i) {
+    auto name = "eval_" + std::to_string(i);
+    auto *fn = llvm::Function::Create(
+        fn_ty, llvm::GlobalValue::ExternalLinkage, name, mod.get());
+
+    auto builder = llvm::IRBuilder<>(llvm::BasicBlock::Create(ctx, "", fn));
+    auto value = name == changed ? 1000 : i;
+    builder.CreateRet(builder.CreateAdd(
+        fn->getArg(0), llvm::ConstantInt::get(i64_ty, value)));
+  }
+
+  return mod;
+}
+
+std::string make_cache_dir() {
+  auto path = llvm::SmallString<128>{};
+  llvm::sys::fs::createUniqueDirectory("object-cache", path);
+  return path.str().str();
+}
+
+struct init_targets {
+  init_targets() {
+    llvm::InitializeAllTargetInfos();
+    llvm::InitializeAllTargets();
+    llvm::InitializeAllTargetMCs();
+    llvm::InitializeAllAsmPrinters();
+  }
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(ObjectCache, init_targets)
+
+BOOST_AUTO_TEST_CASE(reuse) {
+  auto dir = make_cache_dir();
+  auto ctx = llvm::LLVMContext{};
+
+  auto first = object_cache(dir);
+  auto objects = first.get_objects(make_module(ctx), 8);
+  BOOST_CHECK_EQUAL(first.get_stats().hits, 0);
+  BOOST_CHECK_EQUAL(first.get_stats().misses, objects.size());
+  for (auto const &object : objects) {
+    BOOST_CHECK(llvm::sys::fs::exists(object));
+  }
+
+  auto second = object_cache(dir);
+  auto again = second.get_objects(make_module(ctx), 8);
+  BOOST_CHECK_EQUAL(second.get_stats().hits, objects.size());
+  BOOST_CHECK_EQUAL(second.get_stats().misses, 0);
+  BOOST_CHECK(again == objects);
+
+  llvm::sys::fs::remove_directories(dir);
+}
+
+BOOST_AUTO_TEST_CASE(partial_rebuild) {
+  auto dir = make_cache_dir();
+  auto ctx = llvm::LLVMContext{};
+
+  auto first = object_cache(dir);
+  auto objects = first.get_objects(make_module(ctx), 8);
+
+  // Only the partition containing the changed function is compiled again.
+  auto second = object_cache(dir);
+  auto changed = second.get_objects(make_module(ctx, "eval_7"), 8);
+  BOOST_CHECK_EQUAL(changed.size(), objects.size());
+  BOOST_CHECK_EQUAL(second.get_stats().misses, 1);
+  BOOST_CHECK_EQUAL(second.get_stats().hits, objects.size() - 1);
+
+  llvm::sys::fs::remove_directories(dir);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,209 @@
+#include <boost/test/unit_test.hpp>
+
+#include <kllvm/binary/deserializer.h>
+#include <kllvm/binary/serializer.h>
+#include <kllvm/parser/KOREParser.h>
+
+#include <string>
+
+using namespace kllvm;
+
+namespace {
+
+sptr<kore_pattern> parse_pattern(std::string const &text) {
+  return parser::kore_parser::from_string(text)->pattern();
+}
+
+/*
+ * Build a concrete symbol with the given number of argument sorts, as it would
+ * appear in the symbol table of a preprocessed definition.
+ */
+ptr<kore_symbol> make_symbol(
+    std::string const &name, std::vector<std::string> const &formals,
+    size_t arity) {
+  auto symbol = kore_symbol::create(name);
+  for (auto const &formal : formals) {
+    symbol->add_formal_argument(kore_composite_sort::create(formal));
+  }
+  for (size_t i = 0; i < arity; ++i) {
+    symbol->add_argument(kore_composite_sort::create("SortInt"));
+  }
+  return symbol;
+}
+
+void emit_fragment(serializer &s, uint64_t key, symbol_fragment const &frag) {
+  s.emit_fragment(key, frag.bytes, frag.name_begin, frag.name_end);
+}
+
+void emit_injection(
+    serializer &s, uint64_t key, symbol_fragment const &frag,
+    std::string const &target) {
+  auto bytes = std::string_view(frag.bytes);
+  s.emit_sorts(bytes.substr(0, frag.symbol_begin));
+  kore_composite_sort::create(target)->serialize_to(s);
+  s.emit_fragment(
+      key, bytes.substr(frag.symbol_begin), frag.name_begin - frag.symbol_begin,
+      frag.name_end - frag.symbol_begin);
+}
+
+void emit_token(serializer &s, std::string const &value) {
+  parse_pattern(R"(\dv{SortInt{}}(")" + value + R"("))")->serialize_to(s);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(SymbolFragment)
+
+BOOST_AUTO_TEST_CASE(matches_ast) {
+  auto expected = parse_pattern(
+      R"(Lblfoo{}(Lblfoo{}(\dv{SortInt{}}("1"), \dv{SortInt{}}("2")), )"
+      R"(\dv{SortInt{}}("3")))");
+
+  auto foo = encode_symbol_fragment(*make_symbol("Lblfoo", {}, 2));
+
+  for (auto flags : {serializer::NONE, serializer::NoIntern}) {
+    auto s = serializer(flags);
+    emit_token(s, "1");
+    emit_token(s, "2");
+    emit_fragment(s, 3, foo);
+    emit_token(s, "3");
+    emit_fragment(s, 3, foo);
+
+    auto data = s.byte_string();
+    auto result = deserialize_pattern(data.begin(), data.end());
+    BOOST_CHECK_EQUAL(ast_to_string(*result), ast_to_string(*expected));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(interned_by_key) {
+  auto foo = encode_symbol_fragment(*make_symbol("Lblfoo", {}, 0));
+
+  auto interned = serializer();
+  emit_fragment(interned, 0, foo);
+  auto first_size = interned.data().size();
+  emit_fragment(interned, 0, foo);
+
+  auto plain = serializer(serializer::NoIntern);
+  emit_fragment(plain, 0, foo);
+  emit_fragment(plain, 0, foo);
+
+  // The second occurrence should be a backreference rather than a copy of the
+  // whole fragment.
+  BOOST_CHECK_LT(interned.data().size() - first_size, foo.bytes.size());
+  BOOST_CHECK_LT(interned.data().size(), plain.data().size());
+}
+
+BOOST_AUTO_TEST_CASE(injection) {
+  auto expected = parse_pattern(
+      R"(inj{SortInt{}, SortKItem{}}(\dv{SortInt{}}("1")))");
+
+  auto inj = encode_symbol_fragment(
+      *make_symbol("inj", {"SortInt", "SortKItem"}, 1));
+  BOOST_CHECK(inj.is_injection);
+
+  for (auto flags : {serializer::NONE, serializer::NoIntern}) {
+    auto s = serializer(flags);
+    emit_token(s, "1");
+    emit_injection(s, 7, inj, "SortKItem");
+
+    auto data = s.byte_string();
+    auto result = deserialize_pattern(data.begin(), data.end());
+    BOOST_CHECK_EQUAL(ast_to_string(*result), ast_to_string(*expected));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(parametric_sorts) {
+  auto expected = parse_pattern(
+      R"(Lblbar{SortList{SortInt{}}, S}(\dv{SortInt{}}("1")))");
+
+  auto symbol = kore_symbol::create("Lblbar");
+  auto list = kore_composite_sort::create("SortList");
+  list->add_argument(kore_composite_sort::create("SortInt"));
+  symbol->add_formal_argument(list);
+  symbol->add_formal_argument(kore_sort_variable::create("S"));
+  symbol->add_argument(kore_composite_sort::create("SortInt"));
+  auto bar = encode_symbol_fragment(*symbol);
+
+  auto s = serializer();
+  emit_token(s, "1");
+  auto bytes = std::string_view(bar.bytes);
+  s.emit_sorts(bytes.substr(0, bar.symbol_begin));
+  s.emit_fragment(
+      2, bytes.substr(bar.symbol_begin), bar.name_begin - bar.symbol_begin,
+      bar.name_end - bar.symbol_begin);
+
+  auto data = s.byte_string();
+  auto result = deserialize_pattern(data.begin(), data.end());
+  BOOST_CHECK_EQUAL(ast_to_string(*result), ast_to_string(*expected));
+}
+
+/*
+ * Serializing a configuration through symbol fragments should never be larger
+ * than serializing the equivalent AST, where every sort name is interned.
+ */
+BOOST_AUTO_TEST_CASE(injection_size) {
+  auto const count = 50;
+
+  auto text = std::string("Lblfoo{}(");
+  for (int i = 0; i < count; ++i) {
+    text += i == 0 ? "" : ", ";
+    text += R"(inj{SortInt{}, SortKItem{}}(\dv{SortInt{}}(")";
+    text += std::to_string(i) + R"(")))";
+  }
+  text += ")";
+  auto expected = parse_pattern(text);
+
+  auto foo = encode_symbol_fragment(*make_symbol("Lblfoo", {}, count));
+  auto inj = encode_symbol_fragment(
+      *make_symbol("inj", {"SortInt", "SortKItem"}, 1));
+
+  auto dict = stream_dictionary{};
+  auto stream_dict = stream_dictionary{};
+  auto baseline = serializer();
+  auto baseline_stream = serializer(serializer::NONE, &dict);
+  expected->serialize_to(baseline);
+  expected->serialize_to(baseline_stream);
+
+  auto fragments = serializer();
+  auto fragments_stream = serializer(serializer::NONE, &stream_dict);
+  for (auto *s : {&fragments, &fragments_stream}) {
+    for (int i = 0; i < count; ++i) {
+      emit_token(*s, std::to_string(i));
+      emit_injection(*s, 1, inj, "SortKItem");
+    }
+    emit_fragment(*s, 0, foo);
+  }
+
+  auto data = fragments.byte_string();
+  auto result = deserialize_pattern(data.begin(), data.end());
+  BOOST_CHECK_EQUAL(ast_to_string(*result), ast_to_string(*expected));
+
+  BOOST_CHECK_LE(fragments.data().size(), baseline.data().size());
+  BOOST_CHECK_LE(
+      fragments_stream.data().size(), baseline_stream.data().size());
+  BOOST_CHECK_EQUAL(stream_dict.size(), dict.size());
+}
+
+BOOST_AUTO_TEST_CASE(stream) {
+  auto expected = parse_pattern("Lblfoo{}()");
+  auto foo = encode_symbol_fragment(*make_symbol("Lblfoo", {}, 0));
+
+  auto dict = stream_dictionary{};
+  auto stream = std::string{};
+  for (int i = 0; i < 2; ++i) {
+    auto s = serializer(serializer::NONE, &dict);
+    emit_fragment(s, 5, foo);
+    s.correct_emitted_size();
+    stream += s.byte_string();
+  }
+
+  BOOST_CHECK_EQUAL(dict.find_key(5).value(), 0);
+
+  auto patterns = deserialize_pattern_stream(stream.begin(), stream.end());
+  BOOST_REQUIRE_EQUAL(patterns.size(), 2);
+  for (auto const &pattern : patterns) {
+    BOOST_CHECK_EQUAL(ast_to_string(*pattern), ast_to_string(*expected));
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,138 @@
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "runtime/alloc.h"
+#include "runtime/arena.h"
+#include "runtime/header.h"
+
+extern "C" {
+
+uint64_t contiguous_heap_size = 0;
+
+size_t get_gc_threshold() {
+  return SIZE_MAX;
+}
+
+uint32_t get_tag_for_symbol_name(char const *) {
+  return 0;
+}
+
+blockheader get_block_header_for_symbol(uint32_t) {
+  return {0};
+}
+}
+
+namespace {
+
+// Enough allocations of this size to fill several blocks.
+constexpr size_t chunk_size = 4096;
+constexpr size_t num_chunks = 1024;
+
+struct env {
+  uint64_t input;
+  uint64_t output;
+  std::vector<char *> chunks;
+};
+
+void square(void *arg) {
+  auto *e = (env *)arg;
+  e->output = e->input * e->input;
+}
+
+void fill(void *arg) {
+  auto *e = (env *)arg;
+  for (size_t i = 0; i < num_chunks; ++i) {
+    auto *chunk = (char *)kore_alloc(chunk_size);
+    memset(chunk, (int)e->input, chunk_size);
+    e->chunks.push_back(chunk);
+  }
+}
+
+void sum_squares(void *arg) {
+  auto *e = (env *)arg;
+  env left{e->input};
+  env right{e->input + 1};
+  void *task = kore_spawn(square, &left);
+  square(&right);
+  kore_join(task);
+  e->output = left.output + right.output;
+}
+
+void fail(void *) {
+  throw std::runtime_error("task failed");
+}
+
+bool is_filled(char *chunk, uint64_t value) {
+  for (size_t i = 0; i < chunk_size; ++i) {
+    if (chunk[i] != (char)value) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(TaskTest)
+
+BOOST_AUTO_TEST_CASE(results) {
+  std::vector<env> envs(100);
+  std::vector<void *> tasks;
+  for (uint64_t i = 0; i < envs.size(); ++i) {
+    envs[i].input = i;
+    tasks.push_back(kore_spawn(square, &envs[i]));
+  }
+  for (auto *task : tasks) {
+    kore_join(task);
+  }
+  for (uint64_t i = 0; i < envs.size(); ++i) {
+    BOOST_CHECK_EQUAL(envs[i].output, i * i);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(nested) {
+  env e{3};
+  kore_join(kore_spawn(sum_squares, &e));
+  BOOST_CHECK_EQUAL(e.output, 3 * 3 + 4 * 4);
+}
+
+BOOST_AUTO_TEST_CASE(allocation) {
+  // The memory allocated by the tasks belongs to the young generation of this
+  // thread once they are joined, and is not handed out again.
+  kore_alloc(chunk_size);
+  env first{1};
+  env second{2};
+  void *first_task = kore_spawn(fill, &first);
+  void *second_task = kore_spawn(fill, &second);
+  kore_join(first_task);
+  kore_join(second_task);
+
+  std::vector<char *> chunks;
+  for (size_t i = 0; i < num_chunks; ++i) {
+    auto *chunk = (char *)kore_alloc(chunk_size);
+    memset(chunk, 3, chunk_size);
+    chunks.push_back(chunk);
+  }
+
+  char young = ~youngspace_collection_id();
+  for (auto const &[e, value] :
+       {std::pair{&first, 1}, std::pair{&second, 2}}) {
+    for (auto *chunk : e->chunks) {
+      BOOST_CHECK_EQUAL(get_arena_semispace_id_of_object(chunk), young);
+      BOOST_CHECK(is_filled(chunk, value));
+    }
+  }
+  for (auto *chunk : chunks) {
+    BOOST_CHECK(is_filled(chunk, 3));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(exception) {
+  BOOST_CHECK_THROW(kore_join(kore_spawn(fail, nullptr)), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -64,6 +64,18 @@ static void set_float(floating *a, unsigned prec, unsigned exp, double val) {
   mpfr_set_d(a->f, val, MPFR_RNDN);
 }
 
+static void check_binary64(floating *result, double expected) {
+  BOOST_CHECK_EQUAL(mpfr_get_prec(result->f), 53);
+  BOOST_CHECK_EQUAL(result->exp, 11);
+  double actual = mpfr_get_d(result->f, MPFR_RNDN);
+  if (std::isnan(expected)) {
+    BOOST_CHECK(std::isnan(actual));
+  } else {
+    BOOST_CHECK_EQUAL(actual, expected);
+    BOOST_CHECK_EQUAL(std::signbit(actual), std::signbit(expected));
+  }
+}
+
 BOOST_AUTO_TEST_SUITE(FloatTest)
 
 BOOST_AUTO_TEST_CASE(ceil) {
@@ -923,4 +935,65 @@ BOOST_AUTO_TEST_CASE(rat2float) {
   BOOST_CHECK_EQUAL(mpfr_cmp(ref, result->f), 0);
 }
 
+BOOST_AUTO_TEST_CASE(binary64) {
+  double ref[] = {
+      0.0,
+      -0.0,
+      1.0,
+      -1.0,
+      0.1,
+      3.0,
+      1.0 / 3.0,
+      std::numeric_limits<double>::max(),
+      -std::numeric_limits<double>::max(),
+      std::numeric_limits<double>::min(),
+      std::numeric_limits<double>::denorm_min(),
+      1.0 / 0.0,
+      0.0 / 0.0};
+  int const n = sizeof(ref) / sizeof(ref[0]);
+  floating arr[n];
+  for (int i = 0; i < n; i++) {
+    set_float(arr + i, 53, 11, ref[i]);
+  }
+  mpz_t two;
+  mpz_init_set_ui(two, 2);
+  for (int i = 0; i < n; i++) {
+    check_binary64(hook_FLOAT_neg(arr + i), -ref[i]);
+    check_binary64(hook_FLOAT_abs(arr + i), std::fabs(ref[i]));
+    check_binary64(hook_FLOAT_ceil(arr + i), std::ceil(ref[i]));
+    check_binary64(hook_FLOAT_root(arr + i, two), std::sqrt(ref[i]));
+    for (int j = 0; j < n; j++) {
+      check_binary64(hook_FLOAT_add(arr + i, arr + j), ref[i] + ref[j]);
+      check_binary64(hook_FLOAT_sub(arr + i, arr + j), ref[i] - ref[j]);
+      check_binary64(hook_FLOAT_mul(arr + i, arr + j), ref[i] * ref[j]);
+      check_binary64(hook_FLOAT_div(arr + i, arr + j), ref[i] / ref[j]);
+      check_binary64(
+          hook_FLOAT_rem(arr + i, arr + j), std::remainder(ref[i], ref[j]));
+    }
+  }
+  mpz_clear(two);
+}
+
+BOOST_AUTO_TEST_CASE(mixed_formats) {
+  floating a[1], b[1], c[1];
+  set_float(a, 53, 11, 1.0);
+  set_float(b, 24, 8, 3.0);
+  set_float(c, 64, 15, 3.0);
+
+  // The result has the format of the first argument.
+  check_binary64(hook_FLOAT_div(a, b), 1.0 / 3.0);
+
+  floating *result = hook_FLOAT_div(c, b);
+  BOOST_CHECK_EQUAL(mpfr_get_prec(result->f), 64);
+  BOOST_CHECK_EQUAL(result->exp, 15);
+  BOOST_CHECK_EQUAL(mpfr_cmp_d(result->f, 1.0), 0);
+
+  result = hook_FLOAT_div(a, c);
+  mpfr_t ref;
+  mpfr_init2(ref, 53);
+  mpfr_set_d(ref, 1.0 / 3.0, MPFR_RNDN);
+  BOOST_CHECK_EQUAL(mpfr_cmp(ref, result->f), 0);
+  mpfr_clear(ref);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
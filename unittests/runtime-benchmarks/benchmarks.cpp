@@ -0,0 +1,473 @@
+#include <benchmark/benchmark.h>
+#include <gmp.h>
+
+#include <cstring>
+#include <limits>
+#include <map>
+#include <tuple>
+#include <string>
+#include <vector>
+
+#include "runtime/alloc.h"
+#include "runtime/arena.h"
+#include "runtime/collect.h"
+#include "runtime/header.h"
+
+// Microbenchmarks of the runtime hooks and of the garbage collector. They link
+// the runtime libraries directly, so the symbols that a kompiled definition
+// normally provides are defined below for a tiny synthetic definition:
+//
+//   tag 0: pair(K, K)    layout 1, two SYMBOL_LAYOUT children
+//   tag 1: box(Int)      layout 2, one INT_LAYOUT child
+//   tag 2: nil           a constant
+//
+// Tags from 3 upwards are handed out on demand to the symbols that the JSON
+// hooks look up by name.
+
+void *
+construct_composite_pattern(uint32_t tag, std::vector<void *> &arguments) {
+  return nullptr;
+}
+
+namespace {
+
+constexpr uint32_t pair_tag = 0;
+constexpr uint32_t box_tag = 1;
+constexpr uint32_t nil_tag = 2;
+
+layoutitem pair_args[] = {{8, SYMBOL_LAYOUT}, {16, SYMBOL_LAYOUT}};
+layoutitem box_args[] = {{8, INT_LAYOUT}};
+layout layouts[] = {{0, nullptr}, {2, pair_args}, {1, box_args}};
+
+std::map<std::string, uint32_t> &symbol_tags() {
+  static std::map<std::string, uint32_t> tags;
+  return tags;
+}
+
+} // namespace
+
+extern "C" {
+
+bool enable_mutable_bytes = false;
+bool linear_bytes = false;
+uint64_t contiguous_heap_size = 0;
+bool in_place_rewrite = false;
+
+uint32_t const FIRST_INJ_TAG = std::numeric_limits<uint32_t>::max();
+uint32_t const LAST_INJ_TAG = std::numeric_limits<uint32_t>::min();
+
+layout *get_layout_data(uint16_t layout) {
+  return &layouts[layout];
+}
+
+uint32_t get_tag_for_symbol_name(char const *name) {
+  auto &tags = symbol_tags();
+  auto [it, inserted] = tags.try_emplace(name, tags.size() + 3);
+  return it->second;
+}
+
+blockheader get_block_header_for_symbol(uint32_t tag) {
+  switch (tag) {
+  case pair_tag: return {pair_tag | (3ULL << 32) | (1ULL << LAYOUT_OFFSET)};
+  case box_tag: return {box_tag | (2ULL << 32) | (2ULL << LAYOUT_OFFSET)};
+  default: return {tag};
+  }
+}
+
+char const **get_argument_sorts_for_tag(uint32_t tag) {
+  return nullptr;
+}
+
+void print_configuration_internal(
+    writer *file, block *subject, char const *sort, bool, void *) { }
+
+size_t get_gc_threshold() {
+  return SIZE_MAX;
+}
+
+mpz_ptr move_int(mpz_t i) {
+  auto *result = (mpz_ptr)kore_alloc_integer(0);
+  *result = *i;
+  return result;
+}
+
+floating *move_float(floating *f) {
+  auto *result = (floating *)kore_alloc_floating(0);
+  *result = *f;
+  return result;
+}
+
+void init_static_objects(void);
+size_t hash_k(block *);
+bool hook_KEQUAL_eq(block *, block *);
+
+map hook_MAP_unit(void);
+map hook_MAP_update(map *, block *, block *);
+block *hook_MAP_lookup(map *, block *);
+
+list hook_LIST_push(block *, list *);
+list hook_LIST_make(mpz_t, block *);
+block *hook_LIST_get_long(list *, ssize_t);
+
+rangemap hook_RANGEMAP_unit(void);
+rangemap hook_RANGEMAP_update(rangemap *, block *, block *, block *);
+block *hook_RANGEMAP_lookup(rangemap *, block *);
+
+mpz_ptr hook_INT_add(mpz_ptr, mpz_ptr);
+string *hook_BYTES_concat(string *, string *);
+mpz_ptr hook_STRING_find(string *, string *, mpz_ptr);
+
+string *hook_JSON_json2string(block *);
+block *hook_JSON_string2json(string *);
+}
+
+namespace {
+
+// The young generation is only reclaimed by a collection, so the benchmarks
+// of hooks that allocate collect every so often, with no roots and outside
+// the timed region. Their inputs are allocated in the static arena by
+// static_inputs, so that the collections leave them in place.
+constexpr size_t collection_interval = 1 << 14;
+
+template <typename F>
+void run_collecting(benchmark::State &state, F &&body) {
+  size_t n = 0;
+  for (auto _ : state) {
+    body();
+    if (++n % collection_interval == 0) {
+      state.PauseTiming();
+      kore_collect(nullptr, 0, nullptr, true);
+      state.ResumeTiming();
+    }
+  }
+  state.PauseTiming();
+  kore_collect(nullptr, 0, nullptr, true);
+  state.ResumeTiming();
+}
+
+template <typename F>
+auto static_inputs(F &&build) {
+  kore_static_alloc_begin();
+  auto result = build();
+  kore_static_alloc_end();
+  return result;
+}
+
+block *nil() {
+  return leaf_block(nil_tag);
+}
+
+block *make_pair(block *first, block *second) {
+  auto *result = (block *)kore_alloc(3 * sizeof(void *));
+  result->h = get_block_header_for_symbol(pair_tag);
+  result->children[0] = (uint64_t *)first;
+  result->children[1] = (uint64_t *)second;
+  return result;
+}
+
+block *make_box(unsigned long value) {
+  mpz_t z;
+  mpz_init_set_ui(z, value);
+  auto *result = (block *)kore_alloc(2 * sizeof(void *));
+  result->h = get_block_header_for_symbol(box_tag);
+  result->children[0] = (uint64_t *)move_int(z);
+  return result;
+}
+
+// A complete binary tree of pairs with 2^depth - 1 nodes. Each node is
+// distinct, so that equality has to visit all of them.
+block *make_tree(int64_t depth) {
+  if (depth == 0) {
+    return nil();
+  }
+  return make_pair(make_tree(depth - 1), make_tree(depth - 1));
+}
+
+// The same tree, where both children of each node are the same term.
+block *make_shared_tree(int64_t depth) {
+  if (depth == 0) {
+    return nil();
+  }
+  auto *child = make_shared_tree(depth - 1);
+  return make_pair(child, child);
+}
+
+string *make_bytes(size_t len, char c) {
+  auto *result = (string *)kore_alloc_token(sizeof(string) + len);
+  init_with_len(result, len);
+  memset(result->data, c, len);
+  return result;
+}
+
+std::vector<block *> make_boxes(int64_t n) {
+  auto boxes = std::vector<block *>{};
+  for (int64_t i = 0; i < n; ++i) {
+    boxes.push_back(make_box(i));
+  }
+  return boxes;
+}
+
+void bm_arena_alloc(benchmark::State &state) {
+  REGISTER_ARENA(bench_arena, 64);
+  auto size = state.range(0);
+  size_t n = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(kore_arena_alloc(&bench_arena, size));
+    if (++n % collection_interval == 0) {
+      arena_reset(&bench_arena);
+    }
+  }
+  arena_reset(&bench_arena);
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(bm_arena_alloc)->Arg(16)->Arg(24)->Arg(256);
+
+// Each collection copies a freshly allocated tree out of the young generation.
+void bm_collect(benchmark::State &state) {
+  auto depth = state.range(0);
+  for (auto _ : state) {
+    state.PauseTiming();
+    void *roots[] = {make_tree(depth)};
+    layoutitem type_info[] = {{0, SYMBOL_LAYOUT}};
+    state.ResumeTiming();
+    kore_collect(roots, 1, type_info, true);
+    benchmark::DoNotOptimize(roots[0]);
+  }
+  kore_collect(nullptr, 0, nullptr, true);
+  state.SetItemsProcessed(state.iterations() * ((1 << depth) - 1));
+}
+BENCHMARK(bm_collect)->Arg(10)->Arg(16);
+
+void bm_hash_k(benchmark::State &state) {
+  auto *term = static_inputs([&] { return make_tree(state.range(0)); });
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hash_k(term));
+  }
+}
+BENCHMARK(bm_hash_k)->Arg(4)->Arg(16);
+
+void bm_kequal_eq(benchmark::State &state) {
+  auto inputs = static_inputs([&] {
+    return std::pair{make_tree(state.range(0)), make_tree(state.range(0))};
+  });
+  auto &lhs = std::get<0>(inputs);
+  auto &rhs = std::get<1>(inputs);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hook_KEQUAL_eq(lhs, rhs));
+  }
+  state.SetItemsProcessed(state.iterations() * ((1 << state.range(0)) - 1));
+}
+BENCHMARK(bm_kequal_eq)->Arg(4)->Arg(16);
+
+// Equal terms that share their subterms, as the terms built by rewriting
+// usually do; the comparison should not depend on the size of the terms.
+void bm_kequal_eq_shared(benchmark::State &state) {
+  auto inputs = static_inputs([&] {
+    auto *child = make_shared_tree(state.range(0) - 1);
+    return std::pair{make_pair(child, child), make_pair(child, child)};
+  });
+  auto &lhs = std::get<0>(inputs);
+  auto &rhs = std::get<1>(inputs);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hook_KEQUAL_eq(lhs, rhs));
+  }
+}
+BENCHMARK(bm_kequal_eq_shared)->Arg(4)->Arg(16);
+
+map make_map(std::vector<block *> const &keys) {
+  auto result = hook_MAP_unit();
+  for (auto *key : keys) {
+    result = hook_MAP_update(&result, key, key);
+  }
+  return result;
+}
+
+void bm_map_update(benchmark::State &state) {
+  auto inputs = static_inputs([&] {
+    auto keys = make_boxes(state.range(0));
+    return std::pair{keys, make_map(keys)};
+  });
+  auto &keys = std::get<0>(inputs);
+  auto &m = std::get<1>(inputs);
+  size_t i = 0;
+  run_collecting(state, [&] {
+    auto *key = keys[i++ % keys.size()];
+    benchmark::DoNotOptimize(hook_MAP_update(&m, key, nil()));
+  });
+}
+BENCHMARK(bm_map_update)->Arg(1 << 4)->Arg(1 << 16);
+
+void bm_map_lookup(benchmark::State &state) {
+  auto inputs = static_inputs([&] {
+    auto keys = make_boxes(state.range(0));
+    return std::pair{keys, make_map(keys)};
+  });
+  auto &keys = std::get<0>(inputs);
+  auto &m = std::get<1>(inputs);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hook_MAP_lookup(&m, keys[i++ % keys.size()]));
+  }
+}
+BENCHMARK(bm_map_lookup)->Arg(1 << 4)->Arg(1 << 16);
+
+list make_list(int64_t n) {
+  mpz_t len;
+  mpz_init_set_si(len, n);
+  return hook_LIST_make(len, nil());
+}
+
+void bm_list_push(benchmark::State &state) {
+  auto l = static_inputs([&] { return make_list(state.range(0)); });
+  run_collecting(state, [&] {
+    benchmark::DoNotOptimize(hook_LIST_push(nil(), &l));
+  });
+}
+BENCHMARK(bm_list_push)->Arg(1 << 4)->Arg(1 << 16);
+
+void bm_list_get(benchmark::State &state) {
+  auto n = state.range(0);
+  auto l = static_inputs([&] { return make_list(n); });
+  ssize_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hook_LIST_get_long(&l, i++ % n));
+  }
+}
+BENCHMARK(bm_list_get)->Arg(1 << 4)->Arg(1 << 16);
+
+// Disjoint ranges [2i, 2i + 1) of the boxed integers.
+rangemap make_rangemap(std::vector<block *> const &bounds) {
+  auto result = hook_RANGEMAP_unit();
+  for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+    result = hook_RANGEMAP_update(&result, bounds[i], bounds[i + 1], nil());
+  }
+  return result;
+}
+
+void bm_rangemap_update(benchmark::State &state) {
+  auto inputs = static_inputs([&] {
+    auto bounds = make_boxes(2 * state.range(0));
+    return std::pair{bounds, make_rangemap(bounds)};
+  });
+  auto &bounds = std::get<0>(inputs);
+  auto &m = std::get<1>(inputs);
+  size_t i = 0;
+  run_collecting(state, [&] {
+    auto j = 2 * (i++ % (bounds.size() / 2));
+    benchmark::DoNotOptimize(
+        hook_RANGEMAP_update(&m, bounds[j], bounds[j + 1], bounds[j]));
+  });
+}
+BENCHMARK(bm_rangemap_update)->Arg(1 << 4)->Arg(1 << 14);
+
+void bm_rangemap_lookup(benchmark::State &state) {
+  auto inputs = static_inputs([&] {
+    auto bounds = make_boxes(2 * state.range(0));
+    return std::pair{bounds, make_rangemap(bounds)};
+  });
+  auto &bounds = std::get<0>(inputs);
+  auto &m = std::get<1>(inputs);
+  size_t i = 0;
+  for (auto _ : state) {
+    auto j = 2 * (i++ % (bounds.size() / 2));
+    benchmark::DoNotOptimize(hook_RANGEMAP_lookup(&m, bounds[j]));
+  }
+}
+BENCHMARK(bm_rangemap_lookup)->Arg(1 << 4)->Arg(1 << 14);
+
+// The argument is the number of bits of the operands.
+void bm_int_add(benchmark::State &state) {
+  auto inputs = static_inputs([&] {
+    mpz_t a;
+    mpz_t b;
+    mpz_init(a);
+    mpz_init(b);
+    mpz_setbit(a, state.range(0) - 1);
+    mpz_setbit(b, state.range(0) - 2);
+    return std::pair{move_int(a), move_int(b)};
+  });
+  auto &a = std::get<0>(inputs);
+  auto &b = std::get<1>(inputs);
+  run_collecting(state, [&] {
+    benchmark::DoNotOptimize(hook_INT_add(a, b));
+  });
+}
+BENCHMARK(bm_int_add)->Arg(32)->Arg(1024);
+
+void bm_bytes_concat(benchmark::State &state) {
+  auto size = state.range(0);
+  auto inputs = static_inputs(
+      [&] { return std::pair{make_bytes(size, 'a'), make_bytes(size, 'b')}; });
+  auto &a = std::get<0>(inputs);
+  auto &b = std::get<1>(inputs);
+  run_collecting(state, [&] {
+    benchmark::DoNotOptimize(hook_BYTES_concat(a, b));
+  });
+  state.SetBytesProcessed(state.iterations() * 2 * size);
+}
+BENCHMARK(bm_bytes_concat)->Arg(16)->Arg(4096);
+
+// The needle only occurs at the end of the haystack.
+void bm_string_find(benchmark::State &state) {
+  auto size = state.range(0);
+  auto inputs = static_inputs([&] {
+    auto *haystack = make_bytes(size, 'a');
+    auto *needle = make_bytes(8, 'a');
+    needle->data[7] = haystack->data[size - 1] = 'b';
+    mpz_t pos;
+    mpz_init(pos);
+    return std::tuple{haystack, needle, move_int(pos)};
+  });
+  auto &haystack = std::get<0>(inputs);
+  auto &needle = std::get<1>(inputs);
+  auto &pos = std::get<2>(inputs);
+  run_collecting(state, [&] {
+    benchmark::DoNotOptimize(hook_STRING_find(haystack, needle, pos));
+  });
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(bm_string_find)->Arg(64)->Arg(1 << 16);
+
+// An array of the given number of small objects.
+string *make_json_text(int64_t n) {
+  auto text = std::string("[");
+  for (int64_t i = 0; i < n; ++i) {
+    text += i ? "," : "";
+    text += R"({"id":)" + std::to_string(i) + R"(,"name":"item","ok":true})";
+  }
+  text += "]";
+  auto *result = make_bytes(text.size(), 0);
+  memcpy(result->data, text.data(), text.size());
+  return result;
+}
+
+void bm_json_string2json(benchmark::State &state) {
+  auto *text = static_inputs([&] { return make_json_text(state.range(0)); });
+  run_collecting(state, [&] {
+    benchmark::DoNotOptimize(hook_JSON_string2json(text));
+  });
+  state.SetBytesProcessed(state.iterations() * len(text));
+}
+BENCHMARK(bm_json_string2json)->Arg(1)->Arg(1 << 10);
+
+void bm_json_json2string(benchmark::State &state) {
+  auto *json = static_inputs(
+      [&] { return hook_JSON_string2json(make_json_text(state.range(0))); });
+  run_collecting(state, [&] {
+    benchmark::DoNotOptimize(hook_JSON_json2string(json));
+  });
+}
+BENCHMARK(bm_json_json2string)->Arg(1)->Arg(1 << 10);
+
+} // namespace
+
+int main(int argc, char **argv) {
+  init_static_objects();
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -63,7 +63,7 @@ block D1 = {{1}};
 block *DUMMY1 = &D1;
 }
 
-bool gc_enabled;
+constinit KORE_THREAD_LOCAL bool gc_enabled = false;
 size_t get_gc_threshold() {
   return SIZE_MAX;
 }
@@ -299,4 +299,29 @@ BOOST_AUTO_TEST_CASE(eq) {
   result = hook_LIST_eq(&l1, &l2);
   BOOST_CHECK(result);
 }
+
+BOOST_AUTO_TEST_CASE(long_lists) {
+  mpz_t len;
+  mpz_init_set_ui(len, 1000);
+  list l1 = hook_LIST_make(len, DUMMY0);
+  list l2 = l1.push_back(DUMMY1);
+  list l3 = l1.push_back(DUMMY0);
+
+  BOOST_CHECK(!hook_LIST_in(DUMMY1, &l1));
+  BOOST_CHECK(hook_LIST_in(DUMMY1, &l2));
+
+  BOOST_CHECK(hook_LIST_eq(&l1, &l1));
+  BOOST_CHECK(!hook_LIST_eq(&l1, &l2));
+  BOOST_CHECK(!hook_LIST_eq(&l2, &l3));
+
+  list prefix = hook_LIST_range_long(&l2, 0, 1);
+  BOOST_CHECK(hook_LIST_eq(&prefix, &l1));
+
+  list middle = hook_LIST_range_long(&l2, 500, 1);
+  BOOST_CHECK_EQUAL(middle.size(), 500U);
+  BOOST_CHECK(!hook_LIST_in(DUMMY1, &middle));
+
+  list whole = hook_LIST_range_long(&l2, 0, 0);
+  BOOST_CHECK(hook_LIST_eq(&whole, &l2));
+}
 BOOST_AUTO_TEST_SUITE_END()
@@ -320,6 +320,12 @@ BOOST_AUTO_TEST_CASE(rangemap_hook_eq) {
   map2 = hook_RANGEMAP_element(RDUMMY0, RDUMMY1, RDUMMY0);
   result = hook_RANGEMAP_eq(&map1, &map2);
   BOOST_CHECK(result);
+  auto map5 = map1;
+  result = hook_RANGEMAP_eq(&map1, &map5);
+  BOOST_CHECK(result);
+  map5 = hook_RANGEMAP_concat(&map1, &map3);
+  result = hook_RANGEMAP_eq(&map1, &map5);
+  BOOST_CHECK(!result);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,12 +3,37 @@
 #include <runtime/collections/RBTree.h>
 
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <iostream>
 
+// Allocates nodes with malloc, never frees them, and records the size of each
+// allocation before it so that nodes can be copied as the collector does.
+struct test_heap {
+  static inline size_t allocations = 0;
+
+  static void *allocate(size_t size) {
+    ++allocations;
+    auto *mem = (size_t *)malloc(sizeof(size_t) + size);
+    *mem = size;
+    return mem + 1;
+  }
+
+  template <class N>
+  static void move(N *&node) {
+    auto size = *((size_t *)node - 1);
+    auto *copy = (N *)allocate(size);
+    memcpy((void *)copy, (void *)node, size);
+    node = copy;
+  }
+};
+
+using heap_tree = rb_tree::RBTree<int, int, rb_tree::heap_policy<test_heap>>;
+
+template <class P = rb_tree::refcount_policy>
 void huge_test(std::vector<int> &v) {
-  std::vector<rb_tree::RBTree<int, int>> trees;
-  trees.push_back(rb_tree::RBTree<int, int>());
+  std::vector<rb_tree::RBTree<int, int, P>> trees;
+  trees.push_back(rb_tree::RBTree<int, int, P>());
   for (int i : v) {
     trees.push_back(trees.back().inserted(i, i + 1));
     trees.push_back(trees.back().inserted(i, i + 2));
@@ -69,6 +94,57 @@ BOOST_AUTO_TEST_CASE(hugetest) {
   huge_test(a);
   huge_test(d);
   huge_test(r);
+  huge_test<rb_tree::heap_policy<test_heap>>(a);
+  huge_test<rb_tree::heap_policy<test_heap>>(d);
+  huge_test<rb_tree::heap_policy<test_heap>>(r);
+}
+
+BOOST_AUTO_TEST_CASE(treemap_test_heap_policy) {
+  auto empty = heap_tree();
+  auto before = test_heap::allocations;
+
+  // Empty trees share their leaf, so only internal nodes are allocated.
+  auto map = empty.inserted(0, 0).inserted(1, 1);
+  BOOST_CHECK(test_heap::allocations > before);
+  before = test_heap::allocations;
+  auto other = heap_tree();
+  BOOST_CHECK(other.empty());
+  BOOST_CHECK_EQUAL(test_heap::allocations, before);
+
+  // Inserting an existing key copies only the path to it.
+  auto map2 = map.inserted(1, 2);
+  BOOST_CHECK(test_heap::allocations - before <= 2);
+  BOOST_CHECK_EQUAL(map.at(1), 1);
+  BOOST_CHECK_EQUAL(map2.at(1), 2);
+}
+
+BOOST_AUTO_TEST_CASE(treemap_test_migrate) {
+  auto map = heap_tree();
+  for (int i = 0; i < 100; i++) {
+    map = map.inserted(i, i);
+  }
+
+  int nodes = 0;
+  int data = 0;
+  map.migrate(
+      [&](auto &node) {
+        test_heap::move(node);
+        nodes++;
+      },
+      [&](std::pair<int, int> &kv) {
+        kv.second++;
+        data++;
+      });
+
+  // Every internal node has two children, each either a node or a leaf.
+  BOOST_CHECK_EQUAL(data, 100);
+  BOOST_CHECK_EQUAL(nodes, 2 * 100 + 1);
+  for (int i = 0; i < 100; i++) {
+    BOOST_CHECK_EQUAL(map.at(i), i + 1);
+  }
+  map.assert_red_invariant();
+  map.assert_black_invariant();
+  map.assert_BST_invariant();
 }
 
 BOOST_AUTO_TEST_CASE(treemap_test_element) {
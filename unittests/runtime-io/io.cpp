@@ -22,6 +22,9 @@ construct_composite_pattern(uint32_t tag, std::vector<void *> &arguments) {
 extern "C" {
 
 bool enable_mutable_bytes = false;
+bool linear_bytes = false;
+uint64_t contiguous_heap_size = 0;
+bool in_place_rewrite = false;
 char kompiled_directory[] = "some/test/directory/path";
 
 #define GETTAG(symbol) "Lbl'Hash'" #symbol "{}"